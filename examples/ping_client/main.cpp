@@ -61,8 +61,8 @@ protected:
 public:
   uint8_t last_ping_hash[DEST_HASH_SIZE];
 
-  MyMesh(ripple::Radio& radio, ripple::RNG& rng, ripple::RTCClock& rtc)
-     : ripple::MeshTransportNone(radio, *new ArduinoMillis(), rng, rtc, *new StaticPoolPacketManager(16), *new SimpleMeshTables(rtc))
+  MyMesh(ripple::Radio& radio, ripple::RNG& rng, ripple::RTCClock& rtc, ripple::PacketManager& mgr, ripple::MeshTables& tables)
+     : ripple::MeshTransportNone(radio, *new ArduinoMillis(), rng, rtc, mgr, tables)
   {
     got_announce = false;
     memset(last_ping_hash, 0, DEST_HASH_SIZE);
@@ -75,7 +75,10 @@ public:
 SPIClass spi;
 StdRNG fast_rng;
 SX1262 radio = new Module(P_LORA_NSS, P_LORA_DIO_1, P_LORA_RESET, P_LORA_BUSY, spi);
-MyMesh mesh(*new RadioLibWrapper(radio, board), fast_rng, *new VolatileRTCClock());
+VolatileRTCClock rtc_clock;
+SizedPoolPacketManager<16> pkt_mgr;
+SimpleMeshTables tables(rtc_clock);
+MyMesh mesh(*new RadioLibWrapper(radio, board), fast_rng, rtc_clock, pkt_mgr, tables);
 unsigned long nextPing;
 
 void halt() {
@@ -35,8 +35,8 @@ public:
     return MeshTransportFull::onDatagramRecv(packet, packet_hash);
   }
 
-  MyMesh(ripple::Radio& radio, ripple::MillisecondClock& ms, ripple::RNG& rng, ripple::RTCClock& rtc)
-     : ripple::MeshTransportFull(radio, ms, rng, rtc, *new StaticPoolPacketManager(16), *new SimpleMeshTables(rtc))
+  MyMesh(ripple::Radio& radio, ripple::MillisecondClock& ms, ripple::RNG& rng, ripple::RTCClock& rtc, ripple::PacketManager& mgr, ripple::MeshTables& tables)
+     : ripple::MeshTransportFull(radio, ms, rng, rtc, mgr, tables)
   {
     ping_in = NULL;
   }
@@ -47,7 +47,10 @@ public:
 SPIClass spi;
 StdRNG fast_rng;
 SX1262 radio = new Module(P_LORA_NSS, P_LORA_DIO_1, P_LORA_RESET, P_LORA_BUSY, spi);
-MyMesh mesh(*new RadioLibWrapper(radio, board), *new ArduinoMillis(), fast_rng, *new VolatileRTCClock());
+VolatileRTCClock rtc_clock;
+SizedPoolPacketManager<16> pkt_mgr;
+SimpleMeshTables tables(rtc_clock);
+MyMesh mesh(*new RadioLibWrapper(radio, board), *new ArduinoMillis(), fast_rng, rtc_clock, pkt_mgr, tables);
 
 unsigned long nextAnnounce;
 
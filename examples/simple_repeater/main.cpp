@@ -7,7 +7,7 @@
 #include <helpers/CustomSX1262Wrapper.h>
 #include <helpers/ArduinoHelpers.h>
 #include <helpers/SimpleMeshTables.h>
-#include <helpers/StaticPoolPacketManager.h>
+#include <helpers/ScheduledPacketManager.h>
 #include <helpers/IdentityStore.h>
 
 /* ------------------------------ Config -------------------------------- */
@@ -16,6 +16,9 @@
 
 #define ADMIN_SECRET_KEY   "8802D56E21E4127A46AC244BA2E99A9AF8F5A90D7825CB81C10FE6AFDEE2AB55"
 
+#define TABLES_JOURNAL      "/tables.jnl"
+#define TABLES_JOURNAL_TMP  "/tables.tmp"
+
 #if defined(HELTEC_LORA_V3)
   #include <helpers/HeltecV3Board.h>
   static HeltecV3Board board;
@@ -30,6 +33,8 @@
 #define CMD_SEND_ANNOUNCE  0x03
 #define CMD_SET_CONFIG     0x04
 
+#define MAX_CONFIG_LEN     (CIPHER_BLOCK_SIZE*2)   // CMD_SET_CONFIG text, after decrypt (which pads to whole blocks)
+
 struct RepeaterStats {
   uint16_t batt_milli_volts;
   uint16_t curr_tx_queue_len;
@@ -40,12 +45,23 @@ struct RepeaterStats {
   uint32_t n_active_dest;
   uint32_t total_air_time_secs;
   uint32_t total_up_time_secs;
+  uint32_t n_tx_deferred;
+  uint32_t n_recv_errors;
+  uint32_t duty_cycle_remaining_millis;   // 0xFFFFFFFF if no duty cycle limit
+  uint32_t n_tx_duty_dropped;
+  uint32_t n_verify_saved;
+  uint32_t n_expired;
+  uint32_t n_failovers;
 };
 
 class MyMesh : public ripple::MeshTransportFull {
   ripple::Destination* request_in;
   RadioLibWrapper* my_radio;
-  float airtime_factor;
+  SimpleMeshTables* my_tables;
+  fs::FS* _fs;
+  File journal;
+  ripple::RetainedMemory* _retained;
+  bool _complete_tables;   // restored from checkpoint, so entries need completing from journal
   uint8_t admin_secret[PUB_KEY_SIZE];
 
   ripple::Packet* handleRequest(ripple::Packet* pkt, const uint8_t* packet_hash) { 
@@ -68,6 +84,13 @@ class MyMesh : public ripple::MeshTransportFull {
         stats.n_active_dest = _tables->getActiveNextHopCount(max_age_secs);
         stats.total_air_time_secs = getTotalAirTime() / 1000;
         stats.total_up_time_secs = _ms->getMillis() / 1000;
+        stats.n_tx_deferred = getNumTxDeferred();
+        stats.n_recv_errors = my_radio->getRecvErrors();
+        stats.duty_cycle_remaining_millis = getDutyCycleRemaining();
+        stats.n_tx_duty_dropped = getNumTxDutyDropped();
+        stats.n_verify_saved = getNumVerifiesSaved();
+        stats.n_expired = getNumExpired();
+        stats.n_failovers = getNumFailovers();
         return createReplySigned(packet_hash, self_id, (const uint8_t *) &stats, sizeof(stats));  // send signed reply
       }
       case CMD_SET_CLOCK: {
@@ -97,9 +120,26 @@ class MyMesh : public ripple::MeshTransportFull {
       case CMD_SET_CONFIG: {
         uint8_t temp[MAX_PACKET_PAYLOAD];
         int len = ripple::Utils::MACThenDecrypt(admin_secret, temp, &pkt->payload[1], pkt->payload_len - 1);
-        if (len >= 3 && len < 32 && memcmp(temp, "AF", 2) == 0) {
+        if (len >= 3 && len <= MAX_CONFIG_LEN && memcmp(temp, "AF", 2) == 0) {
+          temp[len] = 0;  // make it a C string
+          float airtime_factor = atof((char *) &temp[2]);
+          for (int i = 0; i < NUM_AIRTIME_CLASSES; i++) {   // same budget for all classes of traffic
+            setAirtimeBudget(i, airtime_factor, DEFAULT_AIRTIME_BURST_MILLIS);
+          }
+          return createReplySigned(packet_hash, self_id, (const uint8_t *) "OK", 2);  // send signed reply
+        } else if (len >= 3 && len <= MAX_CONFIG_LEN && memcmp(temp, "AB", 2) == 0) {
           temp[len] = 0;  // make it a C string
-          airtime_factor = atof((char *) &temp[2]);
+          const char* parts[3];
+          if (ripple::Utils::parseTextParts((char *) &temp[2], parts, 3) == 3) {   // {class},{factor},{burst-millis}
+            int airtime_class = atoi(parts[0]);
+            if (airtime_class >= 0 && airtime_class < NUM_AIRTIME_CLASSES) {
+              setAirtimeBudget(airtime_class, atof(parts[1]), atol(parts[2]));
+              return createReplySigned(packet_hash, self_id, (const uint8_t *) "OK", 2);  // send signed reply
+            }
+          }
+        } else if (len >= 3 && len <= MAX_CONFIG_LEN && memcmp(temp, "DC", 2) == 0) {
+          temp[len] = 0;  // make it a C string
+          setDutyCycle(atof((char *) &temp[2]));   // percent, 0 = no limit
           return createReplySigned(packet_hash, self_id, (const uint8_t *) "OK", 2);  // send signed reply
         } else {
           // other config vars here
@@ -115,10 +155,6 @@ class MyMesh : public ripple::MeshTransportFull {
   }
 
 protected:
-  float getAirtimeBudgetFactor() const override {
-    return airtime_factor;
-  }
-
   ripple::DispatcherAction onDatagramRecv(ripple::Packet* packet, const uint8_t* packet_hash) override {
     if (request_in->matches(packet->destination_hash)) {
       ripple::Packet* reply = handleRequest(packet, packet_hash);
@@ -131,11 +167,14 @@ protected:
   }
 
 public:
-  MyMesh(RadioLibWrapper& radio, ripple::MillisecondClock& ms, ripple::RNG& rng, ripple::RTCClock& rtc)
-     : ripple::MeshTransportFull(radio, ms, rng, rtc, *new StaticPoolPacketManager(32), *new SimpleMeshTables(rtc))
+  MyMesh(RadioLibWrapper& radio, ripple::MillisecondClock& ms, ripple::RNG& rng, ripple::RTCClock& rtc, ripple::PacketManager& mgr, SimpleMeshTables& tables)
+     : ripple::MeshTransportFull(radio, ms, rng, rtc, mgr, tables)
   {
     my_radio = &radio;
-    airtime_factor = 5.0;   // 1/6th
+    my_tables = &tables;
+    _fs = NULL;
+    _retained = NULL;
+    _complete_tables = false;
     ripple::Utils::fromHex(admin_secret, sizeof(admin_secret), ADMIN_SECRET_KEY);
   }
 
@@ -146,6 +185,81 @@ public:
     ripple::MeshTransportFull::begin();
   }
 
+  // returns true if woken from deep sleep (ie. restored from checkpoint)
+  bool restoreTables(fs::FS& fs, ripple::RetainedMemory& retained) {
+    _fs = &fs;
+    _retained = &retained;
+    if (my_tables->restoreCheckpoint(retained)) {   // waking from deep sleep, journal is already up to date
+      Serial.println("Tables restored from checkpoint");
+      journal = fs.open(TABLES_JOURNAL, "a");
+      if (journal) my_tables->setJournal(&journal);
+      _complete_tables = true;   // in loop(), once the packet which woke us is handled
+      return true;
+    }
+
+    // if power was lost during a compaction, TABLES_JOURNAL may be gone, but the new one is complete
+    const char* path = fs.exists(TABLES_JOURNAL) ? TABLES_JOURNAL : (fs.exists(TABLES_JOURNAL_TMP) ? TABLES_JOURNAL_TMP : NULL);
+    if (path) {
+      File f = fs.open(path);
+      if (f) {
+        int n = my_tables->replayJournal(f);
+        f.close();
+        Serial.printf("Tables restored, %d records\n", n);
+      }
+    }
+    compactTables();
+    return false;
+  }
+
+  // for sleeping repeaters: checkpoint the routing state, so that on wake the packet which woke us can be forwarded
+  void enterDeepSleep(uint32_t secs) {
+    my_tables->setJournal(NULL);
+    if (journal) journal.close();
+    my_tables->checkpointTo(*_retained);
+    board.enterDeepSleep(secs);
+  }
+
+  // deep sleeps if nothing is due for at least 'min_idle_secs', and no packet is being received.
+  //   (only tables are checkpointed, so not while packets are queued, or our Announce is held awaiting confirmation)
+  void sleepIfIdle(uint32_t min_idle_secs) {
+    if (_mgr->getOutboundCount() > 0 || isWaitingAnnounceConfirm()) return;
+
+    long idle_millis = (long)(getNextWakeMillis() - _ms->getMillis());
+    if (idle_millis >= (long)min_idle_secs*1000 && !my_radio->isReceiving()) {
+      enterDeepSleep(idle_millis / 1000);   // (doesn't return)
+    }
+  }
+
+  void compactTables() {
+    my_tables->setJournal(NULL);   // (flushes it)
+    if (journal) journal.close();
+
+    File f = _fs->open(TABLES_JOURNAL_TMP, "w", true);
+    if (f) {
+      my_tables->writeSnapshot(f);
+      f.close();
+      _fs->remove(TABLES_JOURNAL);
+      _fs->rename(TABLES_JOURNAL_TMP, TABLES_JOURNAL);
+    }
+    journal = _fs->open(TABLES_JOURNAL, "a");
+    if (journal) my_tables->setJournal(&journal);
+  }
+
+  void loop() {
+    ripple::MeshTransportFull::loop();
+
+    if (_complete_tables) {
+      File f = _fs->open(TABLES_JOURNAL);
+      if (f) {
+        int n = my_tables->completeFromJournal(f);
+        f.close();
+        Serial.printf("Tables completed from journal, %d entries\n", n);
+      }
+      _complete_tables = false;
+    }
+    if (_fs && my_tables->needsCompaction()) compactTables();
+  }
+
   void sendSelfAnnounce() {
     ripple::Packet* pkt = createAnnounce("repeater.request", self_id, (const uint8_t *)ANNOUNCE_DATA, strlen(ANNOUNCE_DATA));
     if (pkt) {
@@ -162,7 +276,10 @@ CustomSX1262 radio = new Module(P_LORA_NSS, P_LORA_DIO_1, P_LORA_RESET, P_LORA_B
 #else
 CustomSX1262 radio = new Module(P_LORA_NSS, P_LORA_DIO_1, P_LORA_RESET, P_LORA_BUSY);
 #endif
-MyMesh mesh(*new CustomSX1262Wrapper(radio, board), *new ArduinoMillis(), *new RadioNoiseGenerator(radio), *new VolatileRTCClock());
+VolatileRTCClock rtc_clock;
+SizedScheduledPacketManager<32> pkt_mgr;
+SimpleMeshTables tables(rtc_clock);
+MyMesh mesh(*new CustomSX1262Wrapper(radio, board), *new ArduinoMillis(), *new RadioNoiseGenerator(radio), rtc_clock, pkt_mgr, tables);
 
 void halt() {
   while (1) ;
@@ -200,12 +317,22 @@ void setup() {
     ripple::Utils::printHex(Serial, dest.hash, DEST_HASH_SIZE); Serial.println();
   }
 
+  static ESP32RetainedMemory retained;
+  bool woken = mesh.restoreTables(SPIFFS, retained);
   mesh.begin();
 
-  // send out initial Announce to the mesh
-  mesh.sendSelfAnnounce();
+  if (!woken) {
+    // send out initial Announce to the mesh
+    mesh.sendSelfAnnounce();
+  }
 }
 
 void loop() {
   mesh.loop();
+#ifdef LOW_POWER_LOOP
+  #ifdef DEEP_SLEEP_IDLE_SECS
+  mesh.sleepIfIdle(DEEP_SLEEP_IDLE_SECS);   // deep sleep until next scheduled send/timeout, or a packet is received
+  #endif
+  mesh.waitForNextEvent();   // light-sleep until next scheduled send/timeout, or radio interrupt
+#endif
 }
@@ -8,6 +8,7 @@
 #include <helpers/ArduinoHelpers.h>
 #include <helpers/SimpleMeshTables.h>
 #include <helpers/StaticPoolPacketManager.h>
+#include <helpers/SharedSecretCache.h>
 
 /* ---------------------------------- CONFIGURATION ------------------------------------- */
 
@@ -35,6 +36,7 @@
 /* -------------------------------------------------------------------------------------- */
 
 #define MAX_CONTACTS  1
+#define MAX_SECRETS   4   // shared secrets to keep (calculated on first use)
 
 #define FROM_HASH_LEN  8  // how many bytes to truncate the hash of sender pub_key
 #define MAX_TEXT_LEN    (13*CIPHER_BLOCK_SIZE)  // must be LESS than (MAX_PACKET_PAYLOAD - FROM_HASH_LEN - 4 - CIPHER_MAC_SIZE - 1)
@@ -42,7 +44,6 @@
 struct ContactInfo {
   ripple::Identity id;
   const char* name;
-  uint8_t shared_secret[PUB_KEY_SIZE];
 };
 
 class MyMesh : public ripple::MeshTransportNone {
@@ -50,14 +51,13 @@ public:
   ripple::LocalIdentity self_id;
   ContactInfo contacts[MAX_CONTACTS];
   int num_contacts;
+  SharedSecretCache<MAX_SECRETS> secrets;
 
   void addContact(const char* name, const ripple::Identity& id) {
     if (num_contacts < MAX_CONTACTS) {
       contacts[num_contacts].id = id;
       contacts[num_contacts].name = name;
-      // only need to calculate the shared_secret once, for better performance
-      self_id.calcSharedSecret(contacts[num_contacts].shared_secret, id);
-      num_contacts++;
+      num_contacts++;   // shared_secret is calculated when first needed
     }
   }
 
@@ -103,7 +103,7 @@ protected:
           int ofs = FROM_HASH_LEN;  // have already processed from_hash above
 
           char text[4+MAX_TEXT_LEN+1];
-          int len = ripple::Utils::MACThenDecrypt(contacts[i].shared_secret, (uint8_t*) text, &packet->payload[ofs], packet->payload_len - ofs);
+          int len = ripple::Utils::MACThenDecrypt(secrets.getSecret(contacts[i].id), (uint8_t*) text, &packet->payload[ofs], packet->payload_len - ofs);
           if (len == 0) {
             Serial.println("MSG -> forged message received!");
           } else {
@@ -164,8 +164,8 @@ public:
   uint8_t last_packet_hash[DEST_HASH_SIZE];
 #endif
 
-  MyMesh(ripple::Radio& radio, ripple::RNG& rng, ripple::RTCClock& rtc)
-     : ripple::MeshTransportNone(radio, *new ArduinoMillis(), rng, rtc, *new StaticPoolPacketManager(16), *new SimpleMeshTables(rtc))
+  MyMesh(ripple::Radio& radio, ripple::RNG& rng, ripple::RTCClock& rtc, ripple::PacketManager& mgr, ripple::MeshTables& tables)
+     : ripple::MeshTransportNone(radio, *new ArduinoMillis(), rng, rtc, mgr, tables), secrets(self_id)
   {
     num_contacts = 0;
   }
@@ -184,7 +184,7 @@ public:
     int len = 0;
     calcSenderHash(&payload[len], self_id); len += FROM_HASH_LEN;
 
-    len += ripple::Utils::encryptThenMAC(recipient.shared_secret, &payload[len], temp, 4 + text_len);
+    len += ripple::Utils::encryptThenMAC(secrets.getSecret(recipient.id), &payload[len], temp, 4 + text_len);
     // encrypted_len will be (multiple of the CIPHER_BLOCK_SIZE) + CIPHER_MAC_SIZE
 
     ripple::Packet* pkt = createDatagram(&dest, payload, len, true);
@@ -211,7 +211,10 @@ public:
 SPIClass spi;
 StdRNG fast_rng;
 SX1262 radio = new Module(P_LORA_NSS, P_LORA_DIO_1, P_LORA_RESET, P_LORA_BUSY, spi);
-MyMesh mesh(*new RadioLibWrapper(radio, board), fast_rng, *new VolatileRTCClock());
+VolatileRTCClock rtc_clock;
+SizedPoolPacketManager<16> pkt_mgr;
+SimpleMeshTables tables(rtc_clock);
+MyMesh mesh(*new RadioLibWrapper(radio, board), fast_rng, rtc_clock, pkt_mgr, tables);
 
 void halt() {
   while (1) ;
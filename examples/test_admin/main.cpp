@@ -44,6 +44,13 @@ struct RepeaterStats {
   uint32_t n_active_dest;
   uint32_t total_air_time_secs;
   uint32_t total_up_time_secs;
+  uint32_t n_tx_deferred;
+  uint32_t n_recv_errors;
+  uint32_t duty_cycle_remaining_millis;   // 0xFFFFFFFF if no duty cycle limit
+  uint32_t n_tx_duty_dropped;
+  uint32_t n_verify_saved;
+  uint32_t n_expired;
+  uint32_t n_failovers;
 };
 
 class MyMesh : public ripple::MeshTransportNone {
@@ -85,6 +92,15 @@ protected:
       Serial.printf("  num active destinations: %d  (in past hour)\n", stats.n_active_dest);
       Serial.printf("  air time (secs): %d\n", stats.total_air_time_secs);
       Serial.printf("  up time (secs): %d\n", stats.total_up_time_secs);
+      Serial.printf("  tx deferred (channel busy): %d\n", stats.n_tx_deferred);
+      Serial.printf("  recv errors (collisions): %d\n", stats.n_recv_errors);
+      if (stats.duty_cycle_remaining_millis != 0xFFFFFFFF) {
+        Serial.printf("  duty cycle remaining: %d ms\n", stats.duty_cycle_remaining_millis);
+      }
+      Serial.printf("  tx dropped (duty cycle): %d\n", stats.n_tx_duty_dropped);
+      Serial.printf("  announce verifies saved: %d\n", stats.n_verify_saved);
+      Serial.printf("  paths expired: %d\n", stats.n_expired);
+      Serial.printf("  next-hop failovers: %d\n", stats.n_failovers);
     } else if (memcmp(packet->destination_hash, set_packet_hash, DEST_HASH_SIZE) == 0) {   // got an SET_* reply from repeater
       char tmp[MAX_PACKET_PAYLOAD];
       memcpy(tmp, reply, reply_len);
@@ -98,8 +114,8 @@ protected:
 public:
   uint8_t admin_secret[PUB_KEY_SIZE];
 
-  MyMesh(ripple::Radio& radio, ripple::RNG& rng, ripple::RTCClock& rtc)
-     : ripple::MeshTransportNone(radio, *new ArduinoMillis(), rng, rtc, *new StaticPoolPacketManager(16), *new SimpleMeshTables(rtc))
+  MyMesh(ripple::Radio& radio, ripple::RNG& rng, ripple::RTCClock& rtc, ripple::PacketManager& mgr, ripple::MeshTables& tables)
+     : ripple::MeshTransportNone(radio, *new ArduinoMillis(), rng, rtc, mgr, tables)
   {
     ripple::Utils::fromHex(admin_secret, sizeof(admin_secret), ADMIN_SECRET_KEY);
   }
@@ -134,10 +150,7 @@ public:
     return pkt;
   }
 
-  ripple::Packet* createSetAirtimeFactorRequest(float airtime_factor) {
-    char payload[32];
-    sprintf(payload, "AF%f", airtime_factor);
-
+  ripple::Packet* createSetConfigRequest(const char* payload) {
     uint8_t enc_payload[CIPHER_BLOCK_SIZE*2+CIPHER_MAC_SIZE+1];
     enc_payload[0] = CMD_SET_CONFIG;
     int enc_len = ripple::Utils::encryptThenMAC(admin_secret, &enc_payload[1], (const uint8_t *)payload, strlen(payload));
@@ -164,8 +177,17 @@ public:
       uint32_t timestamp = atol(&command[9]);
       return createSetClockRequest(timestamp);
     } else if (memcmp(command, "set AF=", 7) == 0) {
-      float factor = atof(&command[7]);
-      return createSetAirtimeFactorRequest(factor);
+      char payload[32];
+      snprintf(payload, sizeof(payload), "AF%f", atof(&command[7]));
+      return createSetConfigRequest(payload);
+    } else if (memcmp(command, "set DC=", 7) == 0) {
+      char payload[32];
+      snprintf(payload, sizeof(payload), "DC%f", atof(&command[7]));
+      return createSetConfigRequest(payload);
+    } else if (memcmp(command, "set AB=", 7) == 0 && strlen(&command[7]) <= CIPHER_BLOCK_SIZE*2 - 2) {   // repeater accepts at most two blocks
+      char payload[CIPHER_BLOCK_SIZE*2 + 1];
+      sprintf(payload, "AB%s", &command[7]);
+      return createSetConfigRequest(payload);
     } else if (strcmp(command, "ann") == 0) {
       return createAnnounceRequest();
     }
@@ -182,7 +204,10 @@ CustomSX1262 radio = new Module(P_LORA_NSS, P_LORA_DIO_1, P_LORA_RESET, P_LORA_B
 #else
 CustomSX1262 radio = new Module(P_LORA_NSS, P_LORA_DIO_1, P_LORA_RESET, P_LORA_BUSY);
 #endif
-MyMesh mesh(*new CustomSX1262Wrapper(radio, board), fast_rng, *new VolatileRTCClock());
+VolatileRTCClock rtc_clock;
+SizedPoolPacketManager<16> pkt_mgr;
+SimpleMeshTables tables(rtc_clock);
+MyMesh mesh(*new CustomSX1262Wrapper(radio, board), fast_rng, rtc_clock, pkt_mgr, tables);
 
 void halt() {
   while (1) ;
@@ -230,6 +255,8 @@ void setup() {
   Serial.println("  enter 'stats' to request repeater stats");
   Serial.println("  enter 'setclock {unix-epoch-seconds}' to set repeater's clock");
   Serial.println("  enter 'set AF={factor}' to set airtime budget factor");
+  Serial.println("  enter 'set AB={class},{factor},{burst-millis}' to set airtime budget for one class (0=replies, 1=data, 2=announces)");
+  Serial.println("  enter 'set DC={percent}' to set max duty cycle over any hour (0 = no limit)");
   Serial.println("  enter 'ann' to make repeater re-announce to mesh");
 
   ripple::Identity repeater(repeater_public);
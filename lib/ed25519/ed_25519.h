@@ -22,16 +22,70 @@
 extern "C" {
 #endif
 
+/* one fragment of a message, for the scatter-gather (_iov) variants below */
+typedef struct {
+    const unsigned char *data;
+    size_t len;
+} ed25519_iovec;
+
+/* one signature to check, for ed25519_verify_batch() */
+typedef struct {
+    const unsigned char *signature;
+    const unsigned char *public_key;
+    const ed25519_iovec *msg;
+    size_t msg_count;
+} ed25519_batch_item;
+
+/* a public key already decompressed (negated, as verify uses it), and optionally its precomputed odd multiples.
+   For repeated verifies against the same key. Opaque, see ed25519_prepare_key() */
+typedef struct {
+    unsigned long long point[20];
+} ed25519_key_point;
+
+typedef struct {
+    unsigned long long multiples[160];
+} ed25519_key_table;
+
+/* bytes of (8 byte aligned, as it holds uint64_t field limbs with the 51-bit field) scratch memory ed25519_verify_batch() needs, per item */
+#define ED25519_BATCH_SCRATCH_PER_ITEM  1792
+
 #ifndef ED25519_NO_SEED
 int ED25519_DECLSPEC ed25519_create_seed(unsigned char *seed);
 #endif
 
 void ED25519_DECLSPEC ed25519_create_keypair(unsigned char *public_key, unsigned char *private_key, const unsigned char *seed);
 void ED25519_DECLSPEC ed25519_sign(unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key, const unsigned char *private_key);
+/* verify checks SB == R + hA. If built with ED25519_COFACTORED, it checks the cofactored equation [8]SB == [8]R + [8]hA
+   (RFC 8032 5.1.7) instead, which also accepts signatures with small order components. That changes which signatures
+   a node accepts, so is a protocol change: all nodes of a mesh should be built the same way */
 int ED25519_DECLSPEC ed25519_verify(const unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key);
+
+/* same as ed25519_sign/verify, of the message made by concatenating the 'msg_count' fragments (without copying them) */
+void ED25519_DECLSPEC ed25519_sign_iov(unsigned char *signature, const ed25519_iovec *msg, size_t msg_count, const unsigned char *public_key, const unsigned char *private_key);
+int ED25519_DECLSPEC ed25519_verify_iov(const unsigned char *signature, const ed25519_iovec *msg, size_t msg_count, const unsigned char *public_key);
+
+/* decompresses 'public_key' into 'A' (so the field square root is only done once). Returns 0 if it is not a valid point,
+   and then 'A' and 'table' are unchanged. If 'table' isn't NULL, also precomputes the multiples used by verify */
+int ED25519_DECLSPEC ed25519_prepare_key(ed25519_key_point *A, ed25519_key_table *table, const unsigned char *public_key);
+
+/* same as ed25519_verify_iov, with 'public_key' already prepared by ed25519_prepare_key(). 'table' can be NULL */
+int ED25519_DECLSPEC ed25519_verify_prepared(const unsigned char *signature, const ed25519_iovec *msg, size_t msg_count, const unsigned char *public_key,
+    const ed25519_key_point *A, const ed25519_key_table *table);
+
+/* checks all 'count' signatures at once (random linear combination, one multi-scalar multiplication). 'random' is 16 bytes
+   per item, from a good RNG. If the combined check fails, each item is verified on its own, so a forgery can't hide valid ones.
+   The combined check can only be cofactored, so is only done if built with ED25519_COFACTORED. Otherwise, each item is
+   verified on its own (no faster than ed25519_verify()).
+   Gives the same results as ed25519_verify() for each item (except with negligible probability).
+   Returns 1 if all are valid. If 'valid' isn't NULL, valid[i] is set to the result for items[i] */
+int ED25519_DECLSPEC ed25519_verify_batch(const ed25519_batch_item *items, size_t count, const unsigned char *random, void *scratch, int *valid);
 void ED25519_DECLSPEC ed25519_add_scalar(unsigned char *public_key, unsigned char *private_key, const unsigned char *scalar);
 void ED25519_DECLSPEC ed25519_key_exchange(unsigned char *shared_secret, const unsigned char *public_key, const unsigned char *private_key);
 
+/* same as ed25519_key_exchange, for 'count' public keys (32 bytes each, contiguous) with the one private key. Shares the
+   field inversions between keys (Montgomery's trick), so is cheaper than one at a time */
+void ED25519_DECLSPEC ed25519_key_exchange_batch(unsigned char *shared_secrets, const unsigned char *public_keys, size_t count, const unsigned char *private_key);
+
 
 #ifdef __cplusplus
 }
@@ -1,6 +1,8 @@
 #include "fixedint.h"
 #include "fe.h"
 
+/* the 10 limb (25.5 bit) representation. fe_invert(), fe_pow22523(), fe_isnegative() and fe_isnonzero() are common to both */
+#ifndef ED25519_FE_51
 
 /*
     helper functions
@@ -361,6 +363,9 @@ void fe_frombytes(fe h, const unsigned char *s) {
 
 
 
+#endif
+
+
 void fe_invert(fe out, const fe z) {
     fe t0;
     fe t1;
@@ -521,6 +526,8 @@ int fe_isnonzero(const fe f) {
 
 
 
+#ifndef ED25519_FE_51
+
 /*
     h = f * g
     Can overlap h with f or g.
@@ -878,6 +885,9 @@ void fe_neg(fe h, const fe f) {
 }
 
 
+#endif
+
+
 void fe_pow22523(fe out, const fe z) {
     fe t0;
     fe t1;
@@ -963,6 +973,8 @@ void fe_pow22523(fe out, const fe z) {
     return;
 }
 
+#ifndef ED25519_FE_51
+
 
 /*
 h = f * f
@@ -1489,3 +1501,5 @@ void fe_tobytes(unsigned char *s, const fe h) {
     s[30] = (unsigned char) (h9 >> 10);
     s[31] = (unsigned char) (h9 >> 18);
 }
+
+#endif
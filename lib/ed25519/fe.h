@@ -4,6 +4,39 @@
 #include "fixedint.h"
 
 
+/*
+    64-bit targets (with a 64x64->128 bit multiply) use 5 limbs of 51 bits (fe_51.c), others the 10 limbs below (fe.c).
+    Define ED25519_FE_32 to force the 10 limb version.
+*/
+#if !defined(ED25519_FE_51) && !defined(ED25519_FE_32) && defined(__SIZEOF_INT128__)
+    #define ED25519_FE_51 1
+#endif
+
+
+#ifdef ED25519_FE_51
+
+/*
+    fe means field element.
+    Here the field is \Z/(2^255-19).
+    An element t, entries t[0]...t[4], represents the integer
+    t[0]+2^51 t[1]+2^102 t[2]+2^153 t[3]+2^204 t[4].
+    Each t[i] is unsigned, and kept below approx 2^52 (or 2^53 for FE_CONST values).
+*/
+
+
+typedef uint64_t fe[5];
+
+/*
+    constants are given as the 10 limbs of the 32-bit representation (below). Each pair of those is one 51 bit limb,
+    and 2p is added so that every limb is positive.
+*/
+#define FE_LIMB51(lo, hi, bias) ((uint64_t) ((int64_t) (lo) + (int64_t) (hi) * 67108864 + (int64_t) (bias)))
+#define FE_CONST(t0, t1, t2, t3, t4, t5, t6, t7, t8, t9) { \
+    FE_LIMB51(t0, t1, 0xFFFFFFFFFFFDA), FE_LIMB51(t2, t3, 0xFFFFFFFFFFFFE), FE_LIMB51(t4, t5, 0xFFFFFFFFFFFFE), \
+    FE_LIMB51(t6, t7, 0xFFFFFFFFFFFFE), FE_LIMB51(t8, t9, 0xFFFFFFFFFFFFE) }
+
+#else
+
 /*
     fe means field element.
     Here the field is \Z/(2^255-19).
@@ -15,6 +48,10 @@
 
 typedef int32_t fe[10];
 
+#define FE_CONST(t0, t1, t2, t3, t4, t5, t6, t7, t8, t9) { t0, t1, t2, t3, t4, t5, t6, t7, t8, t9 }
+
+#endif
+
 
 void fe_0(fe h);
 void fe_1(fe h);
@@ -22,7 +22,11 @@ void ge_add(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q) {
 }
 
 
-static void slide(signed char *r, const unsigned char *a) {
+/*
+signed odd digits, each in [-max, max], with zeros between
+*/
+
+static void slide(signed char *r, const unsigned char *a, int max) {
     int i;
     int b;
     int k;
@@ -35,10 +39,10 @@ static void slide(signed char *r, const unsigned char *a) {
         if (r[i]) {
             for (b = 1; b <= 6 && i + b < 256; ++b) {
                 if (r[i + b]) {
-                    if (r[i] + (r[i + b] << b) <= 15) {
+                    if (r[i] + (r[i + b] << b) <= max) {
                         r[i] += r[i + b] << b;
                         r[i + b] = 0;
-                    } else if (r[i] - (r[i + b] << b) >= -15) {
+                    } else if (r[i] - (r[i + b] << b) >= -max) {
                         r[i] -= r[i + b] << b;
 
                         for (k = i + b; k < 256; ++k) {
@@ -65,15 +69,19 @@ B is the Ed25519 base point (x,4/5) with x positive.
 */
 
 void ge_double_scalarmult_vartime(ge_p2 *r, const unsigned char *a, const ge_p3 *A, const unsigned char *b) {
-    signed char aslide[256];
-    signed char bslide[256];
     ge_cached Ai[8]; /* A,3A,5A,7A,9A,11A,13A,15A */
+    ge_p3_odd_multiples(Ai, A);
+    ge_double_scalarmult_vartime_cached(r, a, Ai, b);
+}
+
+/*
+Ai = A,3A,5A,7A,9A,11A,13A,15A
+*/
+
+void ge_p3_odd_multiples(ge_cached *Ai, const ge_p3 *A) {
     ge_p1p1 t;
     ge_p3 u;
     ge_p3 A2;
-    int i;
-    slide(aslide, a);
-    slide(bslide, b);
     ge_p3_to_cached(&Ai[0], A);
     ge_p3_dbl(&t, A);
     ge_p1p1_to_p3(&A2, &t);
@@ -98,6 +106,20 @@ void ge_double_scalarmult_vartime(ge_p2 *r, const unsigned char *a, const ge_p3
     ge_add(&t, &A2, &Ai[6]);
     ge_p1p1_to_p3(&u, &t);
     ge_p3_to_cached(&Ai[7], &u);
+}
+
+/*
+same as ge_double_scalarmult_vartime(), with A's odd multiples already calculated (by ge_p3_odd_multiples)
+*/
+
+void ge_double_scalarmult_vartime_cached(ge_p2 *r, const unsigned char *a, const ge_cached *Ai, const unsigned char *b) {
+    signed char aslide[256];
+    signed char bslide[256];
+    ge_p1p1 t;
+    ge_p3 u;
+    int i;
+    slide(aslide, a, 15);
+    slide(bslide, b, 15);
     ge_p2_0(r);
 
     for (i = 255; i >= 0; --i) {
@@ -130,13 +152,84 @@ void ge_double_scalarmult_vartime(ge_p2 *r, const unsigned char *a, const ge_p3
 }
 
 
-static const fe d = {
-    -10913610, 13857413, -15372611, 6949391, 114729, -8787816, -6275908, -3247719, -18696448, -12055116
-};
+/*
+prepares a point, and its scalar a, for ge_multi_scalarmult_vartime()
+*/
+
+void ge_msm_prepare(ge_msm_point *m, const ge_p3 *P, const unsigned char *a) {
+    ge_p1p1 t;
+    ge_p3 u;
+    ge_p3 P2;
+    int i;
+    slide(m->slide, a, 7);
+    ge_p3_to_cached(&m->Pi[0], P);
+    ge_p3_dbl(&t, P);
+    ge_p1p1_to_p3(&P2, &t);
+
+    for (i = 1; i < 4; ++i) {
+        ge_add(&t, &P2, &m->Pi[i - 1]);
+        ge_p1p1_to_p3(&u, &t);
+        ge_p3_to_cached(&m->Pi[i], &u);
+    }
+}
+
+/*
+r = b * B + sum of pts[j].a * pts[j].P   (Straus: all the points share the one chain of doublings)
+*/
+
+void ge_multi_scalarmult_vartime(ge_p2 *r, const unsigned char *b, const ge_msm_point *pts, size_t count) {
+    signed char bslide[256];
+    ge_p1p1 t;
+    ge_p3 u;
+    size_t j;
+    int i;
+    int d;
+    slide(bslide, b, 15);
+    ge_p2_0(r);
+
+    for (i = 255; i >= 0; --i) {
+        if (bslide[i]) {
+            break;
+        }
+
+        for (j = 0; j < count && !pts[j].slide[i]; ++j);
+
+        if (j < count) {
+            break;
+        }
+    }
+
+    for (; i >= 0; --i) {
+        ge_p2_dbl(&t, r);
+
+        for (j = 0; j < count; ++j) {
+            d = pts[j].slide[i];
+
+            if (d > 0) {
+                ge_p1p1_to_p3(&u, &t);
+                ge_add(&t, &u, &pts[j].Pi[d / 2]);
+            } else if (d < 0) {
+                ge_p1p1_to_p3(&u, &t);
+                ge_sub(&t, &u, &pts[j].Pi[(-d) / 2]);
+            }
+        }
+
+        if (bslide[i] > 0) {
+            ge_p1p1_to_p3(&u, &t);
+            ge_madd(&t, &u, &Bi[bslide[i] / 2]);
+        } else if (bslide[i] < 0) {
+            ge_p1p1_to_p3(&u, &t);
+            ge_msub(&t, &u, &Bi[(-bslide[i]) / 2]);
+        }
+
+        ge_p1p1_to_p2(r, &t);
+    }
+}
+
+
+static const fe d = FE_CONST(-10913610, 13857413, -15372611, 6949391, 114729, -8787816, -6275908, -3247719, -18696448, -12055116);
 
-static const fe sqrtm1 = {
-    -32595792, -7943725, 9377950, 3500415, 12389472, -272473, -25146209, -2005654, 326686, 11406482
-};
+static const fe sqrtm1 = FE_CONST(-32595792, -7943725, 9377950, 3500415, 12389472, -272473, -25146209, -2005654, 326686, 11406482);
 
 int ge_frombytes_negate_vartime(ge_p3 *h, const unsigned char *s) {
     fe u;
@@ -295,9 +388,7 @@ void ge_p3_dbl(ge_p1p1 *r, const ge_p3 *p) {
 r = p
 */
 
-static const fe d2 = {
-    -21827239, -5839606, -30745221, 13898782, 229458, 15978800, -12551817, -6495438, 29715968, 9444199
-};
+static const fe d2 = FE_CONST(-21827239, -5839606, -30745221, 13898782, 229458, 15978800, -12551817, -6495438, 29715968, 9444199);
 
 void ge_p3_to_cached(ge_cached *r, const ge_p3 *p) {
     fe_add(r->YplusX, p->Y, p->X);
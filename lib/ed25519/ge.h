@@ -2,6 +2,7 @@
 #define GE_H
 
 #include "fe.h"
+#include <stddef.h>
 
 
 /*
@@ -51,6 +52,12 @@ typedef struct {
   fe T2d;
 } ge_cached;
 
+/* one term of a multi-scalar multiplication: P,3P,5P,7P and the sliding window digits of its scalar */
+typedef struct {
+  ge_cached Pi[4];
+  signed char slide[256];
+} ge_msm_point;
+
 void ge_p3_tobytes(unsigned char *s, const ge_p3 *h);
 void ge_tobytes(unsigned char *s, const ge_p2 *h);
 int ge_frombytes_negate_vartime(ge_p3 *h, const unsigned char *s);
@@ -58,9 +65,13 @@ int ge_frombytes_negate_vartime(ge_p3 *h, const unsigned char *s);
 void ge_add(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q);
 void ge_sub(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q);
 void ge_double_scalarmult_vartime(ge_p2 *r, const unsigned char *a, const ge_p3 *A, const unsigned char *b);
+void ge_double_scalarmult_vartime_cached(ge_p2 *r, const unsigned char *a, const ge_cached *Ai, const unsigned char *b);
+void ge_p3_odd_multiples(ge_cached *Ai, const ge_p3 *A);
 void ge_madd(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q);
 void ge_msub(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q);
 void ge_scalarmult_base(ge_p3 *h, const unsigned char *a);
+void ge_msm_prepare(ge_msm_point *m, const ge_p3 *P, const unsigned char *a);
+void ge_multi_scalarmult_vartime(ge_p2 *r, const unsigned char *b, const ge_msm_point *pts, size_t count);
 
 void ge_p1p1_to_p2(ge_p2 *r, const ge_p1p1 *p);
 void ge_p1p1_to_p3(ge_p3 *r, const ge_p1p1 *p);
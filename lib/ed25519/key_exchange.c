@@ -1,21 +1,11 @@
 #include "ed_25519.h"
 #include "fe.h"
 
-void ed25519_key_exchange(unsigned char *shared_secret, const unsigned char *public_key, const unsigned char *private_key) {
-    unsigned char e[32];
-    unsigned int i;
-    
-    fe x1;
-    fe x2;
-    fe z2;
-    fe x3;
-    fe z3;
-    fe tmp0;
-    fe tmp1;
+/* number of keys ed25519_key_exchange_batch() works on at once (stack is 3 field elements per key) */
+#define KEY_EXCHANGE_BATCH_CHUNK 8
 
-    int pos;
-    unsigned int swap;
-    unsigned int b;
+static void clamp_private_key(unsigned char *e, const unsigned char *private_key) {
+    unsigned int i;
 
     /* copy the private key and make sure it's valid */
     for (i = 0; i < 32; ++i) {
@@ -25,15 +15,18 @@ void ed25519_key_exchange(unsigned char *shared_secret, const unsigned char *pub
     e[0] &= 248;
     e[31] &= 63;
     e[31] |= 64;
+}
 
-    /* unpack the public key and convert edwards to montgomery */
-    /* due to CodesInChaos: montgomeryX = (edwardsY + 1)*inverse(1 - edwardsY) mod p */
-    fe_frombytes(x1, public_key);
-    fe_1(tmp1);
-    fe_add(tmp0, x1, tmp1);
-    fe_sub(tmp1, tmp1, x1);
-    fe_invert(tmp1, tmp1);
-    fe_mul(x1, tmp0, tmp1);
+/* x2/z2 = e * x1, in projective coordinates (so without the final inversion) */
+static void montgomery_ladder(fe x2, fe z2, const fe x1, const unsigned char *e) {
+    fe x3;
+    fe z3;
+    fe tmp0;
+    fe tmp1;
+
+    int pos;
+    unsigned int swap;
+    unsigned int b;
 
     fe_1(x2);
     fe_0(z2);
@@ -72,8 +65,101 @@ void ed25519_key_exchange(unsigned char *shared_secret, const unsigned char *pub
 
     fe_cswap(x2, x3, swap);
     fe_cswap(z2, z3, swap);
+}
+
+void ed25519_key_exchange(unsigned char *shared_secret, const unsigned char *public_key, const unsigned char *private_key) {
+    unsigned char e[32];
+
+    fe x1;
+    fe x2;
+    fe z2;
+    fe tmp0;
+    fe tmp1;
+
+    clamp_private_key(e, private_key);
+
+    /* unpack the public key and convert edwards to montgomery */
+    /* due to CodesInChaos: montgomeryX = (edwardsY + 1)*inverse(1 - edwardsY) mod p */
+    fe_frombytes(x1, public_key);
+    fe_1(tmp1);
+    fe_add(tmp0, x1, tmp1);
+    fe_sub(tmp1, tmp1, x1);
+    fe_invert(tmp1, tmp1);
+    fe_mul(x1, tmp0, tmp1);
+
+    montgomery_ladder(x2, z2, x1, e);
 
     fe_invert(z2, z2);
     fe_mul(x2, x2, z2);
     fe_tobytes(shared_secret, x2);
 }
+
+/*
+inverts a[0..n-1] in place, with just one fe_invert (Montgomery's trick). Zeros stay zero, same as fe_invert()
+*/
+
+static void fe_batch_invert(fe *a, fe *tmp, size_t n) {
+    fe acc;
+    fe t;
+    size_t i;
+
+    fe_1(acc);
+    for (i = 0; i < n; ++i) {
+        fe_copy(tmp[i], acc);   /* product of all non-zero a[] before i */
+        if (fe_isnonzero(a[i])) {
+            fe_mul(acc, acc, a[i]);
+        }
+    }
+
+    fe_invert(acc, acc);
+
+    for (i = n; i-- > 0; ) {
+        if (fe_isnonzero(a[i])) {
+            fe_mul(t, acc, tmp[i]);
+            fe_mul(acc, acc, a[i]);
+            fe_copy(a[i], t);
+        }
+    }
+}
+
+void ed25519_key_exchange_batch(unsigned char *shared_secrets, const unsigned char *public_keys, size_t count, const unsigned char *private_key) {
+    unsigned char e[32];
+    fe x[KEY_EXCHANGE_BATCH_CHUNK];
+    fe z[KEY_EXCHANGE_BATCH_CHUNK];
+    fe tmp[KEY_EXCHANGE_BATCH_CHUNK];
+    fe one;
+    size_t n;
+    size_t i;
+
+    clamp_private_key(e, private_key);
+    fe_1(one);
+
+    while (count > 0) {
+        n = count < KEY_EXCHANGE_BATCH_CHUNK ? count : KEY_EXCHANGE_BATCH_CHUNK;
+
+        /* edwards to montgomery, with all the (1 - edwardsY) inverted together */
+        for (i = 0; i < n; ++i) {
+            fe_frombytes(x[i], public_keys + 32 * i);
+            fe_sub(z[i], one, x[i]);
+            fe_add(x[i], x[i], one);
+        }
+
+        fe_batch_invert(z, tmp, n);
+
+        for (i = 0; i < n; ++i) {
+            fe_mul(tmp[i], x[i], z[i]);
+            montgomery_ladder(x[i], z[i], tmp[i], e);
+        }
+
+        fe_batch_invert(z, tmp, n);
+
+        for (i = 0; i < n; ++i) {
+            fe_mul(x[i], x[i], z[i]);
+            fe_tobytes(shared_secrets + 32 * i, x[i]);
+        }
+
+        shared_secrets += 32 * n;
+        public_keys += 32 * n;
+        count -= n;
+    }
+}
@@ -5,15 +5,25 @@
 
 
 void ed25519_sign(unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key, const unsigned char *private_key) {
+    ed25519_iovec msg;
+    msg.data = message;
+    msg.len = message_len;
+    ed25519_sign_iov(signature, &msg, 1, public_key, private_key);
+}
+
+void ed25519_sign_iov(unsigned char *signature, const ed25519_iovec *msg, size_t msg_count, const unsigned char *public_key, const unsigned char *private_key) {
     sha512_context hash;
     unsigned char hram[64];
     unsigned char r[64];
     ge_p3 R;
+    size_t i;
 
 
     sha512_init(&hash);
     sha512_update(&hash, private_key + 32, 32);
-    sha512_update(&hash, message, message_len);
+    for (i = 0; i < msg_count; i++) {
+        sha512_update(&hash, msg[i].data, msg[i].len);
+    }
     sha512_final(&hash, r);
 
     sc_reduce(r);
@@ -23,7 +33,9 @@ void ed25519_sign(unsigned char *signature, const unsigned char *message, size_t
     sha512_init(&hash);
     sha512_update(&hash, signature, 32);
     sha512_update(&hash, public_key, 32);
-    sha512_update(&hash, message, message_len);
+    for (i = 0; i < msg_count; i++) {
+        sha512_update(&hash, msg[i].data, msg[i].len);
+    }
     sha512_final(&hash, hram);
 
     sc_reduce(hram);
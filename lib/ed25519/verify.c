@@ -2,6 +2,7 @@
 #include "sha512.h"
 #include "ge.h"
 #include "sc.h"
+#include <string.h>
 
 static int consttime_equal(const unsigned char *x, const unsigned char *y) {
     unsigned char r = 0;
@@ -45,33 +46,129 @@ static int consttime_equal(const unsigned char *x, const unsigned char *y) {
 }
 
 int ed25519_verify(const unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key) {
+    ed25519_iovec msg;
+    msg.data = message;
+    msg.len = message_len;
+    return ed25519_verify_iov(signature, &msg, 1, public_key);
+}
+
+#ifdef ED25519_COFACTORED
+/*
+    cofactored check, [8](R' - R) is the identity, where R' = SB - hA. Single verify must agree with ed25519_verify_batch(),
+    which can only check the cofactored equation, else an R with a small order component added could pass one and not
+    the other. Only needed when R' and R differ, so costs nothing for valid signatures. R must be canonically encoded
+*/
+static int equal_cofactored(const ge_p2 *Rcheck, const unsigned char *signature) {
+    static const unsigned char identity[32] = { 1 };
+    unsigned char bytes[32];
+    ge_p3 negR;
+    ge_p3 P;
+    ge_p2 Q;
+    ge_p1p1 t;
+    ge_cached c;
+    int i;
+
+    if (ge_frombytes_negate_vartime(&negR, signature) != 0) {
+        return 0;
+    }
+
+    ge_p3_tobytes(bytes, &negR);
+    bytes[31] ^= 0x80;
+    if (memcmp(bytes, signature, 32) != 0) {
+        return 0;
+    }
+
+    /* [8]R', the last doubling to a p3 (for ge_add), and [8](-R) */
+    Q = *Rcheck;
+    for (i = 0; i < 3; i++) {
+        ge_p2_dbl(&t, &Q);
+        if (i < 2) {
+            ge_p1p1_to_p2(&Q, &t);
+        }
+    }
+    ge_p1p1_to_p3(&P, &t);
+
+    for (i = 0; i < 3; i++) {
+        ge_p3_dbl(&t, &negR);
+        ge_p1p1_to_p3(&negR, &t);
+    }
+
+    ge_p3_to_cached(&c, &negR);
+    ge_add(&t, &P, &c);
+    ge_p1p1_to_p2(&Q, &t);
+    ge_tobytes(bytes, &Q);
+
+    return memcmp(bytes, identity, 32) == 0;
+}
+#endif
+
+/* opaque types in ed_25519.h must be big enough */
+typedef char ed25519_key_point_check[(sizeof(ed25519_key_point) >= sizeof(ge_p3)) ? 1 : -1];
+typedef char ed25519_key_table_check[(sizeof(ed25519_key_table) >= 8 * sizeof(ge_cached)) ? 1 : -1];
+
+int ed25519_verify_iov(const unsigned char *signature, const ed25519_iovec *msg, size_t msg_count, const unsigned char *public_key) {
+    ed25519_key_point A;
+
+    if (!ed25519_prepare_key(&A, NULL, public_key)) {
+        return 0;
+    }
+
+    return ed25519_verify_prepared(signature, msg, msg_count, public_key, &A, NULL);
+}
+
+int ed25519_prepare_key(ed25519_key_point *A, ed25519_key_table *table, const unsigned char *public_key) {
+    ge_p3 point;
+
+    /* decompressed to a local, so 'A' (eg. a cache slot) is left as it was if 'public_key' isn't valid */
+    if (ge_frombytes_negate_vartime(&point, public_key) != 0) {
+        return 0;
+    }
+
+    memcpy(A->point, &point, sizeof(point));
+    if (table) {
+        ge_p3_odd_multiples((ge_cached *) table->multiples, &point);
+    }
+
+    return 1;
+}
+
+int ed25519_verify_prepared(const unsigned char *signature, const ed25519_iovec *msg, size_t msg_count, const unsigned char *public_key,
+    const ed25519_key_point *A, const ed25519_key_table *table) {
     unsigned char h[64];
     unsigned char checker[32];
     sha512_context hash;
-    ge_p3 A;
     ge_p2 R;
+    size_t i;
 
     if (signature[63] & 224) {
         return 0;
     }
 
-    if (ge_frombytes_negate_vartime(&A, public_key) != 0) {
-        return 0;
-    }
-
     sha512_init(&hash);
     sha512_update(&hash, signature, 32);
     sha512_update(&hash, public_key, 32);
-    sha512_update(&hash, message, message_len);
+    for (i = 0; i < msg_count; i++) {
+        sha512_update(&hash, msg[i].data, msg[i].len);
+    }
     sha512_final(&hash, h);
     
     sc_reduce(h);
-    ge_double_scalarmult_vartime(&R, h, &A, signature + 32);
+    if (table) {
+        ge_double_scalarmult_vartime_cached(&R, h, (const ge_cached *) table->multiples, signature + 32);
+    } else {
+        ge_double_scalarmult_vartime(&R, h, (const ge_p3 *) A->point, signature + 32);
+    }
     ge_tobytes(checker, &R);
 
+#ifdef ED25519_COFACTORED
+    if (!consttime_equal(checker, signature) && !equal_cofactored(&R, signature)) {
+        return 0;
+    }
+#else
     if (!consttime_equal(checker, signature)) {
         return 0;
     }
+#endif
 
     return 1;
 }
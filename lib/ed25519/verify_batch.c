@@ -0,0 +1,118 @@
+#include "ed_25519.h"
+#include "sha512.h"
+#include "ge.h"
+#include "sc.h"
+#include <string.h>
+
+/* each item needs one prepared point for -R, and one for -A */
+typedef char ed25519_batch_scratch_check[(2 * sizeof(ge_msm_point) <= ED25519_BATCH_SCRATCH_PER_ITEM) ? 1 : -1];
+
+#ifdef ED25519_COFACTORED
+static const unsigned char identity[32] = { 1 };
+
+/*
+checks: [8] sum of z_i * (S_i B - h_i A_i - R_i) == 0, for random 128 bit z_i
+ie. [8]((sum of z_i S_i) B + sum of z_i (-R_i) + sum of (z_i h_i) (-A_i)) is the identity
+The cofactor 8 is needed, as small order components of R_i or A_i can cancel out in the sum (eg. for two odd z_i),
+so this is only used when single verify checks the same cofactored equation. (Without it, each item would need a check
+that R_i and A_i have no small order component, which costs about a scalar multiplication each, ie. more than is saved)
+*/
+
+static int verify_combined(const ed25519_batch_item *items, size_t count, const unsigned char *random, ge_msm_point *pts) {
+    unsigned char h[64];
+    unsigned char z[32];
+    unsigned char zh[32];
+    unsigned char S[32];
+    unsigned char sum_zS[32];
+    unsigned char checker[32];
+    static const unsigned char zero[32] = { 0 };
+    sha512_context hash;
+    ge_p3 A;
+    ge_p3 R;
+    ge_p2 P;
+    ge_p1p1 t;
+    size_t i;
+    size_t k;
+
+    memset(sum_zS, 0, 32);
+
+    for (i = 0; i < count; i++) {
+        const ed25519_batch_item *item = &items[i];
+
+        if (item->signature[63] & 224) {
+            return 0;
+        }
+
+        if (ge_frombytes_negate_vartime(&A, item->public_key) != 0) {
+            return 0;
+        }
+
+        if (ge_frombytes_negate_vartime(&R, item->signature) != 0) {
+            return 0;
+        }
+
+        /* single verify compares R by its bytes, so only accept the canonical encoding here */
+        ge_p3_tobytes(checker, &R);
+        checker[31] ^= 0x80;
+        if (memcmp(checker, item->signature, 32) != 0) {
+            return 0;
+        }
+
+        sha512_init(&hash);
+        sha512_update(&hash, item->signature, 32);
+        sha512_update(&hash, item->public_key, 32);
+        for (k = 0; k < item->msg_count; k++) {
+            sha512_update(&hash, item->msg[k].data, item->msg[k].len);
+        }
+        sha512_final(&hash, h);
+        sc_reduce(h);
+
+        memset(z, 0, 32);
+        memcpy(z, random + 16 * i, 16);
+        z[0] |= 1;   /* never zero */
+
+        sc_muladd(zh, z, h, zero);
+        memcpy(S, item->signature + 32, 32);
+        sc_muladd(sum_zS, z, S, sum_zS);
+
+        ge_msm_prepare(&pts[2 * i], &R, z);
+        ge_msm_prepare(&pts[2 * i + 1], &A, zh);
+    }
+
+    ge_multi_scalarmult_vartime(&P, sum_zS, pts, 2 * count);
+    for (i = 0; i < 3; i++) {
+        ge_p2_dbl(&t, &P);
+        ge_p1p1_to_p2(&P, &t);
+    }
+    ge_tobytes(checker, &P);
+
+    return memcmp(checker, identity, 32) == 0;
+}
+#endif
+
+int ed25519_verify_batch(const ed25519_batch_item *items, size_t count, const unsigned char *random, void *scratch, int *valid) {
+    size_t i;
+    int all_ok = 1;
+
+#ifdef ED25519_COFACTORED
+    if (count > 1 && verify_combined(items, count, random, (ge_msm_point *) scratch)) {
+        if (valid) {
+            for (i = 0; i < count; i++) {
+                valid[i] = 1;
+            }
+        }
+        return 1;
+    }
+#endif
+
+    /* fall back to one at a time, to find which failed */
+    for (i = 0; i < count; i++) {
+        int ok = ed25519_verify_iov(items[i].signature, items[i].msg, items[i].msg_count, items[i].public_key);
+        if (valid) {
+            valid[i] = ok;
+        }
+        all_ok &= ok;
+    }
+
+    return all_ok;
+}
@@ -0,0 +1,133 @@
+#include "CryptoProvider.h"
+#include <string.h>
+
+namespace ripple {
+
+#define SHA256_BLOCK_SIZE  64
+#define SHA256_HASH_SIZE   32
+
+// HMAC (RFC 2104) is built on the backend's plain hash, so every provider shares this part
+static void formHMACKey(uint8_t* block, const void* key, size_t key_len, uint8_t pad) {
+  if (key_len > SHA256_BLOCK_SIZE) {
+    CryptoSHA256 sha;
+    sha.update(key, key_len);
+    sha.finalize(block, SHA256_HASH_SIZE);
+    key_len = SHA256_HASH_SIZE;
+  } else {
+    memcpy(block, key, key_len);
+  }
+  memset(block + key_len, 0, SHA256_BLOCK_SIZE - key_len);
+  for (int i = 0; i < SHA256_BLOCK_SIZE; i++) {
+    block[i] ^= pad;
+  }
+}
+
+void CryptoSHA256::resetHMAC(const void* key, size_t key_len) {
+  uint8_t block[SHA256_BLOCK_SIZE];
+  formHMACKey(block, key, key_len, 0x36);
+  reset();
+  update(block, SHA256_BLOCK_SIZE);
+}
+
+void CryptoSHA256::finalizeHMAC(const void* key, size_t key_len, void* hash, size_t hash_len) {
+  uint8_t inner[SHA256_HASH_SIZE];
+  finalize(inner, SHA256_HASH_SIZE);
+
+  uint8_t block[SHA256_BLOCK_SIZE];
+  formHMACKey(block, key, key_len, 0x5C);
+  reset();
+  update(block, SHA256_BLOCK_SIZE);
+  update(inner, SHA256_HASH_SIZE);
+  finalize(hash, hash_len);
+}
+
+#if CRYPTO_PROVIDER == CRYPTO_PROVIDER_SOFTWARE
+
+CryptoSHA256::CryptoSHA256() { }
+CryptoSHA256::~CryptoSHA256() { }
+
+void CryptoSHA256::reset() { _soft.reset(); }
+void CryptoSHA256::update(const void* data, size_t len) { _soft.update(data, len); }
+void CryptoSHA256::finalize(void* hash, size_t hash_len) { _soft.finalize(hash, hash_len); }
+
+CryptoAES128::CryptoAES128() { }
+CryptoAES128::~CryptoAES128() { }
+
+bool CryptoAES128::setKey(const uint8_t* key, size_t len) { return _soft.setKey(key, len); }
+void CryptoAES128::encryptBlock(uint8_t* output, const uint8_t* input) { _soft.encryptBlock(output, input); }
+void CryptoAES128::decryptBlock(uint8_t* output, const uint8_t* input) { _soft.decryptBlock(output, input); }
+
+void CryptoAES128::encryptBlocks(uint8_t* output, const uint8_t* input, int num_blocks) {
+  for (int i = 0; i < num_blocks; i++, output += 16, input += 16) {
+    _soft.encryptBlock(output, input);
+  }
+}
+void CryptoAES128::decryptBlocks(uint8_t* output, const uint8_t* input, int num_blocks) {
+  for (int i = 0; i < num_blocks; i++, output += 16, input += 16) {
+    _soft.decryptBlock(output, input);
+  }
+}
+
+const char* getCryptoProviderName() { return "software"; }
+
+#elif CRYPTO_PROVIDER == CRYPTO_PROVIDER_ESP32
+
+// NOTE: the return codes of the mbedtls calls are ignored, as they can only fail on bad parameters.
+//   (the plain names return void on mbedtls 2.x and int on 3.x, so this also builds on both)
+
+CryptoSHA256::CryptoSHA256() {
+  mbedtls_sha256_init(&_ctx);
+  mbedtls_sha256_starts(&_ctx, 0);
+}
+CryptoSHA256::~CryptoSHA256() {
+  mbedtls_sha256_free(&_ctx);
+}
+
+void CryptoSHA256::reset() {
+  mbedtls_sha256_starts(&_ctx, 0);
+}
+void CryptoSHA256::update(const void* data, size_t len) {
+  mbedtls_sha256_update(&_ctx, (const unsigned char *) data, len);
+}
+void CryptoSHA256::finalize(void* hash, size_t hash_len) {
+  uint8_t full[SHA256_HASH_SIZE];
+  mbedtls_sha256_finish(&_ctx, full);
+  memcpy(hash, full, hash_len < SHA256_HASH_SIZE ? hash_len : SHA256_HASH_SIZE);
+}
+
+CryptoAES128::CryptoAES128() {
+  mbedtls_aes_init(&_enc);
+  mbedtls_aes_init(&_dec);
+}
+CryptoAES128::~CryptoAES128() {
+  mbedtls_aes_free(&_enc);
+  mbedtls_aes_free(&_dec);
+}
+
+bool CryptoAES128::setKey(const uint8_t* key, size_t len) {
+  if (len != 16) return false;
+  return mbedtls_aes_setkey_enc(&_enc, key, 128) == 0 && mbedtls_aes_setkey_dec(&_dec, key, 128) == 0;
+}
+void CryptoAES128::encryptBlock(uint8_t* output, const uint8_t* input) {
+  mbedtls_aes_crypt_ecb(&_enc, MBEDTLS_AES_ENCRYPT, input, output);
+}
+void CryptoAES128::decryptBlock(uint8_t* output, const uint8_t* input) {
+  mbedtls_aes_crypt_ecb(&_dec, MBEDTLS_AES_DECRYPT, input, output);
+}
+
+void CryptoAES128::encryptBlocks(uint8_t* output, const uint8_t* input, int num_blocks) {
+  for (int i = 0; i < num_blocks; i++, output += 16, input += 16) {
+    mbedtls_aes_crypt_ecb(&_enc, MBEDTLS_AES_ENCRYPT, input, output);
+  }
+}
+void CryptoAES128::decryptBlocks(uint8_t* output, const uint8_t* input, int num_blocks) {
+  for (int i = 0; i < num_blocks; i++, output += 16, input += 16) {
+    mbedtls_aes_crypt_ecb(&_dec, MBEDTLS_AES_DECRYPT, input, output);
+  }
+}
+
+const char* getCryptoProviderName() { return "esp32 (mbedtls)"; }
+
+#endif
+
+}
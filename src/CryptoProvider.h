@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Build-time selection of the SHA-256 / AES-128 implementation behind Utils and Packet.
+ * Override with -D CRYPTO_PROVIDER=CRYPTO_PROVIDER_SOFTWARE (0) to force the portable classes.
+ * The ESP32 backend is opt-in (-D CRYPTO_PROVIDER=1), as it has not yet been verified on hardware.
+ */
+#define CRYPTO_PROVIDER_SOFTWARE  0   // rweather/Crypto SHA256 and AES128 classes
+#define CRYPTO_PROVIDER_ESP32     1   // ESP-IDF mbedtls, which drives the SHA and AES peripherals
+#define CRYPTO_PROVIDER_X86       2   // SHA-NI and AES-NI, falling back to software if the CPU lacks them
+
+#ifndef CRYPTO_PROVIDER
+  #if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define CRYPTO_PROVIDER  CRYPTO_PROVIDER_X86
+  #else
+    #define CRYPTO_PROVIDER  CRYPTO_PROVIDER_SOFTWARE
+  #endif
+#endif
+
+#if CRYPTO_PROVIDER == CRYPTO_PROVIDER_ESP32
+  #include <mbedtls/sha256.h>
+  #include <mbedtls/aes.h>
+#else
+  #include <SHA256.h>
+  #include <AES.h>
+#endif
+
+namespace ripple {
+
+/**
+ * \brief  SHA-256 hash (and HMAC-SHA256), with the same call pattern as the rweather SHA256 class.
+ *       NOTE: after finalize() or finalizeHMAC(), call reset() or resetHMAC() before hashing again.
+*/
+class CryptoSHA256 {
+#if CRYPTO_PROVIDER == CRYPTO_PROVIDER_ESP32
+  mbedtls_sha256_context _ctx;
+#else
+  SHA256 _soft;
+#endif
+#if CRYPTO_PROVIDER == CRYPTO_PROVIDER_X86
+  uint32_t _state[8];
+  uint8_t  _buf[64];
+  uint32_t _buf_len;
+  uint64_t _total_len;
+  bool _hw;
+#endif
+
+public:
+  CryptoSHA256();
+  ~CryptoSHA256();
+
+  void reset();
+  void update(const void* data, size_t len);
+
+  /**
+   * \brief  writes the hash, truncated to 'hash_len' bytes (max 32)
+  */
+  void finalize(void* hash, size_t hash_len);
+
+  /**
+   * \brief  starts an HMAC-SHA256 with the given key. Then call update() and finalizeHMAC(), with the same key.
+  */
+  void resetHMAC(const void* key, size_t key_len);
+  void finalizeHMAC(const void* key, size_t key_len, void* hash, size_t hash_len);
+};
+
+/**
+ * \brief  AES-128 block cipher, with the same call pattern as the rweather AES128 class, plus multi-block
+ *       variants (which hardware backends can pipeline).
+*/
+class CryptoAES128 {
+#if CRYPTO_PROVIDER == CRYPTO_PROVIDER_ESP32
+  mbedtls_aes_context _enc, _dec;
+#else
+  AES128 _soft;
+#endif
+#if CRYPTO_PROVIDER == CRYPTO_PROVIDER_X86
+  uint8_t _enc_keys[11*16];
+  uint8_t _dec_keys[11*16];
+  bool _hw;
+#endif
+
+public:
+  CryptoAES128();
+  ~CryptoAES128();
+
+  bool setKey(const uint8_t* key, size_t len);   // only len = 16 supported
+  void encryptBlock(uint8_t* output, const uint8_t* input);
+  void decryptBlock(uint8_t* output, const uint8_t* input);
+
+  /**
+   * \brief  encrypts/decrypts 'num_blocks' consecutive 16 byte blocks, each independently (ie. ECB)
+  */
+  void encryptBlocks(uint8_t* output, const uint8_t* input, int num_blocks);
+  void decryptBlocks(uint8_t* output, const uint8_t* input, int num_blocks);
+};
+
+/**
+ * \returns  name of the backend in use (after any runtime fallback), eg. for a startup banner
+*/
+const char* getCryptoProviderName();
+
+}
@@ -0,0 +1,287 @@
+#include "CryptoProvider.h"
+
+#if CRYPTO_PROVIDER == CRYPTO_PROVIDER_X86
+
+#include <string.h>
+#include <cpuid.h>
+#include <immintrin.h>
+
+/*
+ * SHA-NI and AES-NI backend. The intrinsics are compiled per function (target attribute), so no global -msha/-maes
+ * is needed, and the CPU is checked once at runtime, with the rweather classes used if it lacks the extensions.
+ */
+
+#define TARGET_SHA  __attribute__((target("sha,sse4.1")))
+#define TARGET_AES  __attribute__((target("aes,sse4.1")))
+
+namespace ripple {
+
+#define CPU_SHA_NI   1
+#define CPU_AES_NI   2
+
+static int getCpuFeatures() {
+  static int features = -1;
+  if (features < 0) {
+    unsigned int a, b, c, d;
+    int f = 0;
+    if (__get_cpuid(1, &a, &b, &c, &d) && (c & bit_SSE4_1)) {
+      if (c & bit_AES) f |= CPU_AES_NI;
+      if (__get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & bit_SHA)) f |= CPU_SHA_NI;
+    }
+    features = f;
+  }
+  return features;
+}
+
+static const uint32_t sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// 4 rounds: adds the round constants to message words 'msg', and updates the state halves
+#define SHA_ROUNDS4(msg, i) do { \
+    __m128i t = _mm_add_epi32(msg, _mm_loadu_si128((const __m128i *) &sha256_k[(i)*4])); \
+    state1 = _mm_sha256rnds2_epu32(state1, state0, t); \
+    state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(t, 0x0E)); \
+  } while (0)
+
+// next 4 message schedule words, from the previous 16 (m0 oldest .. m3 newest), stored over m0
+#define SHA_SCHEDULE(m0, m1, m2, m3) \
+    m0 = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(m0, m1), _mm_alignr_epi8(m3, m2, 4)), m3)
+
+TARGET_SHA static void sha256BlocksNI(uint32_t state[8], const uint8_t* data, size_t num_blocks) {
+  const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+  // the instructions want the state as (A,B,E,F) and (C,D,G,H)
+  __m128i t = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[0]), 0xB1);
+  __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[4]), 0x1B);
+  __m128i state0 = _mm_alignr_epi8(t, state1, 8);
+  state1 = _mm_blend_epi16(state1, t, 0xF0);
+
+  while (num_blocks-- > 0) {
+    __m128i save0 = state0, save1 = state1;
+
+    __m128i m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 0)), bswap);
+    __m128i m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16)), bswap);
+    __m128i m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 32)), bswap);
+    __m128i m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 48)), bswap);
+
+    SHA_ROUNDS4(m0, 0);
+    SHA_ROUNDS4(m1, 1);
+    SHA_ROUNDS4(m2, 2);
+    SHA_ROUNDS4(m3, 3);
+    for (int i = 4; i < 16; i += 4) {
+      SHA_SCHEDULE(m0, m1, m2, m3); SHA_ROUNDS4(m0, i);
+      SHA_SCHEDULE(m1, m2, m3, m0); SHA_ROUNDS4(m1, i + 1);
+      SHA_SCHEDULE(m2, m3, m0, m1); SHA_ROUNDS4(m2, i + 2);
+      SHA_SCHEDULE(m3, m0, m1, m2); SHA_ROUNDS4(m3, i + 3);
+    }
+
+    state0 = _mm_add_epi32(state0, save0);
+    state1 = _mm_add_epi32(state1, save1);
+    data += 64;
+  }
+
+  // back to (A,B,C,D) and (E,F,G,H)
+  t = _mm_shuffle_epi32(state0, 0x1B);
+  state1 = _mm_shuffle_epi32(state1, 0xB1);
+  _mm_storeu_si128((__m128i *) &state[0], _mm_blend_epi16(t, state1, 0xF0));
+  _mm_storeu_si128((__m128i *) &state[4], _mm_alignr_epi8(state1, t, 8));
+}
+
+CryptoSHA256::CryptoSHA256() {
+  _hw = (getCpuFeatures() & CPU_SHA_NI) != 0;
+  reset();
+}
+CryptoSHA256::~CryptoSHA256() { }
+
+void CryptoSHA256::reset() {
+  static const uint32_t iv[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+  if (!_hw) { _soft.reset(); return; }
+
+  memcpy(_state, iv, sizeof(_state));
+  _buf_len = 0;
+  _total_len = 0;
+}
+
+void CryptoSHA256::update(const void* data, size_t len) {
+  if (!_hw) { _soft.update(data, len); return; }
+
+  const uint8_t* sp = (const uint8_t *) data;
+  _total_len += len;
+  if (_buf_len > 0) {   // top up the partial block first
+    size_t n = 64 - _buf_len;
+    if (n > len) n = len;
+    memcpy(&_buf[_buf_len], sp, n);
+    _buf_len += n; sp += n; len -= n;
+    if (_buf_len < 64) return;
+    sha256BlocksNI(_state, _buf, 1);
+    _buf_len = 0;
+  }
+  if (len >= 64) {   // whole blocks straight from the caller's buffer
+    sha256BlocksNI(_state, sp, len / 64);
+    sp += len & ~(size_t)63;
+    len &= 63;
+  }
+  memcpy(_buf, sp, len);
+  _buf_len = len;
+}
+
+void CryptoSHA256::finalize(void* hash, size_t hash_len) {
+  if (!_hw) { _soft.finalize(hash, hash_len); return; }
+
+  uint64_t bits = _total_len * 8;
+  _buf[_buf_len++] = 0x80;
+  if (_buf_len > 56) {   // no room for the length in this block
+    memset(&_buf[_buf_len], 0, 64 - _buf_len);
+    sha256BlocksNI(_state, _buf, 1);
+    _buf_len = 0;
+  }
+  memset(&_buf[_buf_len], 0, 56 - _buf_len);
+  for (int i = 0; i < 8; i++) {
+    _buf[56 + i] = (uint8_t) (bits >> (56 - 8*i));
+  }
+  sha256BlocksNI(_state, _buf, 1);
+
+  uint8_t full[32];
+  for (int i = 0; i < 8; i++) {
+    full[i*4] = (uint8_t) (_state[i] >> 24);
+    full[i*4 + 1] = (uint8_t) (_state[i] >> 16);
+    full[i*4 + 2] = (uint8_t) (_state[i] >> 8);
+    full[i*4 + 3] = (uint8_t) _state[i];
+  }
+  memcpy(hash, full, hash_len < 32 ? hash_len : 32);
+}
+
+// one step of the AES-128 key schedule, 'assist' being the aeskeygenassist of the previous round key
+TARGET_AES static inline __m128i aesExpandStep(__m128i key, __m128i assist) {
+  assist = _mm_shuffle_epi32(assist, 0xFF);
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+  return _mm_xor_si128(key, assist);
+}
+
+#define AES_EXPAND(i, rcon)  rk[i] = aesExpandStep(rk[(i) - 1], _mm_aeskeygenassist_si128(rk[(i) - 1], rcon))
+
+TARGET_AES static void aesExpandKeyNI(uint8_t* enc_keys, uint8_t* dec_keys, const uint8_t* key) {
+  __m128i rk[11];
+  rk[0] = _mm_loadu_si128((const __m128i *) key);
+  AES_EXPAND(1, 0x01); AES_EXPAND(2, 0x02); AES_EXPAND(3, 0x04); AES_EXPAND(4, 0x08); AES_EXPAND(5, 0x10);
+  AES_EXPAND(6, 0x20); AES_EXPAND(7, 0x40); AES_EXPAND(8, 0x80); AES_EXPAND(9, 0x1B); AES_EXPAND(10, 0x36);
+
+  // decryption uses the round keys in reverse, with InvMixColumns applied to the inner ones
+  for (int i = 0; i <= 10; i++) {
+    _mm_storeu_si128((__m128i *) &enc_keys[i*16], rk[i]);
+    __m128i d = (i == 0 || i == 10) ? rk[10 - i] : _mm_aesimc_si128(rk[10 - i]);
+    _mm_storeu_si128((__m128i *) &dec_keys[i*16], d);
+  }
+}
+
+// 4 independent blocks per pass, to keep the AES unit's pipeline full
+TARGET_AES static void aesEncryptNI(const uint8_t* keys, uint8_t* output, const uint8_t* input, int num_blocks) {
+  __m128i rk[11];
+  for (int i = 0; i <= 10; i++) rk[i] = _mm_loadu_si128((const __m128i *) &keys[i*16]);
+
+  for (; num_blocks >= 4; num_blocks -= 4, input += 64, output += 64) {
+    __m128i b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (input + 0)), rk[0]);
+    __m128i b1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (input + 16)), rk[0]);
+    __m128i b2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (input + 32)), rk[0]);
+    __m128i b3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (input + 48)), rk[0]);
+    for (int r = 1; r < 10; r++) {
+      b0 = _mm_aesenc_si128(b0, rk[r]); b1 = _mm_aesenc_si128(b1, rk[r]);
+      b2 = _mm_aesenc_si128(b2, rk[r]); b3 = _mm_aesenc_si128(b3, rk[r]);
+    }
+    _mm_storeu_si128((__m128i *) (output + 0), _mm_aesenclast_si128(b0, rk[10]));
+    _mm_storeu_si128((__m128i *) (output + 16), _mm_aesenclast_si128(b1, rk[10]));
+    _mm_storeu_si128((__m128i *) (output + 32), _mm_aesenclast_si128(b2, rk[10]));
+    _mm_storeu_si128((__m128i *) (output + 48), _mm_aesenclast_si128(b3, rk[10]));
+  }
+  for (; num_blocks > 0; num_blocks--, input += 16, output += 16) {
+    __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *) input), rk[0]);
+    for (int r = 1; r < 10; r++) b = _mm_aesenc_si128(b, rk[r]);
+    _mm_storeu_si128((__m128i *) output, _mm_aesenclast_si128(b, rk[10]));
+  }
+}
+
+TARGET_AES static void aesDecryptNI(const uint8_t* keys, uint8_t* output, const uint8_t* input, int num_blocks) {
+  __m128i rk[11];
+  for (int i = 0; i <= 10; i++) rk[i] = _mm_loadu_si128((const __m128i *) &keys[i*16]);
+
+  for (; num_blocks >= 4; num_blocks -= 4, input += 64, output += 64) {
+    __m128i b0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (input + 0)), rk[0]);
+    __m128i b1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (input + 16)), rk[0]);
+    __m128i b2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (input + 32)), rk[0]);
+    __m128i b3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (input + 48)), rk[0]);
+    for (int r = 1; r < 10; r++) {
+      b0 = _mm_aesdec_si128(b0, rk[r]); b1 = _mm_aesdec_si128(b1, rk[r]);
+      b2 = _mm_aesdec_si128(b2, rk[r]); b3 = _mm_aesdec_si128(b3, rk[r]);
+    }
+    _mm_storeu_si128((__m128i *) (output + 0), _mm_aesdeclast_si128(b0, rk[10]));
+    _mm_storeu_si128((__m128i *) (output + 16), _mm_aesdeclast_si128(b1, rk[10]));
+    _mm_storeu_si128((__m128i *) (output + 32), _mm_aesdeclast_si128(b2, rk[10]));
+    _mm_storeu_si128((__m128i *) (output + 48), _mm_aesdeclast_si128(b3, rk[10]));
+  }
+  for (; num_blocks > 0; num_blocks--, input += 16, output += 16) {
+    __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *) input), rk[0]);
+    for (int r = 1; r < 10; r++) b = _mm_aesdec_si128(b, rk[r]);
+    _mm_storeu_si128((__m128i *) output, _mm_aesdeclast_si128(b, rk[10]));
+  }
+}
+
+CryptoAES128::CryptoAES128() {
+  _hw = (getCpuFeatures() & CPU_AES_NI) != 0;
+}
+CryptoAES128::~CryptoAES128() {
+  memset(_enc_keys, 0, sizeof(_enc_keys));
+  memset(_dec_keys, 0, sizeof(_dec_keys));
+}
+
+bool CryptoAES128::setKey(const uint8_t* key, size_t len) {
+  if (!_hw) return _soft.setKey(key, len);
+  if (len != 16) return false;
+
+  aesExpandKeyNI(_enc_keys, _dec_keys, key);
+  return true;
+}
+
+void CryptoAES128::encryptBlock(uint8_t* output, const uint8_t* input) {
+  encryptBlocks(output, input, 1);
+}
+void CryptoAES128::decryptBlock(uint8_t* output, const uint8_t* input) {
+  decryptBlocks(output, input, 1);
+}
+
+void CryptoAES128::encryptBlocks(uint8_t* output, const uint8_t* input, int num_blocks) {
+  if (_hw) {
+    aesEncryptNI(_enc_keys, output, input, num_blocks);
+  } else {
+    for (int i = 0; i < num_blocks; i++, output += 16, input += 16) _soft.encryptBlock(output, input);
+  }
+}
+void CryptoAES128::decryptBlocks(uint8_t* output, const uint8_t* input, int num_blocks) {
+  if (_hw) {
+    aesDecryptNI(_dec_keys, output, input, num_blocks);
+  } else {
+    for (int i = 0; i < num_blocks; i++, output += 16, input += 16) _soft.decryptBlock(output, input);
+  }
+}
+
+const char* getCryptoProviderName() {
+  switch (getCpuFeatures()) {
+    case CPU_SHA_NI | CPU_AES_NI: return "x86 (SHA-NI, AES-NI)";
+    case CPU_AES_NI: return "x86 (AES-NI, software SHA-256)";
+    case CPU_SHA_NI: return "x86 (SHA-NI, software AES)";
+    default: return "software";
+  }
+}
+
+}
+
+#endif
@@ -7,19 +7,110 @@ void Dispatcher::begin() {
   _radio->begin();
 }
 
-float Dispatcher::getAirtimeBudgetFactor() const {
-  return 5.0;   // default, 16.6%  (1/6th)
+uint8_t Dispatcher::getAirtimeClass(const Packet* packet) const {
+  switch (packet->getPacketType()) {
+    case PH_TYPE_ANNOUNCE: return AIRTIME_CLASS_ANNOUNCE;
+    case PH_TYPE_REPLY:
+    case PH_TYPE_REPLY_SIGNED: return AIRTIME_CLASS_REPLY;
+    default: return AIRTIME_CLASS_DATA;
+  }
+}
+
+void Dispatcher::setAirtimeBudget(uint8_t airtime_class, float budget_factor, uint32_t burst_millis) {
+  if (airtime_class >= NUM_AIRTIME_CLASSES) return;
+
+  AirtimeBucket& b = buckets[airtime_class];
+  b.refill_rate = 1.0f / (1.0f + budget_factor);
+  b.burst_millis = burst_millis;
+  b.tokens = burst_millis;   // start full
+}
+
+float Dispatcher::getAirtimeBudgetTokens(uint8_t airtime_class) {
+  if (airtime_class >= NUM_AIRTIME_CLASSES) return 0;
+
+  refillAirtimeBuckets();
+  return buckets[airtime_class].tokens;
+}
+
+void Dispatcher::refillAirtimeBuckets() {
+  unsigned long now = _ms->getMillis();
+  unsigned long elapsed = now - last_refill;
+  last_refill = now;
+
+  for (int i = 0; i < NUM_AIRTIME_CLASSES; i++) {
+    AirtimeBucket& b = buckets[i];
+    b.tokens += elapsed * b.refill_rate;
+    if (b.tokens > b.burst_millis) b.tokens = b.burst_millis;
+  }
+}
+
+void Dispatcher::setDutyCycle(float percent) {
+  duty_limit_millis = (uint32_t) (percent / 100.0f * ((float)DUTY_CYCLE_WINDOW_SLOTS * DUTY_CYCLE_SLOT_MILLIS));
+}
+
+void Dispatcher::advanceDutyWindow() {
+  unsigned long now = _ms->getMillis();
+  if (now - duty_slot_start >= (unsigned long) (DUTY_CYCLE_WINDOW_SLOTS+1) * DUTY_CYCLE_SLOT_MILLIS) {
+    memset(duty_window, 0, sizeof(duty_window));   // whole window has expired
+    duty_slot_start = now;
+    return;
+  }
+  while (now - duty_slot_start >= DUTY_CYCLE_SLOT_MILLIS) {
+    duty_slot_idx = (duty_slot_idx + 1) % (DUTY_CYCLE_WINDOW_SLOTS+1);
+    duty_window[duty_slot_idx] = 0;   // oldest slot drops out of window
+    duty_slot_start += DUTY_CYCLE_SLOT_MILLIS;
+  }
+}
+
+uint32_t Dispatcher::getDutyWindowUsed() const {
+  uint32_t used = 0;
+  for (int i = 0; i <= DUTY_CYCLE_WINDOW_SLOTS; i++) used += duty_window[i];
+  return used;
+}
+
+uint32_t Dispatcher::getDutyCycleRemaining() {
+  if (duty_limit_millis == 0) return 0xFFFFFFFF;   // no limit
+
+  advanceDutyWindow();
+  uint32_t used = getDutyWindowUsed();
+  return used < duty_limit_millis ? duty_limit_millis - used : 0;
+}
+
+uint32_t Dispatcher::getDutyCycleWaitMillis(uint32_t airtime) const {
+  // how long until enough old slots have dropped out of the window for 'airtime' to fit
+  uint32_t used = getDutyWindowUsed();
+  unsigned long slot_end = duty_slot_start + DUTY_CYCLE_SLOT_MILLIS;
+  int i = duty_slot_idx;
+  for (int n = 0; n <= DUTY_CYCLE_WINDOW_SLOTS && used + airtime > duty_limit_millis; n++) {
+    i = (i + 1) % (DUTY_CYCLE_WINDOW_SLOTS+1);   // next oldest slot
+    used -= duty_window[i];
+    if (used + airtime <= duty_limit_millis) break;
+    slot_end += DUTY_CYCLE_SLOT_MILLIS;
+  }
+  long wait = (long)(slot_end - _ms->getMillis());
+  return wait > 0 ? wait : 1;
+}
+
+void Dispatcher::chargeAirtime(unsigned long t) {
+  total_air_time += t;  // keep track of how much air time we are using
+  //Serial.print("  airtime="); Serial.println(t);
+
+  // charge the actual airtime used to this packet's class budget
+  refillAirtimeBuckets();
+  buckets[outbound_class].tokens -= t;
+
+  advanceDutyWindow();
+  duty_window[duty_slot_idx] += t;
+}
+
+uint32_t Dispatcher::getBusyBackoffMillis(uint8_t attempt) {
+  return CSMA_SLOT_MILLIS << attempt;   // sub-classes should randomise this
 }
 
 void Dispatcher::loop() {
   if (outbound) {  // waiting for outbound send to be completed
     if (_radio->isSendComplete()) {
-      long t = _ms->getMillis() - outbound_start;
-      total_air_time += t;  // keep track of how much air time we are using
-      //Serial.print("  airtime="); Serial.println(t);
-
-      // will need radio silence up to next_tx_time
-      next_tx_time = futureMillis(t * getAirtimeBudgetFactor());
+      chargeAirtime(_ms->getMillis() - outbound_start);
 
       _radio->onSendFinished();
       onPacketSent(outbound);
@@ -28,6 +119,9 @@ void Dispatcher::loop() {
       RIPPLE_DEBUG_PRINTLN("Dispatcher::loop(): WARNING: outbound packed send timed out!");
       //Serial.println("  timed out");
 
+      // radio may have been transmitting all this time, so it must still count against the limits
+      chargeAirtime(_ms->getMillis() - outbound_start);
+
       _radio->onSendFinished();
       releasePacket(outbound);  // return to pool
       outbound = NULL;
@@ -40,87 +134,136 @@ void Dispatcher::loop() {
   checkSend();
 }
 
+unsigned long Dispatcher::getNextWakeMillis() const {
+  if (outbound) {
+    return outbound_expiry;   // otherwise, send complete is signalled by radio interrupt
+  }
+  unsigned long wake = futureMillis(MAX_IDLE_WAIT_MILLIS);
+  if (_mgr->getOutboundCount() > 0) {
+    unsigned long t = _mgr->getNextOutboundTime();
+    if ((long)(next_tx_time - t) > 0) t = next_tx_time;   // can't send until backoff is over
+    wake = soonerMillis(wake, t);
+  }
+  return wake;
+}
+
+void Dispatcher::waitForNextEvent() {
+  long wait_millis = (long)(getNextWakeMillis() - _ms->getMillis());
+  if (wait_millis > 0) {
+    _radio->waitForEvent(wait_millis);
+  }
+}
+
 void Dispatcher::onPacketSent(Packet* packet) {
   releasePacket(packet);  // default behaviour, return packet to pool
 }
 
 void Dispatcher::checkRecv() {
-  Packet* pkt;
+  Packet* pkt = _mgr->allocNew();
+  if (pkt == NULL) {
+    discardRecv();
+    return;
+  }
+
+  // read the raw frame directly into the pool Packet (no intermediate buffer)
+  int len = _radio->recvRaw(pkt->getRawRecvBuffer(), pkt->getRawRecvBufferSize());
+  if (len <= 0) {
+    _mgr->free(pkt);  // nothing received, put back into pool
+    return;
+  }
+
+  // link quality of this hop
+  float snr = _radio->getLastSNR() * 4;
+  pkt->recv_snr = snr < -128 ? -128 : (snr > 127 ? 127 : (int8_t) snr);
+  pkt->recv_rssi = (int16_t) _radio->getLastRSSI();
+
   {
-    uint8_t raw[MAX_TRANS_UNIT];
-    int len = _radio->recvRaw(raw, MAX_TRANS_UNIT);
-    if (len > 0) {
-      pkt = _mgr->allocNew();
-      if (pkt == NULL) {
-        RIPPLE_DEBUG_PRINTLN("Dispatcher::checkRecv(): WARNING: received data, no unused packets available!");
-      } else {
-        int i = 0;
+    const uint8_t* raw = pkt->getRawRecvBuffer();
+    int i = 0;
 #ifdef NODE_ID
-        uint8_t sender_id = raw[i++];
-        if (sender_id == NODE_ID - 1 || sender_id == NODE_ID + 1) {  // simulate that NODE_ID can only hear NODE_ID-1 or NODE_ID+1, eg. 3 can't hear 1
-        } else {
-          _mgr->free(pkt);  // put back into pool
-          return;
-        }
+    uint8_t sender_id = raw[i++];
+    if (sender_id == NODE_ID - 1 || sender_id == NODE_ID + 1) {  // simulate that NODE_ID can only hear NODE_ID-1 or NODE_ID+1, eg. 3 can't hear 1
+    } else {
+      _mgr->free(pkt);  // put back into pool
+      return;
+    }
 #endif
-        //Serial.print("LoRa recv: len="); Serial.println(len);
-
-        pkt->header = raw[i++];
-        pkt->hops = raw[i++];
-        if (pkt->header & PH_HAS_TRANS_ADDRESS) {
-          memcpy(pkt->transport_id, &raw[i], DEST_HASH_SIZE); i += DEST_HASH_SIZE;
-        } else {
-          memset(pkt->transport_id, 0, DEST_HASH_SIZE);  // useful for comparisons
-        }
+    //Serial.print("LoRa recv: len="); Serial.println(len);
 
-        if (pkt->getPacketType() == PH_TYPE_ANNOUNCE) {
-          // destination_hash can now be calculated from Announce payload, so don't include in wire format
-        } else {
-          memcpy(pkt->destination_hash, &raw[i], DEST_HASH_SIZE); i += DEST_HASH_SIZE;
-        }
+    pkt->header = raw[i++];
+    pkt->hops = raw[i++];
+    if (pkt->header & PH_HAS_TRANS_ADDRESS) {
+      memcpy(pkt->transport_id, &raw[i], DEST_HASH_SIZE); i += DEST_HASH_SIZE;
+    } else {
+      memset(pkt->transport_id, 0, DEST_HASH_SIZE);  // useful for comparisons
+    }
 
-        if (i > len) {
-          RIPPLE_DEBUG_PRINTLN("Dispatcher::checkRecv(): partial packet received, len=%d", len);
-          _mgr->free(pkt);  // put back into pool
-          pkt = NULL;
-        } else {
-          pkt->payload_len = len - i;  // payload is remainder
-          memcpy(pkt->payload, &raw[i], pkt->payload_len);
-        }
-      }
+    if (pkt->getPacketType() == PH_TYPE_ANNOUNCE) {
+      // destination_hash can now be calculated from Announce payload, so don't include in wire format
     } else {
-      pkt = NULL;
+      memcpy(pkt->destination_hash, &raw[i], DEST_HASH_SIZE); i += DEST_HASH_SIZE;
     }
-  }
-  if (pkt) {
-    DispatcherAction action = onRecvPacket(pkt);
-    if (action == ACTION_RELEASE) {
-      _mgr->free(pkt);
-    } else if (action == ACTION_MANUAL_HOLD) {
-      // sub-class is wanting to manually hold Packet instance, and call releasePacket() at appropriate time
-    } else {   // ACTION_RETRANSMIT*
-      uint8_t priority = (action >> 24) - 1;
-      uint32_t _delay = action & 0xFFFFFF;
-
-      _mgr->queueOutbound(pkt, priority, futureMillis(_delay));
+
+    if (i > len) {
+      RIPPLE_DEBUG_PRINTLN("Dispatcher::checkRecv(): partial packet received, len=%d", len);
+      _mgr->free(pkt);  // put back into pool
+      return;
+    }
+    if (len - i > MAX_PACKET_PAYLOAD) {   // short frame header, but payload too long to be valid
+      RIPPLE_DEBUG_PRINTLN("Dispatcher::checkRecv(): payload too long, len=%d", len - i);
+      _mgr->free(pkt);  // put back into pool
+      return;
     }
+    pkt->payload = &pkt->frame[i];   // payload is remainder, in place (even after a shorter frame header)
+    pkt->payload_len = len - i;
+  }
+
+  processRecvAction(pkt, onRecvPacket(pkt));
+}
+
+void Dispatcher::processRecvAction(Packet* pkt, DispatcherAction action) {
+  if (action == ACTION_RELEASE) {
+    _mgr->free(pkt);
+  } else if (action == ACTION_MANUAL_HOLD) {
+    // sub-class is wanting to manually hold Packet instance, and call releasePacket() at appropriate time
+  } else {   // ACTION_RETRANSMIT*
+    uint8_t priority = (action >> 24) - 1;
+    uint32_t _delay = action & 0xFFFFFF;
+
+    _mgr->queueOutbound(pkt, priority, futureMillis(_delay));
   }
 }
 
 void Dispatcher::checkSend() {
   if (_mgr->getOutboundCount() == 0) return;  // nothing waiting to send
-  if (!millisHasNowPassed(next_tx_time)) return;   // still in 'radio silence' phase (from airtime budget setting)
-  if (_radio->isReceiving()) return;  // check if radio is currently mid-receive
+  if (!millisHasNowPassed(next_tx_time)) return;   // still backing off (channel was busy)
+  if ((long)(_ms->getMillis() - _mgr->getNextOutboundTime()) < 0) return;  // nothing due yet
 
-  outbound = _mgr->getNextOutbound(_ms->getMillis());
+  uint8_t priority;
+  outbound = _mgr->getNextOutbound(_ms->getMillis(), &priority);
   if (outbound) {
-    int len = 0;
-    uint8_t raw[MAX_TRANS_UNIT];
+    if (outbound->payload_len > MAX_PACKET_PAYLOAD) {
+      RIPPLE_DEBUG_PRINTLN("Dispatcher::checkSend(): FATAL: Invalid packet queued... too long, len=%d", (int) outbound->payload_len);
+      _mgr->free(outbound);
+      outbound = NULL;
+      return;
+    }
 
     // optimisation
     if (memcmp(outbound->destination_hash, outbound->transport_id, DEST_HASH_SIZE) == 0) {
       outbound->header &= ~PH_HAS_TRANS_ADDRESS;  // next hop IS the destination, don't need 'transport_id' address
     }
+
+    int prefix_len = 2;
+#ifdef NODE_ID
+    prefix_len++;
+#endif
+    if (outbound->header & PH_HAS_TRANS_ADDRESS) prefix_len += DEST_HASH_SIZE;
+    if (outbound->getPacketType() != PH_TYPE_ANNOUNCE) prefix_len += DEST_HASH_SIZE;
+
+    // frame header is written directly in front of payload, so payload is (usually) not copied
+    uint8_t* raw = outbound->getRawSendBuffer(prefix_len);
+    int len = 0;
 #ifdef NODE_ID
     raw[len++] = NODE_ID;
 #endif
@@ -135,21 +278,73 @@ void Dispatcher::checkSend() {
     } else {
       memcpy(&raw[len], outbound->destination_hash, DEST_HASH_SIZE); len += DEST_HASH_SIZE;
     }
+    len += outbound->payload_len;
 
-    if (len + outbound->payload_len > MAX_TRANS_UNIT) {
-      RIPPLE_DEBUG_PRINTLN("Dispatcher::checkSend(): FATAL: Invalid packet queued... too long, len=%d", len + outbound->payload_len);
-      _mgr->free(outbound);
+    // check this class of traffic has enough airtime budget left
+    uint32_t est_airtime = _radio->getEstAirtimeFor(len);
+    outbound_class = getAirtimeClass(outbound);
+    refillAirtimeBuckets();
+    const AirtimeBucket& b = buckets[outbound_class];
+    float needed = est_airtime < b.burst_millis ? est_airtime : b.burst_millis;
+    if (b.tokens < needed) {
+      // re-schedule for when budget will be available, and let other classes of traffic go first
+      uint32_t wait_millis = (uint32_t)((needed - b.tokens) / b.refill_rate) + 1;
+      _mgr->queueOutbound(outbound, priority, futureMillis(wait_millis));
       outbound = NULL;
-    } else {
-      memcpy(&raw[len], outbound->payload, outbound->payload_len); len += outbound->payload_len;
+      backoff_attempt = 0;   // any listen-before-talk deferral is over, as this packet won't be probed again for a while
+      return;
+    }
 
-      uint32_t max_airtime = _radio->getEstAirtimeFor(len)*3/2;
-      outbound_start = _ms->getMillis();
-      _radio->startSendRaw(raw, len);
-      outbound_expiry = futureMillis(max_airtime);
+    // check regulatory duty cycle won't be exceeded
+    if (duty_limit_millis > 0) {
+      advanceDutyWindow();
+      if (getDutyWindowUsed() + est_airtime > duty_limit_millis) {
+        if (outbound_class == DUTY_CYCLE_DROP_CLASS || est_airtime > duty_limit_millis) {
+          RIPPLE_DEBUG_PRINTLN("Dispatcher::checkSend(): duty cycle limit reached, dropping packet, class=%d", (int) outbound_class);
+          n_tx_duty_dropped++;
+          releasePacket(outbound);
+        } else {
+          n_tx_duty_deferred++;
+          _mgr->queueOutbound(outbound, priority, futureMillis(getDutyCycleWaitMillis(est_airtime)));
+        }
+        outbound = NULL;
+        backoff_attempt = 0;   // (as above)
+        return;
+      }
+    }
 
-      //Serial.print("LoRa send: len="); Serial.print(len);
+    // listen-before-talk, last, as a CAD probe interrupts receive
+    if (_radio->isChannelActive()) {
+      if (backoff_attempt == 0) {
+        defer_start = _ms->getMillis();
+      }
+      if (_ms->getMillis() - defer_start < CSMA_MAX_DEFER_MILLIS) {
+        if (backoff_attempt < CSMA_MAX_BACKOFF_EXP) backoff_attempt++;
+        n_tx_deferred++;
+        next_tx_time = futureMillis(getBusyBackoffMillis(backoff_attempt));
+        _mgr->queueOutbound(outbound, priority, _ms->getMillis());   // still due, once backoff is over
+        outbound = NULL;
+        return;
+      }
+      RIPPLE_DEBUG_PRINTLN("Dispatcher::checkSend(): WARNING: channel still busy, sending anyway");
+      n_tx_forced++;
     }
+    backoff_attempt = 0;
+
+    uint32_t max_airtime = est_airtime*3/2;
+    outbound_start = _ms->getMillis();
+    _radio->startSendRaw(raw, len);
+    outbound_expiry = futureMillis(max_airtime);
+
+    //Serial.print("LoRa send: len="); Serial.print(len);
+  }
+}
+
+void Dispatcher::discardRecv() {
+  uint8_t raw[MAX_TRANS_UNIT];
+  int len = _radio->recvRaw(raw, MAX_TRANS_UNIT);
+  if (len > 0) {
+    RIPPLE_DEBUG_PRINTLN("Dispatcher::checkRecv(): WARNING: received data, no unused packets available!");
   }
 }
 
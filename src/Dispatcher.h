@@ -15,6 +15,7 @@ namespace ripple {
 class MillisecondClock {
 public:
   virtual unsigned long getMillis() = 0;
+  virtual unsigned long getMicros() { return getMillis() * 1000; }   // for profiling. Sub-classes should override, if hardware has better resolution
 };
 
 /**
@@ -58,6 +59,25 @@ public:
    * \returns  true if the radio is currently mid-receive of a packet.
   */
   virtual bool isReceiving() { return false; }
+
+  /**
+   * \brief  listen-before-talk probe, eg. by Channel Activity Detection (CAD), or RSSI above a noise threshold.
+   *         Only called when a send is due. Default is just isReceiving().
+   * \returns  true if the channel is currently busy.
+  */
+  virtual bool isChannelActive() { return isReceiving(); }
+
+  /**
+   * \brief  blocks (eg. in a low power mode) until a radio interrupt, or 'max_millis' has elapsed.
+   *        Default is to return immediately, ie. busy-polling.
+  */
+  virtual void waitForEvent(uint32_t max_millis) { }
+
+  /**
+   * \returns  signal strength (dBm), and signal-to-noise ratio (dB), of the last packet received.
+  */
+  virtual float getLastRSSI() const { return 0; }
+  virtual float getLastSNR() const { return 0; }
 };
 
 /**
@@ -70,7 +90,16 @@ public:
   virtual void free(Packet* packet) = 0;
 
   virtual void queueOutbound(Packet* packet, uint8_t priority, uint32_t scheduled_for) = 0;
-  virtual Packet* getNextOutbound(uint32_t now) = 0;    // by priority
+  /**
+   * \brief  removes the most important (by priority) outbound packet which is due.
+   * \param  priority  OUT - if not NULL, the priority it was queued with
+  */
+  virtual Packet* getNextOutbound(uint32_t now, uint8_t* priority=NULL) = 0;
+
+  /**
+   * \returns  the 'scheduled_for' time of the soonest queued outbound packet. (only valid if getOutboundCount() > 0)
+  */
+  virtual uint32_t getNextOutboundTime() const = 0;
   virtual int getOutboundCount() const = 0;
   virtual int getFreeCount() const = 0;
   virtual Packet* getOutboundByIdx(int i) = 0;
@@ -84,6 +113,59 @@ typedef uint32_t  DispatcherAction;
 #define ACTION_RETRANSMIT(pri)   (((uint32_t)1 + (pri))<<24)
 #define ACTION_RETRANSMIT_DELAYED(pri, _delay)  ((((uint32_t)1 + (pri))<<24) | (_delay))
 
+// listen-before-talk: random backoff window is CSMA_SLOT_MILLIS * 2^attempt, up to CSMA_MAX_BACKOFF_EXP
+#ifndef CSMA_SLOT_MILLIS
+  #define CSMA_SLOT_MILLIS        50
+#endif
+#ifndef CSMA_MAX_BACKOFF_EXP
+  #define CSMA_MAX_BACKOFF_EXP     6
+#endif
+// after deferring this long, send anyway
+#ifndef CSMA_MAX_DEFER_MILLIS
+  #define CSMA_MAX_DEFER_MILLIS  8000
+#endif
+
+// classes of outbound traffic, which each have their own airtime budget
+#define AIRTIME_CLASS_REPLY      0
+#define AIRTIME_CLASS_DATA       1
+#define AIRTIME_CLASS_ANNOUNCE   2
+#define NUM_AIRTIME_CLASSES      3
+
+#ifndef DEFAULT_AIRTIME_BURST_MILLIS
+  #define DEFAULT_AIRTIME_BURST_MILLIS  3000
+#endif
+
+/**
+ * \brief  A token bucket, of transmit airtime (in millis)
+*/
+struct AirtimeBucket {
+  float refill_rate;   // airtime millis earned per elapsed milli, ie. the max duty cycle
+  float tokens;
+  uint32_t burst_millis;   // max tokens
+};
+
+// regulatory duty cycle, enforced over a sliding window of DUTY_CYCLE_WINDOW_SLOTS * DUTY_CYCLE_SLOT_MILLIS (one hour)
+#ifndef DUTY_CYCLE_WINDOW_SLOTS
+  #define DUTY_CYCLE_WINDOW_SLOTS   60
+#endif
+#ifndef DUTY_CYCLE_SLOT_MILLIS
+  #define DUTY_CYCLE_SLOT_MILLIS   (60*1000)
+#endif
+// max percentage of the window which can be used transmitting. 0 = no limit  (eg. 1 or 10 for EU868 sub-bands)
+#ifndef DEFAULT_DUTY_CYCLE_PERCENT
+  #define DEFAULT_DUTY_CYCLE_PERCENT  0
+#endif
+// when duty cycle would be exceeded, outbound packets of this airtime class are dropped (as they are re-flooded, and
+//  will be heard again), others are deferred
+#ifndef DUTY_CYCLE_DROP_CLASS
+  #define DUTY_CYCLE_DROP_CLASS   AIRTIME_CLASS_ANNOUNCE
+#endif
+
+// longest time to wait in waitForNextEvent() if nothing is scheduled
+#ifndef MAX_IDLE_WAIT_MILLIS
+  #define MAX_IDLE_WAIT_MILLIS   (60*1000)
+#endif
+
 /**
  * \brief  The low-level task that manages detecting incoming Packets, and the queueing
  *      and scheduling of outbound Packets.
@@ -92,6 +174,23 @@ class Dispatcher {
   Packet* outbound;  // current outbound packet
   unsigned long outbound_expiry, outbound_start, total_air_time;
   unsigned long next_tx_time;
+  unsigned long defer_start;
+  uint8_t  backoff_attempt;
+  uint32_t n_tx_deferred, n_tx_forced;
+  AirtimeBucket buckets[NUM_AIRTIME_CLASSES];
+  unsigned long last_refill;
+  uint8_t  outbound_class;
+  uint32_t duty_window[DUTY_CYCLE_WINDOW_SLOTS+1];   // airtime used in each slot (millis), current slot plus the full window before it
+  unsigned long duty_slot_start;
+  uint16_t duty_slot_idx;   // current slot
+  uint32_t duty_limit_millis;
+  uint32_t n_tx_duty_deferred, n_tx_duty_dropped;
+
+  void refillAirtimeBuckets();
+  void advanceDutyWindow();
+  uint32_t getDutyWindowUsed() const;
+  uint32_t getDutyCycleWaitMillis(uint32_t airtime) const;
+  void chargeAirtime(unsigned long t);
 
 protected:
   PacketManager* _mgr;
@@ -102,15 +201,51 @@ protected:
     : _radio(&radio), _ms(&ms), _mgr(&mgr)
   {
     outbound = NULL; total_air_time = 0; next_tx_time = 0;
+    backoff_attempt = 0; n_tx_deferred = n_tx_forced = 0;
+    for (int i = 0; i < NUM_AIRTIME_CLASSES; i++) {
+      setAirtimeBudget(i, 5.0, DEFAULT_AIRTIME_BURST_MILLIS);   // default, 16.6%  (1/6th)
+    }
+    last_refill = 0;
+    memset(duty_window, 0, sizeof(duty_window));
+    duty_slot_start = 0; duty_slot_idx = 0;
+    n_tx_duty_deferred = n_tx_duty_dropped = 0;
+    setDutyCycle(DEFAULT_DUTY_CYCLE_PERCENT);
   }
 
   virtual DispatcherAction onRecvPacket(Packet* pkt) = 0;
+
+  /**
+   * \brief  carries out the action returned by onRecvPacket(). Sub-classes which held a received Packet (ACTION_MANUAL_HOLD)
+   *      can call this later, once they have decided what to do with it.
+  */
+  void processRecvAction(Packet* pkt, DispatcherAction action);
   virtual void onPacketSent(Packet* packet);
-  virtual float getAirtimeBudgetFactor() const;
+
+  /**
+   * \returns  which airtime budget (AIRTIME_CLASS_*) the given outbound packet is charged to.
+  */
+  virtual uint8_t getAirtimeClass(const Packet* packet) const;
+
+  /**
+   * \returns  delay (in millis) before re-trying a send, after the channel was found busy. 'attempt' starts at 1.
+   *      Should be random, so that neighbouring nodes don't re-try in lock-step.
+  */
+  virtual uint32_t getBusyBackoffMillis(uint8_t attempt);
 
 public:
   void begin();
-  void loop();
+  virtual void loop();
+
+  /**
+   * \returns  the millis() time when loop() next needs to be called, assuming no radio interrupt happens before then.
+  */
+  virtual unsigned long getNextWakeMillis() const;
+
+  /**
+   * \brief  For event-driven (rather than busy-polled) operation. Call after loop(), and this will block until
+   *         the time given by getNextWakeMillis(), or until a radio interrupt.
+  */
+  void waitForNextEvent();
 
   Packet* obtainNewPacket();
   void releasePacket(Packet* packet);
@@ -118,13 +253,39 @@ public:
 
   unsigned long getTotalAirTime() const { return total_air_time; }  // in milliseconds
 
+  /**
+   * \brief  sets the airtime budget for one class of traffic. Each class is throttled independently.
+   * \param  airtime_class  one of AIRTIME_CLASS_*
+   * \param  budget_factor  after transmitting for T millis, this class earns back T of airtime in T * budget_factor millis.
+   *             ie. max duty cycle is 1/(1 + budget_factor)
+   * \param  burst_millis  max airtime this class can use in one burst
+  */
+  void setAirtimeBudget(uint8_t airtime_class, float budget_factor, uint32_t burst_millis);
+  float getAirtimeBudgetTokens(uint8_t airtime_class);   // current budget, in millis
+
+  /**
+   * \brief  sets the max percentage of time spent transmitting, over any one hour (sliding window). 0 = no limit
+  */
+  void setDutyCycle(float percent);
+
+  /**
+   * \returns  airtime (millis) still available in the current duty cycle window, or 0xFFFFFFFF if no limit.
+  */
+  uint32_t getDutyCycleRemaining();
+  uint32_t getNumTxDutyDeferred() const { return n_tx_duty_deferred; }
+  uint32_t getNumTxDutyDropped() const { return n_tx_duty_dropped; }
+  uint32_t getNumTxDeferred() const { return n_tx_deferred; }   // times a send was deferred, channel busy
+  uint32_t getNumTxForced() const { return n_tx_forced; }   // sends made while channel busy, after CSMA_MAX_DEFER_MILLIS
+
   // helper methods
   bool millisHasNowPassed(unsigned long timestamp) const;
   unsigned long futureMillis(int millis_from_now) const;
+  static unsigned long soonerMillis(unsigned long a, unsigned long b) { return (long)(a - b) < 0 ? a : b; }
 
 private:
   void checkRecv();
   void checkSend();
+  void discardRecv();
 };
 
 }
@@ -2,9 +2,57 @@
 #include <string.h>
 #define ED25519_NO_SEED  1
 #include <ed_25519.h>
+#include <stddef.h>
 
 namespace ripple {
 
+static_assert(sizeof(MsgFragment) == sizeof(ed25519_iovec) && offsetof(MsgFragment, data) == offsetof(ed25519_iovec, data)
+    && offsetof(MsgFragment, len) == offsetof(ed25519_iovec, len), "MsgFragment must match ed25519_iovec");
+static_assert(sizeof(SignedMsg) == sizeof(ed25519_batch_item) && offsetof(SignedMsg, sig) == offsetof(ed25519_batch_item, signature)
+    && offsetof(SignedMsg, pub_key) == offsetof(ed25519_batch_item, public_key) && offsetof(SignedMsg, frags) == offsetof(ed25519_batch_item, msg)
+    && offsetof(SignedMsg, num_frags) == offsetof(ed25519_batch_item, msg_count), "SignedMsg must match ed25519_batch_item");
+static_assert(sizeof(Identity) == PUB_KEY_SIZE, "Identity arrays must be just the packed public keys");
+static_assert(SIG_BATCH_SCRATCH_SIZE == ED25519_BATCH_SCRATCH_PER_ITEM, "SIG_BATCH_SCRATCH_SIZE is out of date");
+
+#if PUBKEY_CACHE_SIZE > 0
+struct KeyCacheEntry {
+  uint8_t pub_key[PUB_KEY_SIZE];
+  uint32_t last_used;   // 0 = empty slot
+  ed25519_key_point A;
+#if PUBKEY_CACHE_TABLES
+  ed25519_key_table table;
+  #define KEY_TABLE_OF(e)  (&(e)->table)
+#else
+  #define KEY_TABLE_OF(e)  NULL
+#endif
+};
+static KeyCacheEntry key_cache[PUBKEY_CACHE_SIZE];
+static uint32_t key_cache_clock;
+#endif
+static uint32_t n_key_cache_hits, n_key_cache_misses;
+
+#if PUBKEY_CACHE_SIZE > 0
+// finds 'pub_key' in the cache, otherwise decompresses it into the least recently used slot. NULL if not a valid key
+static const KeyCacheEntry* getPreparedKey(const uint8_t* pub_key) {
+  KeyCacheEntry* lru = &key_cache[0];
+  for (int i = 0; i < PUBKEY_CACHE_SIZE; i++) {
+    KeyCacheEntry* e = &key_cache[i];
+    if (e->last_used && memcmp(e->pub_key, pub_key, PUB_KEY_SIZE) == 0) {
+      e->last_used = ++key_cache_clock;
+      n_key_cache_hits++;
+      return e;
+    }
+    if (e->last_used < lru->last_used) lru = e;
+  }
+
+  n_key_cache_misses++;
+  if (!ed25519_prepare_key(&lru->A, KEY_TABLE_OF(lru), pub_key)) return NULL;
+  memcpy(lru->pub_key, pub_key, PUB_KEY_SIZE);
+  lru->last_used = ++key_cache_clock;
+  return lru;
+}
+#endif
+
 Identity::Identity() {
   memset(pub_key, 0, sizeof(pub_key));
 }
@@ -14,7 +62,25 @@ Identity::Identity(const char* pub_hex) {
 }
 
 bool Identity::verify(const uint8_t* sig, const uint8_t* message, int msg_len) const {
-  return ed25519_verify(sig, message, msg_len, pub_key);
+  MsgFragment frag = { message, (size_t) msg_len };
+  return verify(sig, &frag, 1);
+}
+
+bool Identity::verify(const uint8_t* sig, const MsgFragment* frags, int num_frags) const {
+#if PUBKEY_CACHE_SIZE > 0
+  const KeyCacheEntry* e = getPreparedKey(pub_key);
+  if (e == NULL) return false;   // not a valid public key
+  return ed25519_verify_prepared(sig, (const ed25519_iovec *) frags, num_frags, pub_key, &e->A, KEY_TABLE_OF(e));
+#else
+  return ed25519_verify_iov(sig, (const ed25519_iovec *) frags, num_frags, pub_key);
+#endif
+}
+
+uint32_t Identity::getNumKeyCacheHits() { return n_key_cache_hits; }
+uint32_t Identity::getNumKeyCacheMisses() { return n_key_cache_misses; }
+
+bool Identity::verifyBatch(const SignedMsg* msgs, int count, const uint8_t* random, void* scratch, int* valid) {
+  return ed25519_verify_batch((const ed25519_batch_item *) msgs, count, random, scratch, valid);
 }
 
 bool Identity::readFrom(Stream& s) {
@@ -63,8 +129,16 @@ void LocalIdentity::sign(uint8_t* sig, const uint8_t* message, int msg_len) cons
   ed25519_sign(sig, message, msg_len, pub_key, prv_key);
 }
 
+void LocalIdentity::sign(uint8_t* sig, const MsgFragment* frags, int num_frags) const {
+  ed25519_sign_iov(sig, (const ed25519_iovec *) frags, num_frags, pub_key, prv_key);
+}
+
 void LocalIdentity::calcSharedSecret(uint8_t* secret, const Identity& other) {
   ed25519_key_exchange(secret, other.pub_key, prv_key);
 }
 
+void LocalIdentity::calcSharedSecrets(uint8_t* secrets, const Identity* others, int count) {
+  ed25519_key_exchange_batch(secrets, others[0].pub_key, count, prv_key);
+}
+
 }
\ No newline at end of file
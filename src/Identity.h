@@ -5,6 +5,29 @@
 
 namespace ripple {
 
+// number of decompressed public keys Identity::verify() keeps (least recently used is replaced). 0 = none.
+// Saves a field square root per verify. Each entry is approx 200 bytes of RAM.
+#ifndef PUBKEY_CACHE_SIZE
+  #define PUBKEY_CACHE_SIZE    8
+#endif
+// 1 = cache entries also keep the precomputed multiples of the key (1280 more bytes each), saving approx 8 point additions
+#ifndef PUBKEY_CACHE_TABLES
+  #define PUBKEY_CACHE_TABLES   0
+#endif
+
+// bytes of scratch memory needed per signature, by Identity::verifyBatch()
+#define SIG_BATCH_SCRATCH_SIZE   1792
+
+/**
+ * \brief  One signature to check, by Identity::verifyBatch(). (same layout as ed25519_batch_item)
+*/
+struct SignedMsg {
+  const uint8_t* sig;
+  const uint8_t* pub_key;
+  const MsgFragment* frags;
+  size_t num_frags;
+};
+
 /**
  * \brief  An identity in the mesh, with given Ed25519 public key, ie. a party whose signatures can be VERIFIED.
 */
@@ -25,6 +48,25 @@ public:
   */
   bool verify(const uint8_t* sig, const uint8_t* message, int msg_len) const;
 
+  /**
+   * \brief  Same as verify() above, of the message made of the given fragments (in order), without copying them together.
+  */
+  bool verify(const uint8_t* sig, const MsgFragment* frags, int num_frags) const;
+
+  /**
+   * \brief  Verifies several signatures together, which is much cheaper than one at a time. If any are invalid, falls back
+   *       to verifying each on its own, so valid[] is still exact. NOTE: only combined if built with ED25519_COFACTORED
+   *       (see ed_25519.h), otherwise is just one at a time.
+   * \param random IN - 16 bytes per signature, from a good RNG.
+   * \param scratch IN - count * SIG_BATCH_SCRATCH_SIZE bytes, 8 byte aligned (it holds 64-bit field elements).
+   * \param valid OUT - the result for each of msgs[]. (can be NULL)
+   * \returns true, if ALL signatures are valid.
+  */
+  static bool verifyBatch(const SignedMsg* msgs, int count, const uint8_t* random, void* scratch, int* valid);
+
+  static uint32_t getNumKeyCacheHits();    // verify() calls which found the public key already decompressed
+  static uint32_t getNumKeyCacheMisses();
+
   bool matches(const Identity& other) const { return memcmp(pub_key, other.pub_key, PUB_KEY_SIZE) == 0; }
   bool matches(const uint8_t* other_pubkey) const { return memcmp(pub_key, other_pubkey, PUB_KEY_SIZE) == 0; }
 
@@ -51,6 +93,11 @@ public:
   */
   void sign(uint8_t* sig, const uint8_t* message, int msg_len) const;
 
+  /**
+   * \brief  Same as sign() above, of the message made of the given fragments (in order), without copying them together.
+  */
+  void sign(uint8_t* sig, const MsgFragment* frags, int num_frags) const;
+
   /**
    * \brief  the ECDH key exhange, with Ed25519 public key transposed to Ex25519.
    * \param  secret OUT - the 'shared secret'
@@ -58,6 +105,12 @@ public:
   */
   void calcSharedSecret(uint8_t* secret, const Identity& other);
 
+  /**
+   * \brief  Same as calcSharedSecret(), for many others at once. Cheaper than one at a time, as the field inversions are shared.
+   * \param  secrets OUT - PUB_KEY_SIZE bytes for each of 'others', in the same order.
+  */
+  void calcSharedSecrets(uint8_t* secrets, const Identity* others, int count);
+
   bool readFrom(Stream& s);
   bool writeTo(Stream& s) const;
   void printTo(Stream& s) const;
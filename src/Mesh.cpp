@@ -9,6 +9,130 @@ void Mesh::begin() {
 
 void Mesh::loop() {
   Dispatcher::loop();
+
+  if (_ann_batch_count > 0 && millisHasNowPassed(_ann_batch_deadline)) {
+    flushAnnounceBatch();
+  }
+}
+
+unsigned long Mesh::getNextWakeMillis() const {
+  unsigned long wake = Dispatcher::getNextWakeMillis();
+  if (_ann_batch_count > 0) {
+    wake = soonerMillis(wake, _ann_batch_deadline);
+  }
+  return wake;
+}
+
+uint32_t Mesh::getBusyBackoffMillis(uint8_t attempt) {
+  return _rng->nextInt(CSMA_SLOT_MILLIS, (CSMA_SLOT_MILLIS << attempt) + 1);
+}
+
+// Announce payload is:  pub_key, name_hash, rand_blob, signature, app_data
+#define ANNOUNCE_RAND_BLOB_OFS   (PUB_KEY_SIZE + NAME_HASH_SIZE)
+#define ANNOUNCE_SIGNATURE_OFS   (ANNOUNCE_RAND_BLOB_OFS + 8)
+#define ANNOUNCE_APP_DATA_OFS    (ANNOUNCE_SIGNATURE_OFS + SIGNATURE_SIZE)
+
+// the signed message is:  name_hash, pub_key, rand_blob, app_data.  (and caller has checked payload_len >= ANNOUNCE_APP_DATA_OFS)
+static void getAnnounceSignedFrags(const Packet* pkt, MsgFragment* frags) {
+  int app_data_len = pkt->payload_len - ANNOUNCE_APP_DATA_OFS;
+  if (app_data_len > MAX_APP_DATA_SIZE) { app_data_len = MAX_APP_DATA_SIZE; }
+
+  frags[0].data = &pkt->payload[PUB_KEY_SIZE]; frags[0].len = NAME_HASH_SIZE;
+  frags[1].data = pkt->payload; frags[1].len = PUB_KEY_SIZE;
+  frags[2].data = &pkt->payload[ANNOUNCE_RAND_BLOB_OFS]; frags[2].len = 8;
+  frags[3].data = &pkt->payload[ANNOUNCE_APP_DATA_OFS]; frags[3].len = app_data_len;
+}
+
+// key is hash of ALL the signed fields, plus the signature itself, so only an exact copy can match
+static void calcAnnounceKey(uint8_t* key, const Packet* pkt) {
+  MsgFragment frags[5];
+  getAnnounceSignedFrags(pkt, frags);
+  frags[4].data = &pkt->payload[ANNOUNCE_SIGNATURE_OFS]; frags[4].len = SIGNATURE_SIZE;
+  Utils::sha256(key, VERIFIED_SIG_HASH_SIZE, frags, 5);
+}
+
+bool Mesh::isAnnounceVerified(const uint8_t* key) const {
+  const uint8_t* sp = _verified_sigs;
+  for (int i = 0; i < VERIFIED_SIG_CACHE_SIZE; i++, sp += VERIFIED_SIG_HASH_SIZE) {
+    if (memcmp(key, sp, VERIFIED_SIG_HASH_SIZE) == 0) return true;
+  }
+  return false;
+}
+
+void Mesh::addVerifiedAnnounce(const uint8_t* key) {
+  memcpy(&_verified_sigs[_next_verified_idx*VERIFIED_SIG_HASH_SIZE], key, VERIFIED_SIG_HASH_SIZE);
+  _next_verified_idx = (_next_verified_idx + 1) % VERIFIED_SIG_CACHE_SIZE;  // cyclic table
+}
+
+DispatcherAction Mesh::onAnnounceVerified(Packet* pkt) {
+  RIPPLE_DEBUG_PRINTLN("Mesh::onRecvPacket(): valid announce received!");
+
+  Identity id(pkt->payload);
+  const uint8_t* rand_blob = &pkt->payload[ANNOUNCE_RAND_BLOB_OFS];
+  const uint8_t* app_data = &pkt->payload[ANNOUNCE_APP_DATA_OFS];
+  int app_data_len = pkt->payload_len - ANNOUNCE_APP_DATA_OFS;
+  if (app_data_len > MAX_APP_DATA_SIZE) { app_data_len = MAX_APP_DATA_SIZE; }
+
+  if (isAnnounceNew(pkt, id, rand_blob, app_data, app_data_len)) { // this also acts as a filter for apps
+    return onAnnounceRecv(pkt, id, rand_blob, app_data, app_data_len);
+  }
+  RIPPLE_DEBUG_PRINTLN("Mesh::onRecvPacket(): Announce being re-played, or app is not interested in this Announce");
+  return ACTION_RELEASE;
+}
+
+void Mesh::flushAnnounceBatch() {
+  int count = _ann_batch_count;
+  _ann_batch_count = 0;
+
+  MsgFragment frags[ANNOUNCE_VERIFY_BATCH][4];
+  SignedMsg msgs[ANNOUNCE_VERIFY_BATCH];
+  int valid[ANNOUNCE_VERIFY_BATCH];
+  int msg_idx[ANNOUNCE_VERIFY_BATCH];   // which of msgs[] each Announce's result is in
+  int num_msgs = 0;
+
+  for (int i = 0; i < count; i++) {
+    const uint8_t* key = &_ann_batch_keys[i*VERIFIED_SIG_HASH_SIZE];
+    int j = 0;
+    while (j < i && memcmp(key, &_ann_batch_keys[j*VERIFIED_SIG_HASH_SIZE], VERIFIED_SIG_HASH_SIZE) != 0) j++;
+    if (j < i) {   // another copy of the same Announce (eg. via another neighbour), no need to verify twice
+      msg_idx[i] = msg_idx[j];
+      n_verify_saved++;
+      continue;
+    }
+    Packet* pkt = _ann_batch[i];
+    getAnnounceSignedFrags(pkt, frags[num_msgs]);
+    msgs[num_msgs].sig = &pkt->payload[ANNOUNCE_SIGNATURE_OFS];
+    msgs[num_msgs].pub_key = pkt->payload;
+    msgs[num_msgs].frags = frags[num_msgs];
+    msgs[num_msgs].num_frags = 4;
+    msg_idx[i] = num_msgs++;
+  }
+
+  uint8_t random[ANNOUNCE_VERIFY_BATCH*16];
+  _rng->random(random, num_msgs*16);
+  n_batch_verifies++;
+  if (!Identity::verifyBatch(msgs, num_msgs, random, _ann_batch_scratch, valid)) {
+    n_batch_fallbacks++;
+  }
+
+  for (int i = 0; i < count; i++) {
+    Packet* pkt = _ann_batch[i];
+    if (valid[msg_idx[i]]) {
+      const uint8_t* key = &_ann_batch_keys[i*VERIFIED_SIG_HASH_SIZE];
+      if (!isAnnounceVerified(key)) addVerifiedAnnounce(key);
+      processRecvAction(pkt, onAnnounceVerified(pkt));
+    } else {
+      RIPPLE_DEBUG_PRINTLN("Mesh::onRecvPacket(): announce signature forgery received!");
+      releasePacket(pkt);
+    }
+  }
+}
+
+uint8_t Mesh::getLinkCost(const Packet* packet) const {
+  float snr = packet->getRecvSNR();
+  if (snr >= LINK_SNR_GOOD) return 1;
+  if (snr >= LINK_SNR_FAIR) return 2;
+  return 3;
 }
 
 DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
@@ -18,45 +142,40 @@ DispatcherAction Mesh::onRecvPacket(Packet* pkt) {
 
   switch (pkt->header & PH_TYPE_MASK) {
     case PH_TYPE_ANNOUNCE: {
-      int i = 0;
-      Identity id;
-      memcpy(id.pub_key, &pkt->payload[i], PUB_KEY_SIZE); i += PUB_KEY_SIZE;
-
-      uint8_t* name_hash = &pkt->payload[i]; i += NAME_HASH_SIZE;
-      uint8_t* rand_blob = &pkt->payload[i]; i += 8;
-      uint8_t* signature = &pkt->payload[i]; i += SIGNATURE_SIZE;
+      uint8_t extra_cost = getLinkCost(pkt) - 1;   // weight marginal links as more than one hop
+      pkt->path_cost = (pkt->hops > 255 - extra_cost) ? 255 : pkt->hops + extra_cost;   // NOTE: 'hops' stays a hop count
 
       // destination hash can now be calculated
-      Utils::sha256(pkt->destination_hash, DEST_HASH_SIZE, name_hash, NAME_HASH_SIZE, id.pub_key, PUB_KEY_SIZE); // dest = hash(name_hash + id)
+      Utils::sha256(pkt->destination_hash, DEST_HASH_SIZE, &pkt->payload[PUB_KEY_SIZE], NAME_HASH_SIZE, pkt->payload, PUB_KEY_SIZE); // dest = hash(name_hash + id)
 
-      if (i > pkt->payload_len) {
+      if (pkt->payload_len < ANNOUNCE_APP_DATA_OFS) {
         RIPPLE_DEBUG_PRINTLN("Mesh::onRecvPacket(): incomplete announce packet");
+      } else if (isAnnounceStale(pkt, &pkt->payload[ANNOUNCE_RAND_BLOB_OFS])) {
+        n_announce_stale++;   // not worth the cost of verifying
       } else {
-        uint8_t* app_data = &pkt->payload[i];
-        int app_data_len = pkt->payload_len - i;
-        if (app_data_len > MAX_APP_DATA_SIZE) { app_data_len = MAX_APP_DATA_SIZE; }
-
-        // check that signature is valid
-        bool is_ok;
-        {
-          uint8_t message[NAME_HASH_SIZE + PUB_KEY_SIZE + 8 + MAX_APP_DATA_SIZE];
-          int msg_len = 0;
-          memcpy(&message[msg_len], name_hash, NAME_HASH_SIZE); msg_len += NAME_HASH_SIZE;
-          memcpy(&message[msg_len], id.pub_key, PUB_KEY_SIZE); msg_len += PUB_KEY_SIZE;
-          memcpy(&message[msg_len], rand_blob, 8); msg_len += 8;
-          memcpy(&message[msg_len], app_data, app_data_len); msg_len += app_data_len;
-
-          is_ok = id.verify(signature, message, msg_len);
-        }
-        if (is_ok) {
-          RIPPLE_DEBUG_PRINTLN("Mesh::onRecvPacket(): valid announce received!");
-          if (isAnnounceNew(pkt, id, rand_blob, app_data, app_data_len)) { // this also acts as a filter for apps
-            action = onAnnounceRecv(pkt, id, rand_blob, app_data, app_data_len);
+        uint8_t key[VERIFIED_SIG_HASH_SIZE];
+        calcAnnounceKey(key, pkt);
+
+        if (isAnnounceVerified(key)) {
+          n_verify_saved++;   // already verified this exact announce
+          action = onAnnounceVerified(pkt);
+        } else if (ANNOUNCE_VERIFY_BATCH > 1) {
+          // defer, to verify together with other Announces
+          if (_ann_batch_count == 0) _ann_batch_deadline = futureMillis(ANNOUNCE_BATCH_MILLIS);
+          memcpy(&_ann_batch_keys[_ann_batch_count*VERIFIED_SIG_HASH_SIZE], key, VERIFIED_SIG_HASH_SIZE);
+          _ann_batch[_ann_batch_count++] = pkt;
+          action = ACTION_MANUAL_HOLD;
+
+          if (_ann_batch_count == ANNOUNCE_VERIFY_BATCH) flushAnnounceBatch();
+        } else {
+          MsgFragment frags[4];
+          getAnnounceSignedFrags(pkt, frags);
+          if (Identity(pkt->payload).verify(&pkt->payload[ANNOUNCE_SIGNATURE_OFS], frags, 4)) {
+            addVerifiedAnnounce(key);
+            action = onAnnounceVerified(pkt);
           } else {
-            RIPPLE_DEBUG_PRINTLN("Mesh::onRecvPacket(): Announce being re-played, or app is not interested in this Announce");
+            RIPPLE_DEBUG_PRINTLN("Mesh::onRecvPacket(): announce signature forgery received!");
           }
-        } else {
-          RIPPLE_DEBUG_PRINTLN("Mesh::onRecvPacket(): announce signature forgery received!");
         }
       }
       break;
@@ -119,14 +238,10 @@ Packet* Mesh::createAnnounce(const char* dest_name, const LocalIdentity& id, con
   packet->payload_len = len;
 
   {
-    uint8_t message[NAME_HASH_SIZE + PUB_KEY_SIZE + 8 + MAX_APP_DATA_SIZE];
-    int msg_len = 0;
-    memcpy(&message[msg_len], name_hash, NAME_HASH_SIZE); msg_len += NAME_HASH_SIZE;
-    memcpy(&message[msg_len], id.pub_key, PUB_KEY_SIZE); msg_len += PUB_KEY_SIZE;
-    memcpy(&message[msg_len], rand_blob, 8); msg_len += 8;
-    memcpy(&message[msg_len], app_data, app_data_len); msg_len += app_data_len;
-
-    id.sign(signature, message, msg_len);
+    MsgFragment frags[4] = {
+      { name_hash, NAME_HASH_SIZE }, { id.pub_key, PUB_KEY_SIZE }, { rand_blob, 8 }, { app_data, app_data_len }
+    };
+    id.sign(signature, frags, 4);
   }
   prepareLocalAnnounce(packet, rand_blob);
 
@@ -185,13 +300,8 @@ Packet* Mesh::createReplySigned(const uint8_t* packet_hash, const LocalIdentity&
   rp->hops = 0;
   memcpy(rp->destination_hash, packet_hash, DEST_HASH_SIZE);
   {
-    uint8_t message[MAX_PACKET_PAYLOAD - SIGNATURE_SIZE + DEST_HASH_SIZE + PUB_KEY_SIZE];
-    int msg_len = 0;
-    memcpy(&message[msg_len], packet_hash, DEST_HASH_SIZE); msg_len += DEST_HASH_SIZE;
-    memcpy(&message[msg_len], id.pub_key, PUB_KEY_SIZE); msg_len += PUB_KEY_SIZE;
-    memcpy(&message[msg_len], reply, reply_len); msg_len += reply_len;
-
-    id.sign(rp->payload, message, msg_len);  // put signature at start of payload
+    MsgFragment frags[3] = { { packet_hash, DEST_HASH_SIZE }, { id.pub_key, PUB_KEY_SIZE }, { reply, reply_len } };
+    id.sign(rp->payload, frags, 3);  // put signature at start of payload
   }
   memcpy(&rp->payload[SIGNATURE_SIZE], reply, reply_len);  // append reply data after signature
   rp->payload_len = SIGNATURE_SIZE + reply_len;
@@ -202,13 +312,11 @@ Packet* Mesh::createReplySigned(const uint8_t* packet_hash, const LocalIdentity&
 }
 
 bool Mesh::verifyReplySigned(const Packet* packet, const Identity& id) {
-  uint8_t message[MAX_PACKET_PAYLOAD - SIGNATURE_SIZE + DEST_HASH_SIZE + PUB_KEY_SIZE];
-  int msg_len = 0;
-  memcpy(&message[msg_len], packet->destination_hash, DEST_HASH_SIZE); msg_len += DEST_HASH_SIZE;
-  memcpy(&message[msg_len], id.pub_key, PUB_KEY_SIZE); msg_len += PUB_KEY_SIZE;
-  memcpy(&message[msg_len], &packet->payload[SIGNATURE_SIZE], packet->payload_len - SIGNATURE_SIZE); msg_len += packet->payload_len - SIGNATURE_SIZE;
-
-  return id.verify(packet->payload, message, msg_len);  // signature is at start of payload
+  MsgFragment frags[3] = {
+    { packet->destination_hash, DEST_HASH_SIZE }, { id.pub_key, PUB_KEY_SIZE },
+    { &packet->payload[SIGNATURE_SIZE], (size_t) (packet->payload_len - SIGNATURE_SIZE) }
+  };
+  return id.verify(packet->payload, frags, 3);  // signature is at start of payload
 }
 
 }
\ No newline at end of file
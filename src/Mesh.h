@@ -20,16 +20,75 @@ public:
   virtual void setCurrentTime(uint32_t time) = 0;
 };
 
+// link cost (as added to an incoming Announce's hops, for its path_cost) by SNR of last hop. Defaults suit SF9 (demod floor approx -12.5 dB)
+#ifndef LINK_SNR_GOOD
+  #define LINK_SNR_GOOD   (-5.0f)     // at or above is cost 1
+#endif
+#ifndef LINK_SNR_FAIR
+  #define LINK_SNR_FAIR  (-10.0f)     // at or above is cost 2, otherwise cost 3
+#endif
+
+// number of recently verified Announce signatures to remember (so copies heard via other neighbours aren't re-verified)
+#ifndef VERIFIED_SIG_CACHE_SIZE
+  #define VERIFIED_SIG_CACHE_SIZE   16
+#endif
+#define VERIFIED_SIG_HASH_SIZE      16
+
+// number of incoming Announces to collect, and then verify their signatures together (much cheaper per signature).
+// 1 = verify each as received. Each pending Announce holds a Packet, plus SIG_BATCH_SCRATCH_SIZE bytes of RAM per slot.
+#ifndef ANNOUNCE_VERIFY_BATCH
+  #define ANNOUNCE_VERIFY_BATCH   1
+#endif
+#if ANNOUNCE_VERIFY_BATCH > 1 && !defined(ED25519_COFACTORED)
+  #error "ANNOUNCE_VERIFY_BATCH needs ED25519_COFACTORED, which changes which signatures are accepted (see ed_25519.h)"
+#endif
+// max time an Announce waits for the batch to fill
+#ifndef ANNOUNCE_BATCH_MILLIS
+  #define ANNOUNCE_BATCH_MILLIS  300
+#endif
+
 /**
  * \brief  The next layer in the basic Dispatcher task, Mesh recognises the particular Packet TYPES (eg. Announce),
  *     and provides virtual methods for sub-classes on handling incoming, and also preparing outbound Packets.
 */
 class Mesh : public Dispatcher {
+  uint8_t _verified_sigs[VERIFIED_SIG_CACHE_SIZE*VERIFIED_SIG_HASH_SIZE];
+  int _next_verified_idx;
+  uint32_t n_verify_saved, n_announce_stale;
+  Packet* _ann_batch[ANNOUNCE_VERIFY_BATCH];   // Announces waiting for batch verify
+  uint8_t _ann_batch_keys[ANNOUNCE_VERIFY_BATCH*VERIFIED_SIG_HASH_SIZE];
+  int _ann_batch_count;
+  unsigned long _ann_batch_deadline;
+  uint64_t _ann_batch_scratch[ANNOUNCE_VERIFY_BATCH > 1 ? ANNOUNCE_VERIFY_BATCH*SIG_BATCH_SCRATCH_SIZE/8 : 1];   // (8 byte aligned)
+  uint32_t n_batch_verifies, n_batch_fallbacks;
+
+  bool isAnnounceVerified(const uint8_t* key) const;
+  void addVerifiedAnnounce(const uint8_t* key);
+  void flushAnnounceBatch();
+  DispatcherAction onAnnounceVerified(Packet* pkt);
+
 protected:
   RTCClock* _rtc;
   RNG* _rng;
 
   DispatcherAction onRecvPacket(Packet* pkt) override;
+  uint32_t getBusyBackoffMillis(uint8_t attempt) override;
+
+  /**
+   * \brief  The cost of the link the given (incoming) Announce was just received over. Its extra over 1 is added to the
+   *      Announce's hops, as its 'path_cost', which the MeshTables rank paths by. 'hops' itself is left a plain hop count,
+   *      as it is on the wire (for hop limits, retransmit priority, and nodes without link costs), so path_cost only weighs
+   *      our own last hop, not marginal links further upstream.
+   * \returns  1 for a solid link (ie. same as plain hop count), more for marginal links.
+  */
+  virtual uint8_t getLinkCost(const Packet* packet) const;
+
+  /**
+   * \brief  A cheap pre-filter, called BEFORE the (expensive) signature check on incoming Announces.
+   *        NOTE: the Announce is NOT yet verified, so implementations must not change any state here.
+   * \returns  true, if this Announce is already known to be useless (eg. stale, or a duplicate), and should be discarded.
+  */
+  virtual bool isAnnounceStale(const Packet* packet, const uint8_t* rand_blob) { return false; }
 
   /**
    * \brief  This acts as a kind of 'filter' for the actual Application, and should only return true for incoming Announces which
@@ -92,14 +151,24 @@ protected:
   Mesh(Radio& radio, MillisecondClock& ms, RNG& rng, RTCClock& rtc, PacketManager& mgr)
     : Dispatcher(radio, ms, mgr), _rng(&rng), _rtc(&rtc)
   {
+    memset(_verified_sigs, 0, sizeof(_verified_sigs));
+    _next_verified_idx = 0;
+    n_verify_saved = n_announce_stale = 0;
+    _ann_batch_count = 0;
+    n_batch_verifies = n_batch_fallbacks = 0;
   }
 
 public:
   void begin();
-  void loop();
+  void loop() override;
+  unsigned long getNextWakeMillis() const override;
 
   RNG* getRNG() const { return _rng; }
   RTCClock* getRTCClock() const { return _rtc; }
+  uint32_t getNumVerifiesSaved() const { return n_verify_saved; }   // Announce signature checks skipped, as already verified
+  uint32_t getNumStaleAnnounces() const { return n_announce_stale; }   // Announces discarded before signature check
+  uint32_t getNumBatchVerifies() const { return n_batch_verifies; }   // batches of Announce signatures checked
+  uint32_t getNumBatchFallbacks() const { return n_batch_fallbacks; }   // batches which had a bad signature, so were re-checked one by one
 
   Packet* createAnnounce(const char* dest_name, const LocalIdentity& id, const uint8_t* app_data=NULL, size_t app_data_len=0);
   Packet* createDatagram(const Destination* destination, const uint8_t* payload, int len, bool wantReply=false);
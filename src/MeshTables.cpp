@@ -2,31 +2,155 @@
 
 namespace ripple {
 
+uint32_t DestPathEntry::getAnnounceTimestamp() const {
+  uint32_t timestamp;
+  memcpy(&timestamp, rand_blob, 4);
+  return timestamp;
+}
+
+void DestPathEntry::setOrigAnnounce(const Packet* announce_pkt) {
+  hops = announce_pkt->hops;
+  path_cost = announce_pkt->path_cost;
+  header = announce_pkt->header;
+  flags = 0;   // have all of the Announce now
+  memcpy(transport_id, announce_pkt->transport_id, DEST_HASH_SIZE);
+
+  int i = 0;
+  memcpy(pub_key, &announce_pkt->payload[i], PUB_KEY_SIZE); i += PUB_KEY_SIZE;
+  memcpy(name_hash, &announce_pkt->payload[i], NAME_HASH_SIZE); i += NAME_HASH_SIZE;
+  memcpy(rand_blob, &announce_pkt->payload[i], 8); i += 8;
+  memcpy(signature, &announce_pkt->payload[i], SIGNATURE_SIZE); i += SIGNATURE_SIZE;
+
+  int len = announce_pkt->payload_len - i;
+  if (len > MAX_APP_DATA_SIZE) { len = MAX_APP_DATA_SIZE; }   // NOTE: signature only covers this much app_data
+  app_data_len = len;
+  memcpy(app_data, &announce_pkt->payload[i], len);
+}
+
+void DestPathEntry::getOrigAnnounce(const uint8_t* dest_hash, Packet* announce_pkt) const {
+  announce_pkt->header = header;
+  announce_pkt->hops = hops;
+  announce_pkt->path_cost = path_cost;
+  memcpy(announce_pkt->destination_hash, dest_hash, DEST_HASH_SIZE);
+  memcpy(announce_pkt->transport_id, transport_id, DEST_HASH_SIZE);
+
+  int i = 0;
+  memcpy(&announce_pkt->payload[i], pub_key, PUB_KEY_SIZE); i += PUB_KEY_SIZE;
+  memcpy(&announce_pkt->payload[i], name_hash, NAME_HASH_SIZE); i += NAME_HASH_SIZE;
+  memcpy(&announce_pkt->payload[i], rand_blob, 8); i += 8;
+  memcpy(&announce_pkt->payload[i], signature, SIGNATURE_SIZE); i += SIGNATURE_SIZE;
+  memcpy(&announce_pkt->payload[i], app_data, app_data_len); i += app_data_len;
+  announce_pkt->payload_len = i;
+}
+
+void DestPathEntry::getNextHop(const uint8_t* dest_hash, uint8_t* next_hop) const {
+  if (header & PH_HAS_TRANS_ADDRESS) {
+    memcpy(next_hop, transport_id, DEST_HASH_SIZE);  // transport_id is next hop
+  } else {
+    memcpy(next_hop, dest_hash, DEST_HASH_SIZE);  // is in immediate vicinity
+  }
+}
+
+bool DestPathEntry::isUsefulAlt(const uint8_t* next_hop, uint8_t alt_cost) const {
+  for (int i = 0; i < num_alts; i++) {
+    if (memcmp(alts[i].next_hop, next_hop, DEST_HASH_SIZE) == 0) return alt_cost < alts[i].path_cost;  // only if better
+  }
+  return num_alts < MAX_ALT_HOPS || alt_cost < alts[num_alts - 1].path_cost;
+}
+
+bool DestPathEntry::addAltNextHop(const uint8_t* next_hop, uint8_t alt_hops, uint8_t alt_cost) {
+  if (!isUsefulAlt(next_hop, alt_cost)) return false;
+
+  int i = 0;
+  while (i < num_alts && memcmp(alts[i].next_hop, next_hop, DEST_HASH_SIZE) != 0) i++;
+  if (i == num_alts) {   // not already an alternate
+    if (num_alts < MAX_ALT_HOPS) num_alts++;
+    i = num_alts - 1;    // (replaces the worst, if full)
+  }
+  // shuffle up, to keep ranked by path_cost
+  while (i > 0 && alts[i - 1].path_cost > alt_cost) {
+    alts[i] = alts[i - 1];
+    i--;
+  }
+  alts[i].hops = alt_hops;
+  alts[i].path_cost = alt_cost;
+  memcpy(alts[i].next_hop, next_hop, DEST_HASH_SIZE);
+  return true;
+}
+
+bool DestPathEntry::promoteAltNextHop(const uint8_t* dest_hash) {
+  if (num_alts == 0) return false;
+
+  hops = alts[0].hops;
+  path_cost = alts[0].path_cost;
+  if (memcmp(alts[0].next_hop, dest_hash, DEST_HASH_SIZE) == 0) {
+    header &= ~PH_HAS_TRANS_ADDRESS;   // is in immediate vicinity
+    memset(transport_id, 0, DEST_HASH_SIZE);
+  } else {
+    header |= PH_HAS_TRANS_ADDRESS;
+    memcpy(transport_id, alts[0].next_hop, DEST_HASH_SIZE);
+  }
+  num_alts--;
+  memmove(&alts[0], &alts[1], num_alts * sizeof(alts[0]));
+  return true;
+}
+
+bool MeshTables::isPathExpired(const DestPathEntry* entry) const {
+  return (int32_t)(_rtc->getCurrentTime() - entry->create_timestamp) > PATH_EXPIRY_SECS;
+}
+
 bool MeshTables::hasNextHop(const uint8_t* dest_hash) {
   uint32_t handle;
-  return lookupDest(dest_hash, handle) /* && not expired */;
+  return lookupDest(dest_hash, handle) && !isPathExpired(getDestEntry(handle));
 }
 
 bool MeshTables::updateNextHop(const uint8_t* dest_hash, const ripple::Packet* announce_pkt) {
   uint32_t now = _rtc->getCurrentTime();   // this is by OUR clock
   uint32_t newTimestamp = announce_pkt->getAnnounceTimestamp(); // this is by THEIR clock
 
-  RIPPLE_DEBUG_PRINTLN("updateNextHop, newTimestamp=%d, hops=%d", newTimestamp, (int) announce_pkt->hops);
+  RIPPLE_DEBUG_PRINTLN("updateNextHop, newTimestamp=%d, hops=%d, cost=%d", newTimestamp, (int) announce_pkt->hops, (int) announce_pkt->path_cost);
 
   uint32_t i;
-  DestPathEntry entry;
-  if (lookupDest(dest_hash, i, &entry)) {
-    uint32_t oldTimestamp = entry.orig_announce.getAnnounceTimestamp();
+  if (lookupDest(dest_hash, i)) {
+    const DestPathEntry* entry = getDestEntry(i);
+    uint32_t oldTimestamp = entry->getAnnounceTimestamp();
 
-    RIPPLE_DEBUG_PRINTLN("  oldTimestamp=%d, old.hops=%d", oldTimestamp, (int) entry.hops);
+    RIPPLE_DEBUG_PRINTLN("  oldTimestamp=%d, old.hops=%d, old.cost=%d", oldTimestamp, (int) entry->hops, (int) entry->path_cost);
 
     if (newTimestamp < oldTimestamp) return false;  // is an OLD anounce (can't go back in time)
 
     if (newTimestamp == oldTimestamp) {  // same announce, but arriving via different path
-      if (now > entry.create_timestamp + LATE_ANNOUNCE_SECS) {
+      if (now > entry->create_timestamp + LATE_ANNOUNCE_SECS) {
         return false;   // this announce is too late to be considered
       }
-      if (announce_pkt->hops >= entry.hops) return false;  // not a better path
+      uint8_t next_hop[DEST_HASH_SIZE], curr_hop[DEST_HASH_SIZE];
+      announceNextHop(dest_hash, announce_pkt, next_hop);
+      entry->getNextHop(dest_hash, curr_hop);
+      if (memcmp(next_hop, curr_hop, DEST_HASH_SIZE) == 0 && announce_pkt->path_cost >= entry->path_cost) return false;  // same path
+
+      if (announce_pkt->path_cost >= entry->path_cost) {  // not a better path, but keep as an alternate
+        if (editNextHops(i)->addAltNextHop(next_hop, announce_pkt->hops, announce_pkt->path_cost)) {
+          saveNextHops(i);
+        }
+        return false;   // primary path is unchanged, so no need to forward this announce
+      }
+      DestPathEntry updated = *entry;
+      // is better path, so current primary becomes an alternate
+      if (memcmp(next_hop, curr_hop, DEST_HASH_SIZE) != 0) updated.addAltNextHop(curr_hop, entry->hops, entry->path_cost);
+      updated.create_timestamp = now;
+      updated.last_timestamp = now;
+      updated.setOrigAnnounce(announce_pkt);
+
+      // new primary shouldn't also be an alternate
+      for (int j = 0; j < updated.num_alts; j++) {
+        if (memcmp(updated.alts[j].next_hop, next_hop, DEST_HASH_SIZE) == 0) {
+          updated.num_alts--;
+          memmove(&updated.alts[j], &updated.alts[j + 1], (updated.num_alts - j) * sizeof(updated.alts[0]));
+          break;
+        }
+      }
+      saveDest(i, dest_hash, updated);
+      return true;
     } else {
       // is a new Announce, so trumps whatever is currently in destination table
     }
@@ -36,29 +160,67 @@ bool MeshTables::updateNextHop(const uint8_t* dest_hash, const ripple::Packet* a
     if (i == NIL_TABLE_HANDLE) return false;  // all Dest slots are currently 'busy'
   }
 
-  entry.hops = announce_pkt->hops;
+  DestPathEntry entry;
   entry.create_timestamp = now;
   entry.last_timestamp = now;
-  entry.orig_announce = *announce_pkt;  // keep a copy of announce packet
+  entry.num_alts = 0;
+  entry.setOrigAnnounce(announce_pkt);  // keep the needed parts of announce packet (incl. hops, path_cost)
 
   saveDest(i, dest_hash, entry);
   return true;   // table now changed
 }
 
-bool MeshTables::getNextHop(const uint8_t* dest_hash, uint8_t* next_hop) {
+bool MeshTables::isAnnounceStale(const uint8_t* dest_hash, const ripple::Packet* announce_pkt) {
   uint32_t i;
-  DestPathEntry entry;
+  if (lookupDest(dest_hash, i)) {
+    const DestPathEntry* entry = getDestEntry(i);
+    uint32_t newTimestamp = announce_pkt->getAnnounceTimestamp();
+    uint32_t oldTimestamp = entry->getAnnounceTimestamp();
 
-  if (lookupDest(dest_hash, i, &entry) /* && not expired */) {
-    const ripple::Packet* announce_pkt = &entry.orig_announce;
-    if (announce_pkt->header & PH_HAS_TRANS_ADDRESS) {
-      memcpy(next_hop, announce_pkt->transport_id, DEST_HASH_SIZE);  // transport_id is next hop
-    } else {
-      memcpy(next_hop, announce_pkt->destination_hash, DEST_HASH_SIZE);  // is in immediate vicinity
+    if (newTimestamp < oldTimestamp) return true;  // is an OLD anounce
+
+    if (newTimestamp == oldTimestamp) {  // same announce, but arriving via different path
+      if (_rtc->getCurrentTime() > entry->create_timestamp + LATE_ANNOUNCE_SECS) return true;  // too late
+      if (announce_pkt->path_cost >= entry->path_cost) {  // not a better path, but could be a new alternate
+        uint8_t next_hop[DEST_HASH_SIZE], curr_hop[DEST_HASH_SIZE];
+        announceNextHop(dest_hash, announce_pkt, next_hop);
+        entry->getNextHop(dest_hash, curr_hop);
+        return memcmp(next_hop, curr_hop, DEST_HASH_SIZE) == 0 || !entry->isUsefulAlt(next_hop, announce_pkt->path_cost);
+      }
+    }
+    return false;
+  }
+  return false;  // not in table (eg. evicted, or expired), so is new to us, even if already forwarded
+}
+
+void MeshTables::announceNextHop(const uint8_t* dest_hash, const Packet* announce_pkt, uint8_t* next_hop) {
+  if (announce_pkt->header & PH_HAS_TRANS_ADDRESS) {
+    memcpy(next_hop, announce_pkt->transport_id, DEST_HASH_SIZE);
+  } else {
+    memcpy(next_hop, dest_hash, DEST_HASH_SIZE);  // heard directly from destination
+  }
+}
+
+void MeshTables::nextHopOf(uint32_t handle, uint8_t* next_hop) const {
+  getDestEntry(handle)->getNextHop(getDestHash(handle), next_hop);
+}
+
+bool MeshTables::failoverNextHop(const uint8_t* dest_hash) {
+  uint32_t i;
+  if (lookupDest(dest_hash, i) && !isPathExpired(getDestEntry(i))) {
+    if (editNextHops(i)->promoteAltNextHop(dest_hash)) {
+      saveNextHops(i);
+      return true;
     }
+  }
+  return false;
+}
 
-    entry.last_timestamp = _rtc->getCurrentTime();
-    saveDest(i, dest_hash, entry);
+bool MeshTables::getNextHop(const uint8_t* dest_hash, uint8_t* next_hop) {
+  uint32_t i;
+  if (lookupDest(dest_hash, i) && !isPathExpired(getDestEntry(i))) {
+    nextHopOf(i, next_hop);
+    touch(i);
     return true;
   }
   return false;  // destination not known
@@ -66,13 +228,23 @@ bool MeshTables::getNextHop(const uint8_t* dest_hash, uint8_t* next_hop) {
 
 uint32_t MeshTables::getOrigAnnounce(const uint8_t* dest_hash, ripple::Packet* announce_pkt) {
   uint32_t i;
-  DestPathEntry entry;
+  if (lookupDest(dest_hash, i) && !isPathExpired(getDestEntry(i))) {
+    const DestPathEntry* entry = getDestEntry(i);
+    if (entry->flags & DEST_FLAG_PARTIAL) return 0;
 
-  if (lookupDest(dest_hash, i, &entry) /* && not expired */) {
-    *announce_pkt = entry.orig_announce;
-    return entry.create_timestamp;   // when entry was created (by OUR clock)
+    entry->getOrigAnnounce(dest_hash, announce_pkt);
+    return entry->create_timestamp;   // when entry was created (by OUR clock)
   }
   return 0;   // destination not known
 }
 
+bool MeshTables::getDestPubKey(const uint8_t* dest_hash, uint8_t* pub_key) {
+  uint32_t i;
+  if (lookupDest(dest_hash, i) && !isPathExpired(getDestEntry(i))) {
+    memcpy(pub_key, getDestEntry(i)->pub_key, PUB_KEY_SIZE);
+    return true;
+  }
+  return false;   // destination not known
+}
+
 }
\ No newline at end of file
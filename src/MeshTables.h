@@ -6,11 +6,82 @@ namespace ripple {
 
 #define LATE_ANNOUNCE_SECS   (1*60)  // one minute
 
-struct DestPathEntry {
+// paths expire this long after their Announce was received (unless a newer Announce refreshes them)
+#ifndef PATH_EXPIRY_SECS
+  #define PATH_EXPIRY_SECS   (24*60*60)
+#endif
+// packet_hash -> destination mappings (for forwarding signed replies) expire after this
+#ifndef MAPPING_EXPIRY_SECS
+  #define MAPPING_EXPIRY_SECS   (10*60)
+#endif
+
+// max number of alternate next-hops kept per destination (for failover)
+#ifndef MAX_ALT_HOPS
+  #define MAX_ALT_HOPS   2
+#endif
+
+#define DEST_FLAG_PARTIAL   0x01   // restored from a checkpoint without signature and app_data, so can't replay the Announce
+
+struct AltNextHop {
   uint8_t  hops;
+  uint8_t  path_cost;
+  uint8_t  next_hop[DEST_HASH_SIZE];
+};
+
+/**
+ * \brief  A path to a Destination. Holds just the fields of the original Announce that routing, and 'path.request' replays,
+ *       need (rather than a whole Packet), so is 188 bytes per entry (with MAX_ALT_HOPS = 2), instead of 288.
+*/
+struct DestPathEntry {
   uint32_t create_timestamp;
   uint32_t last_timestamp;
-  ripple::Packet orig_announce;
+  uint8_t  hops;
+  uint8_t  path_cost;   // what paths are ranked by (see Packet::path_cost)
+  uint8_t  header;   // of original Announce
+  uint8_t  app_data_len;
+  uint8_t  num_alts;
+  uint8_t  flags;    // DEST_FLAG_*
+  AltNextHop alts[MAX_ALT_HOPS];   // next-hops heard in same Announce round, ranked best first
+  uint8_t  transport_id[DEST_HASH_SIZE];
+  uint8_t  pub_key[PUB_KEY_SIZE];
+  uint8_t  name_hash[NAME_HASH_SIZE];
+  uint8_t  rand_blob[8];   // first 4 bytes are the Announce timestamp
+  uint8_t  signature[SIGNATURE_SIZE];
+  uint8_t  app_data[MAX_APP_DATA_SIZE];
+
+  uint32_t getAnnounceTimestamp() const;
+
+  /**
+   * \brief  keep the needed fields of given Announce packet.
+  */
+  void setOrigAnnounce(const Packet* announce_pkt);
+
+  /**
+   * \brief  re-builds the original Announce packet.
+  */
+  void getOrigAnnounce(const uint8_t* dest_hash, Packet* announce_pkt) const;
+
+  /**
+   * \brief  the primary next-hop.
+  */
+  void getNextHop(const uint8_t* dest_hash, uint8_t* next_hop) const;
+
+  /**
+   * \returns  true if the given next-hop (not the primary) would be kept by addAltNextHop()
+  */
+  bool isUsefulAlt(const uint8_t* next_hop, uint8_t alt_cost) const;
+
+  /**
+   * \brief  inserts (by rank) into the alternate next-hops. Worst is dropped, if already MAX_ALT_HOPS.
+   * \returns  true if alternates were changed.
+  */
+  bool addAltNextHop(const uint8_t* next_hop, uint8_t alt_hops, uint8_t alt_cost);
+
+  /**
+   * \brief  replaces the primary next-hop with the best alternate.
+   * \returns  false if there are no alternates.
+  */
+  bool promoteAltNextHop(const uint8_t* dest_hash);
 };
 
 #define NIL_TABLE_HANDLE   ((uint32_t) -1)
@@ -48,6 +119,52 @@ protected:
   */
   virtual bool saveDest(uint32_t handle, const uint8_t* hash, const DestPathEntry& dest) = 0;
 
+  /**
+   * \returns  the entry for given handle, in-place (ie. no copy). Only valid until table is next modified.
+  */
+  virtual const DestPathEntry* getDestEntry(uint32_t handle) const = 0;
+
+  /**
+   * \returns  the destination hash (key) for given handle, in-place.
+  */
+  virtual const uint8_t* getDestHash(uint32_t handle) const = 0;
+
+  /**
+   * \brief  the entry for given handle, in-place, for changing just its next-hop fields (hops, path_cost, header, transport_id and
+   *       alternates). Call saveNextHops() after.
+  */
+  virtual DestPathEntry* editNextHops(uint32_t handle) = 0;
+
+  /**
+   * \brief  save the change made (in-place) by editNextHops(). eg. to journal just those fields.
+  */
+  virtual void saveNextHops(uint32_t handle) = 0;
+
+  /**
+   * \brief  marks the entry as Recently Used, ie. sets last_timestamp to now. (for eviction algorithm)
+  */
+  virtual void touch(uint32_t handle) = 0;
+
+  /**
+   * \brief  copies the transport_id of next-hop, for the given entry, to 'next_hop'.
+  */
+  void nextHopOf(uint32_t handle, uint8_t* next_hop) const;
+
+  /**
+   * \brief  the next-hop, ie. who we heard the given Announce from.
+  */
+  static void announceNextHop(const uint8_t* dest_hash, const Packet* announce_pkt, uint8_t* next_hop);
+
+  /**
+   * \brief  removes the entry, making the slot free.
+  */
+  virtual void removeDest(uint32_t handle) = 0;
+
+  /**
+   * \returns  true if the path in given entry is older than PATH_EXPIRY_SECS.
+  */
+  bool isPathExpired(const DestPathEntry* entry) const;
+
 public:
   virtual bool hasForwarded(const uint8_t* rand_blob) const = 0;
   virtual void setHasForwarded(const uint8_t* rand_blob) = 0;
@@ -59,6 +176,13 @@ public:
   virtual void setPacketHashDest(const uint8_t* packet_hash, const uint8_t* destination_hash) = 0;
   virtual void clearPacketHashDest(const uint8_t* packet_hash) = 0;
 
+  /**
+   * \brief  Incrementally removes expired paths, and packet_hash mappings. Continues from where previous call left off.
+   * \param  max_entries  the max number of table entries to examine in this call. (to bound the time spent)
+   * \returns  the number of entries removed.
+  */
+  virtual int sweepExpired(int max_entries) = 0;
+
   /**
    * \returns true if the dest_hash is known to this node.
   */
@@ -70,6 +194,20 @@ public:
   */
   bool updateNextHop(const uint8_t* dest_hash, const Packet* announce_pkt);  // returns true if tables now changed
 
+  /**
+   * \brief  Read-only check of whether updateNextHop() would reject this Announce, ie. it is older than the one in table,
+   *        arrived later than LATE_ANNOUNCE_SECS, or is from a path no better.
+   * \returns true if the Announce is of no use to the tables.
+  */
+  bool isAnnounceStale(const uint8_t* dest_hash, const Packet* announce_pkt);
+
+  /**
+   * \brief  The current next-hop for dest_hash is assumed to have failed, so switch to the best alternate next-hop.
+   *     (alternates are kept from the same Announce round, so no new Announce is needed)
+   * \returns  true if there was an alternate to switch to.
+  */
+  bool failoverNextHop(const uint8_t* dest_hash);
+
   /**
    * Lookup the next-hop for the given dest_hash. Also updates timestamp to indicate this path has bee Recently Used. (for eviction algorithm)
    * \param  dest_hash IN - the Destination hash to lookup.
@@ -82,10 +220,16 @@ public:
    * \brief   Lookup the original Announce packet which informed the next-hop to given dest_hash. (ie. the best path)
    * \param dest_hash IN - the Destintion
    * \param announce_pkt OUT - A copy of the original Announce we received for given dest_hash.
-   * \returns 0 if not found, otherwise timestamp when we received announce (by local RTC clock)
+   * \returns 0 if not found (or only a partial entry is held), otherwise timestamp when we received announce (by local RTC clock)
   */
   uint32_t getOrigAnnounce(const uint8_t* dest_hash, Packet* announce_pkt);
 
+  /**
+   * \brief   Lookup the public key of the announcer of given dest_hash.
+   * \returns  true if found
+  */
+  bool getDestPubKey(const uint8_t* dest_hash, uint8_t* pub_key);
+
   /**
    * \brief  For diagnostics.
    * \param max_age_secs  The maximum time, in seconds, since a Destination was 'active', ie. had some traffic.
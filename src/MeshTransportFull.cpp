@@ -6,6 +6,21 @@ namespace ripple {
 #define  ANNOUNCE_DELAY_MAX  6000   // in milliseconds
 #define  ANNOUNCE_DELAY_MIN  4000
 
+// expiry sweeper examines this many table entries, every SWEEP_INTERVAL_MILLIS
+#ifndef SWEEP_ENTRIES_PER_STEP
+  #define SWEEP_ENTRIES_PER_STEP   8
+#endif
+#ifndef SWEEP_INTERVAL_MILLIS
+  #define SWEEP_INTERVAL_MILLIS  1000
+#endif
+
+bool MeshTransportFull::isAnnounceStale(const Packet* packet, const uint8_t* rand_blob) {
+  if (isAnnounceAwaited(packet)) return false;  // need to check these (confirmations, etc)
+
+  // onAnnounceRecv() would just ignore these, so don't bother verifying them
+  return _tables->isAnnounceStale(packet->destination_hash, packet);
+}
+
 DispatcherAction MeshTransportFull::onAnnounceRecv(Packet* packet, const Identity& id, const uint8_t* rand_blob, const uint8_t* app_data, size_t app_data_len) {
   if (_tables->updateNextHop(packet->destination_hash, packet) && !_tables->hasForwarded(rand_blob)) {
     _tables->setHasForwarded(rand_blob);
@@ -30,6 +45,22 @@ void MeshTransportFull::onBeforeAnnounceRetransmit(Packet* packet) {
   packet->header |= PH_HAS_TRANS_ADDRESS;
 }
 
+bool MeshTransportFull::isDatagramNew(Packet* packet, const uint8_t* packet_hash) {
+  int code = _tables->getSeenPacketHash(packet_hash);
+  if (code == 2 && (packet->header & PH_TYPE_KEEP_PATH) && (packet->header & PH_HAS_TRANS_ADDRESS)) {
+    Destination dest(self_id, "trans.data");
+    if (dest.matches(packet->transport_id)) {
+      // sender is re-trying a datagram which we already forwarded, and no reply has come back through us (code is still 2).
+      //  So, assume our next-hop has failed, and forward this copy via an alternate next-hop.
+      if (_tables->failoverNextHop(packet->destination_hash)) {
+        n_failovers++;
+        return true;
+      }
+    }
+  }
+  return code == 0;
+}
+
 DispatcherAction MeshTransportFull::onDatagramRecv(Packet* packet, const uint8_t* packet_hash) {
   Destination dest(self_id, "trans.data");
   if (dest.matches(packet->destination_hash)) {  // this node IS the destination
@@ -84,7 +115,16 @@ void MeshTransportFull::begin() {
 void MeshTransportFull::loop() {
   MeshTransportNone::loop();
 
-  // TODO: scan for stale paths, delete the entries from table
+  // incrementally scan for stale paths, and delete the entries from table.
+  //  NOTE: don't need to wake up for this, as expired entries are also ignored by lookups
+  if (millisHasNowPassed(next_sweep)) {
+    unsigned long start = _ms->getMicros();
+    n_expired += _tables->sweepExpired(SWEEP_ENTRIES_PER_STEP);
+    uint32_t elapsed = _ms->getMicros() - start;
+    if (elapsed > max_sweep_micros) max_sweep_micros = elapsed;
+
+    next_sweep = futureMillis(SWEEP_INTERVAL_MILLIS);
+  }
 }
 
 }
\ No newline at end of file
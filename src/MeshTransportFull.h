@@ -8,8 +8,15 @@ namespace ripple {
  * \brief  Applications that also take on the 'Transport node' role should sub-class this. eg. Repeaters.
 */
 class MeshTransportFull : public MeshTransportNone {
+  unsigned long next_sweep;
+  uint32_t n_expired;
+  uint32_t max_sweep_micros;
+  uint32_t n_failovers;
+
 protected:
+  bool isAnnounceStale(const Packet* packet, const uint8_t* rand_blob) override;
   DispatcherAction onAnnounceRecv(Packet* packet, const Identity& id, const uint8_t* rand_blob, const uint8_t* app_data, size_t app_data_len) override;
+  bool isDatagramNew(Packet* packet, const uint8_t* packet_hash) override;
   DispatcherAction onDatagramRecv(Packet* packet, const uint8_t* packet_hash) override;
   DispatcherAction onReplyRecv(Packet* packet) override;
   DispatcherAction onReplySignedRecv(Packet* packet, const uint8_t* reply, size_t reply_len) override;
@@ -29,9 +36,16 @@ public:
     : MeshTransportNone(radio, ms, rng, rtc, mgr, tables)
   {
     max_hops_supported = 64;  // some standard default?
+    next_sweep = 0;
+    n_expired = max_sweep_micros = 0;
+    n_failovers = 0;
   }
   void begin();
-  void loop();
+  void loop() override;
+
+  uint32_t getNumExpired() const { return n_expired; }   // paths and mappings removed by expiry sweeper
+  uint32_t getMaxSweepMicros() const { return max_sweep_micros; }   // longest time spent in one sweeper step
+  uint32_t getNumFailovers() const { return n_failovers; }   // times switched to an alternate next-hop
 };
 
 }
\ No newline at end of file
@@ -44,6 +44,19 @@ bool MeshTransportNone::isAnnounceNew(Packet* packet, const Identity& id, const
   return true;
 }
 
+bool MeshTransportNone::isAnnounceAwaited(const Packet* packet) {
+  if (curr_self_announce && memcmp(curr_self_announce->destination_hash, packet->destination_hash, DEST_HASH_SIZE) == 0) {
+    return true;
+  }
+  for (int i = 0; i < _mgr->getOutboundCount(); i++) {
+    Packet* outbound = _mgr->getOutboundByIdx(i);
+    if (outbound->getPacketType() == PH_TYPE_ANNOUNCE && memcmp(packet->destination_hash, outbound->destination_hash, DEST_HASH_SIZE) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void MeshTransportNone::onBeforeAnnounceRetransmit(Packet* packet) {
   // no-op
 }
@@ -99,10 +112,8 @@ bool MeshTransportNone::isReplySignedNew(Packet* packet) {
   // lookup original dest_hash by packet_hash
   uint8_t orig_dest_hash[DEST_HASH_SIZE];
   if (_tables->getPacketHashDest(packet->destination_hash, orig_dest_hash)) {
-    Packet orig_announce;
-    if (_tables->getOrigAnnounce(orig_dest_hash, &orig_announce)) {
-      Identity id;
-      memcpy(id.pub_key, orig_announce.getAnnouncePubKey(), PUB_KEY_SIZE);
+    Identity id;
+    if (_tables->getDestPubKey(orig_dest_hash, id.pub_key)) {
       // verify signature
       if (verifyReplySigned(packet, id)) {  // this reply SHOULD be signed by the announcer of original destination
         _tables->clearPacketHashDest(packet->destination_hash);  // prevent duplicates, if we receive this reply again
@@ -229,4 +240,12 @@ void MeshTransportNone::loop() {
   }
 }
 
+unsigned long MeshTransportNone::getNextWakeMillis() const {
+  unsigned long wake = Mesh::getNextWakeMillis();
+  if (confirmation_timeout) {
+    wake = soonerMillis(wake, confirmation_timeout);
+  }
+  return wake;
+}
+
 }
\ No newline at end of file
@@ -29,6 +29,11 @@ protected:
 
   virtual void onBeforeAnnounceRetransmit(Packet* packet);
 
+  /**
+   * \returns  true, if this node is waiting on the given Announce, ie. as a confirmation of our own, or to cancel one we have queued.
+  */
+  bool isAnnounceAwaited(const Packet* packet);
+
   void prepareLocalAnnounce(Packet* packet, const uint8_t* rand_blob) override;
   void prepareLocalDatagram(Packet* packet) override;
   void prepareLocalReply(Packet* packet) override;
@@ -43,7 +48,9 @@ public:
     }
 
   void begin();
-  void loop();
+  void loop() override;
+
+  unsigned long getNextWakeMillis() const override;
 
   /**
    * \brief   A helper method for looking up if we have a path, ie next-hop, to given dest_hash. Optionally retrieving
@@ -58,6 +65,13 @@ public:
   */
   bool requestPathTo(const uint8_t* dest_hash);
 
+  /**
+   * \brief  For when the application thinks the path to dest_hash has failed, eg. no reply to a datagram. Switches to an
+   *       alternate next-hop (if any were heard in the same Announce round), so a re-try can go a different way.
+   * \returns  true if there was an alternate next-hop.
+  */
+  bool failoverPathTo(const uint8_t* dest_hash) { return _tables->failoverNextHop(dest_hash); }
+
   /**
    * \brief  Sends an announce packet, optionally re-sending if no 'confirmations' received
    * \param confirm_timeout_secs  
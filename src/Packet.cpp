@@ -1,13 +1,24 @@
 #include "Packet.h"
 #include <string.h>
-#include <SHA256.h>
+#include "CryptoProvider.h"
 
 namespace ripple {
 
-Packet::Packet() {
+Packet::Packet() : payload(&frame[MAX_WIRE_PREFIX]) {
   header = 0;
   hops = 0;
   payload_len = 0;
+  recv_snr = 0;
+  recv_rssi = 0;
+  path_cost = 0;
+}
+
+uint8_t* Packet::getRawSendBuffer(int prefix_len) {
+  if (payload - frame < prefix_len) {   // eg. a received Announce, now forwarded with a transport_id
+    memmove(&frame[MAX_WIRE_PREFIX], payload, payload_len);
+    payload = &frame[MAX_WIRE_PREFIX];
+  }
+  return payload - prefix_len;
 }
 
 void Packet::setDestinationHash(Destination* dest) {
@@ -19,7 +30,7 @@ bool Packet::isDestination(const uint8_t* hash) {
 }
 
 void Packet::calculatePacketHash(uint8_t* hash) {
-  SHA256 sha;
+  CryptoSHA256 sha;
   uint8_t hdr = header & PH_TYPE_MASK;
   sha.update(&hdr, 1);
   sha.update(destination_hash, DEST_HASH_SIZE);
@@ -15,19 +15,51 @@ namespace ripple {
 #define PH_TYPE_KEEP_PATH    0x08   // combined with PH_TYPE_DATA (wants reply)
 #define PH_HAS_TRANS_ADDRESS 0x80
 
+// max bytes in raw frame, before the payload
+#ifdef NODE_ID
+  #define MAX_WIRE_PREFIX   (3 + 2*DEST_HASH_SIZE)   // node_id, header, hops, transport_id, destination_hash
+#else
+  #define MAX_WIRE_PREFIX   (2 + 2*DEST_HASH_SIZE)   // header, hops, transport_id, destination_hash
+#endif
+
 /**
  * \brief  The fundamental transmission unit.
 */
 class Packet {
 public:
   Packet();
+  Packet(const Packet&) = delete;              // 'payload' points into this instance's own 'frame'
+  Packet& operator=(const Packet&) = delete;
 
   uint8_t header;
   uint8_t hops;
   uint8_t destination_hash[DEST_HASH_SIZE];
   uint8_t transport_id[DEST_HASH_SIZE];
-  uint8_t payload[MAX_PACKET_PAYLOAD];
+  uint8_t frame[MAX_WIRE_PREFIX + MAX_PACKET_PAYLOAD];   // raw frame: the first MAX_WIRE_PREFIX bytes are scratch space for the frame header
+  uint8_t* payload;    // into 'frame': &frame[MAX_WIRE_PREFIX], or nearer the start if received with a shorter frame header.
+                       //  Always room for MAX_PACKET_PAYLOAD bytes
   uint16_t payload_len;
+  int8_t  recv_snr;    // SNR * 4 (ie. quarter dB) of the last hop, when received
+  int16_t recv_rssi;   // RSSI (dBm) of the last hop, when received
+  uint8_t path_cost;   // (not on the wire) of a received Announce: 'hops', plus extra for a marginal last hop. See Mesh::getLinkCost()
+
+  /**
+   * \returns  buffer for reading a raw frame, in-place. The Dispatcher parses the frame header, then just points 'payload'
+   *        at what follows it (so the payload is never moved on receive).
+  */
+  uint8_t* getRawRecvBuffer() { return frame; }
+  int getRawRecvBufferSize() const { return sizeof(frame); }
+
+  /**
+   * \returns  the start of the raw frame to send, with room for 'prefix_len' (<= MAX_WIRE_PREFIX) header bytes directly before the payload.
+   *        The payload is moved back to &frame[MAX_WIRE_PREFIX] only if it was received with a shorter frame header than this.
+  */
+  uint8_t* getRawSendBuffer(int prefix_len);
+
+  /**
+   * \brief  points 'payload' back at &frame[MAX_WIRE_PREFIX] (contents are not kept). eg. when returned to a pool.
+  */
+  void resetPayload() { payload = &frame[MAX_WIRE_PREFIX]; }
 
   void setDestinationHash(Destination* dest);
   bool isDestination(const uint8_t* hash);
@@ -35,6 +67,7 @@ public:
 
   // general helpers
   uint8_t getPacketType() const { return header & PH_TYPE_MASK; }
+  float getRecvSNR() const { return recv_snr / 4.0f; }
 
   // helper method for Announce packets
   uint32_t getAnnounceTimestamp() const;
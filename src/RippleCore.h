@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 
 #define DEST_HASH_SIZE       8
 #define NAME_HASH_SIZE       8
@@ -36,8 +37,25 @@ public:
   virtual const char* getManufacturerName() const = 0;
   virtual void onBeforeTransmit() { }
   virtual void onAfterTransmit() { }
+
+  /**
+   * \brief  low power wait, until the radio interrupt pin is raised, or 'max_millis' has elapsed.
+   *         Default is to return immediately (no low power support).
+   * \returns  true if woken by the radio interrupt
+  */
+  virtual bool sleepUntilRadioIRQ(uint32_t max_millis) { return false; }
   virtual void reboot() = 0;
   virtual uint8_t getStartupReason() const = 0;
 };
 
+/**
+ * \brief  A region of RAM which keeps its contents across deep sleep, and soft resets (but NOT power loss), eg. the
+ *         RTC slow memory on ESP32. Contents are undefined at first power on, so users must validate (eg. by CRC).
+*/
+class RetainedMemory {
+public:
+  virtual uint8_t* getBuffer() = 0;
+  virtual size_t getSize() const = 0;
+};
+
 }
\ No newline at end of file
@@ -1,6 +1,5 @@
 #include "Utils.h"
-#include <AES.h>
-#include <SHA256.h>
+#include "CryptoProvider.h"
 #include <Arduino.h>
 
 namespace ripple {
@@ -12,41 +11,44 @@ uint32_t RNG::nextInt(uint32_t _min, uint32_t _max) {
 }
 
 void Utils::sha256(uint8_t *hash, size_t hash_len, const uint8_t* msg, int msg_len) {
-  SHA256 sha;
+  CryptoSHA256 sha;
   sha.update(msg, msg_len);
   sha.finalize(hash, hash_len);
 }
 
 void Utils::sha256(uint8_t *hash, size_t hash_len, const uint8_t* frag1, int frag1_len, const uint8_t* frag2, int frag2_len) {
-  SHA256 sha;
+  CryptoSHA256 sha;
   sha.update(frag1, frag1_len);
   sha.update(frag2, frag2_len);
   sha.finalize(hash, hash_len);
 }
 
+void Utils::sha256(uint8_t *hash, size_t hash_len, const MsgFragment* frags, int num_frags) {
+  CryptoSHA256 sha;
+  for (int i = 0; i < num_frags; i++) {
+    sha.update(frags[i].data, frags[i].len);
+  }
+  sha.finalize(hash, hash_len);
+}
+
 int Utils::decrypt(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* src, int src_len) {
-  AES128 aes;
-  uint8_t* dp = dest;
-  const uint8_t* sp = src;
+  CryptoAES128 aes;
+  int num_blocks = (src_len + 15) / 16;
 
   aes.setKey(shared_secret, CIPHER_KEY_SIZE);
-  while (sp - src < src_len) {
-    aes.decryptBlock(dp, sp);
-    dp += 16; sp += 16;
-  }
+  aes.decryptBlocks(dest, src, num_blocks);
 
-  return sp - src;  // will always be multiple of 16
+  return num_blocks * 16;  // will always be multiple of 16
 }
 
 int Utils::encrypt(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* src, int src_len) {
-  AES128 aes;
+  CryptoAES128 aes;
   uint8_t* dp = dest;
+  int num_blocks = src_len / 16;
 
   aes.setKey(shared_secret, CIPHER_KEY_SIZE);
-  while (src_len >= 16) {
-    aes.encryptBlock(dp, src);
-    dp += 16; src += 16; src_len -= 16;
-  }
+  aes.encryptBlocks(dp, src, num_blocks);
+  dp += num_blocks * 16; src += num_blocks * 16; src_len -= num_blocks * 16;
   if (src_len > 0) {  // remaining partial block
     uint8_t tmp[16];
     memset(tmp, 0, 16);
@@ -60,7 +62,7 @@ int Utils::encrypt(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* s
 int Utils::encryptThenMAC(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* src, int src_len) {
   int enc_len = encrypt(shared_secret, dest + CIPHER_MAC_SIZE, src, src_len);
 
-  SHA256 sha;
+  CryptoSHA256 sha;
   sha.resetHMAC(shared_secret, PUB_KEY_SIZE);
   sha.update(dest + CIPHER_MAC_SIZE, enc_len);
   sha.finalizeHMAC(shared_secret, PUB_KEY_SIZE, dest, CIPHER_MAC_SIZE);
@@ -73,7 +75,7 @@ int Utils::MACThenDecrypt(const uint8_t* shared_secret, uint8_t* dest, const uin
 
   uint8_t hmac[CIPHER_MAC_SIZE];
   {
-    SHA256 sha;
+    CryptoSHA256 sha;
     sha.resetHMAC(shared_secret, PUB_KEY_SIZE);
     sha.update(src + CIPHER_MAC_SIZE, src_len - CIPHER_MAC_SIZE);
     sha.finalizeHMAC(shared_secret, PUB_KEY_SIZE, hmac, CIPHER_MAC_SIZE);
@@ -125,6 +127,19 @@ bool Utils::fromHex(uint8_t* dest, int dest_size, const char *src_hex) {
   return true;
 }
 
+uint16_t Utils::crc16(const uint8_t* data, size_t len, uint16_t crc) {
+  static const uint16_t nibble_table[16] = {   // CRC of each 4 bit value, so only two lookups per byte
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+  };
+  while (len-- > 0) {
+    uint8_t b = *data++;
+    crc = (crc << 4) ^ nibble_table[(crc >> 12) ^ (b >> 4)];
+    crc = (crc << 4) ^ nibble_table[(crc >> 12) ^ (b & 0x0F)];
+  }
+  return crc;
+}
+
 int Utils::parseTextParts(char* text, const char* parts[], int max_num, char separator) {
   int num = 0;
   char* sp = text;
@@ -6,6 +6,15 @@
 
 namespace ripple {
 
+/**
+ * \brief  A fragment of a message, so messages held in separate buffers can be hashed, signed, or verified, without
+ *       first copying them together. (same layout as ed25519_iovec)
+*/
+struct MsgFragment {
+  const uint8_t* data;
+  size_t len;
+};
+
 class RNG {
 public:
   virtual void random(uint8_t* dest, size_t sz) = 0;
@@ -28,6 +37,11 @@ public:
   */
   static void sha256(uint8_t *hash, size_t hash_len, const uint8_t* frag1, int frag1_len, const uint8_t* frag2, int frag2_len);
 
+  /**
+   * \brief  calculates the SHA256 hash of the 'num_frags' fragments (in order), storing in 'hash' and truncating.
+  */
+  static void sha256(uint8_t *hash, size_t hash_len, const MsgFragment* frags, int num_frags);
+
   /**
    * \brief  Encrypts the 'src' bytes using AES128 cipher, using 'shared_secret' as key, with key length fixed at CIPHER_KEY_SIZE.
    *         Final block is padded with zero bytes before encrypt. Result stored in 'dest'.
@@ -54,6 +68,11 @@ public:
   */
   static int MACThenDecrypt(const uint8_t* shared_secret, uint8_t* dest, const uint8_t* src, int src_len);
 
+  /**
+   * \brief  CRC-16/CCITT of 'len' bytes. Pass the previous result as 'crc' to continue over multiple fragments.
+  */
+  static uint16_t crc16(const uint8_t* data, size_t len, uint16_t crc=0xFFFF);
+
   /**
    * \brief  converts 'src' bytes with given length to Hex representation, and null terminates.
   */
@@ -14,6 +14,7 @@ public:
 class ArduinoMillis : public ripple::MillisecondClock {
 public:
   unsigned long getMillis() override { return millis(); }
+  unsigned long getMicros() override { return micros(); }
 };
 
 class StdRNG : public ripple::RNG {
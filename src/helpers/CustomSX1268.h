@@ -13,4 +13,8 @@ class CustomSX1268 : public SX1268 {
       bool hasPreamble = (irq & SX126X_IRQ_HEADER_VALID);
       return hasPreamble;
     }
+
+    bool isChannelActive() {
+      return scanChannel() == RADIOLIB_LORA_DETECTED;   // Channel Activity Detection (blocking, few symbol times)
+    }
 };
\ No newline at end of file
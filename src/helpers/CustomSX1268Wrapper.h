@@ -7,6 +7,13 @@ class CustomSX1268Wrapper : public RadioLibWrapper {
 public:
   CustomSX1268Wrapper(CustomSX1268& radio, ripple::MainBoard& board) : RadioLibWrapper(radio, board) { }
   bool isReceiving() override { return ((CustomSX1268 *)_radio)->isReceiving(); }
+  bool isChannelActive() override {
+    if (RadioLibWrapper::isChannelActive()) return true;
+
+    bool busy = ((CustomSX1268 *)_radio)->isChannelActive();
+    startRecv();   // CAD leaves radio in standby, so listen again straight away (the activity may be a packet for us)
+    return busy;
+  }
   float getLastRSSI() const override { return ((CustomSX1268 *)_radio)->getRSSI(); }
   float getLastSNR() const override { return ((CustomSX1268 *)_radio)->getSNR(); }
 };
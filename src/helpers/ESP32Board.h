@@ -19,6 +19,19 @@ public:
   }
 };
 
+#ifndef RETAINED_MEMORY_SIZE
+  #define RETAINED_MEMORY_SIZE   6400   // of the 8 KB RTC slow memory
+#endif
+
+class ESP32RetainedMemory : public ripple::RetainedMemory {
+public:
+  uint8_t* getBuffer() override {
+    static RTC_NOINIT_ATTR uint8_t buf[RETAINED_MEMORY_SIZE];   // kept during deep sleep
+    return buf;
+  }
+  size_t getSize() const override { return RETAINED_MEMORY_SIZE; }
+};
+
 class ESP32RTCClock : public ripple::RTCClock {
 public:
   ESP32RTCClock() { }
@@ -71,6 +71,18 @@ public:
     esp_deep_sleep_start();   // CPU halts here and never returns!
   }
 
+  bool sleepUntilRadioIRQ(uint32_t max_millis) override {
+    esp_sleep_enable_timer_wakeup((uint64_t)max_millis * 1000);
+    esp_sleep_enable_ext1_wakeup((1L << P_LORA_DIO_1), ESP_EXT1_WAKEUP_ANY_HIGH);  // wake up on: LoRa recv or send complete
+
+    esp_light_sleep_start();   // CPU resumes here
+
+    rtc_gpio_deinit((gpio_num_t)P_LORA_DIO_1);  // ext1 put the pin in RTC mode, restore for the radio's interrupt
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+
+    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT1;
+  }
+
   uint16_t getBattMilliVolts() override {
     digitalWrite(PIN_ADC_CTRL, PIN_ADC_CTRL_ACTIVE);
 
@@ -37,22 +37,20 @@ int RadioLibWrapper::recvRaw(uint8_t* bytes, int sz) {
       if (len > sz) { len = sz; }
       int err = _radio->readData(bytes, len);
       if (err != RADIOLIB_ERR_NONE) {
-        RIPPLE_DEBUG_PRINTLN("RadioLibWrapper: error: readData()");
+        RIPPLE_DEBUG_PRINTLN("RadioLibWrapper: error: readData(), err=%d", err);
+        n_recv_errors++;
+        len = 0;   // discard corrupted packet
       } else {
       //  Serial.print("  readData() -> "); Serial.println(len);
+        n_recv++;
       }
-      n_recv++;
     }
     state = STATE_IDLE;   // need another startReceive()
     return len;
   }
 
   if (state != STATE_RX) {
-    int err = _radio->startReceive();
-    if (err != RADIOLIB_ERR_NONE) {
-      RIPPLE_DEBUG_PRINTLN("RadioLibWrapper: error: startReceive()");
-    }
-    state = STATE_RX;
+    startRecv();
   }
   return 0;
 }
@@ -85,6 +83,28 @@ void RadioLibWrapper::onSendFinished() {
   state = STATE_IDLE;
 }
 
+void RadioLibWrapper::startRecv() {
+  int err = _radio->startReceive();
+  if (err != RADIOLIB_ERR_NONE) {
+    RIPPLE_DEBUG_PRINTLN("RadioLibWrapper: error: startReceive()");
+  }
+  state = STATE_RX;
+}
+
+bool RadioLibWrapper::isChannelActive() {
+  if (state & STATE_INT_READY) return true;   // a received packet is waiting to be read
+  return isReceiving();
+}
+
+void RadioLibWrapper::waitForEvent(uint32_t max_millis) {
+  if (state & STATE_INT_READY) return;   // interrupt already pending
+  if (state == STATE_IDLE) return;  // not in RX or TX, so no interrupt will come
+
+  if (_board->sleepUntilRadioIRQ(max_millis)) {
+    setFlag();   // in case the ISR did not run during sleep
+  }
+}
+
 float RadioLibWrapper::getLastRSSI() const {
   return _radio->getRSSI();
 }
@@ -7,10 +7,12 @@ class RadioLibWrapper : public ripple::Radio {
 protected:
   PhysicalLayer* _radio;
   ripple::MainBoard* _board;
-  uint32_t n_recv, n_sent;
+  uint32_t n_recv, n_sent, n_recv_errors;
+
+  void startRecv();   // (re)enters continuous receive mode
 
 public:
-  RadioLibWrapper(PhysicalLayer& radio, ripple::MainBoard& board) : _radio(&radio), _board(&board) { n_recv = n_sent = 0; }
+  RadioLibWrapper(PhysicalLayer& radio, ripple::MainBoard& board) : _radio(&radio), _board(&board) { n_recv = n_sent = n_recv_errors = 0; }
 
   void begin() override;
   int recvRaw(uint8_t* bytes, int sz) override;
@@ -18,11 +20,14 @@ public:
   void startSendRaw(const uint8_t* bytes, int len) override;
   bool isSendComplete() override;
   void onSendFinished() override;
+  void waitForEvent(uint32_t max_millis) override;
+  bool isChannelActive() override;
 
   uint32_t getPacketsRecv() const { return n_recv; }
   uint32_t getPacketsSent() const { return n_sent; }
-  virtual float getLastRSSI() const;
-  virtual float getLastSNR() const;
+  uint32_t getRecvErrors() const { return n_recv_errors; }   // eg. CRC errors, most likely from collisions
+  float getLastRSSI() const override;
+  float getLastSNR() const override;
 };
 
 /**
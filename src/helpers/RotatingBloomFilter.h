@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * \brief  A time-decayed set membership filter, of 8 byte keys (eg. packet hashes, or rand_blobs).
+ *     Is GENERATIONS Bloom filters, of BITS each. Keys are added to the current generation, and queries check all.
+ *     Every window_secs/(GENERATIONS-1) the oldest generation is cleared and becomes the current, so a key is
+ *     remembered for at least window_secs (and at most window_secs * GENERATIONS/(GENERATIONS-1)).
+ *
+ *     False positive rate (all generations together) is approx:  1 - (1 - (1 - e^(-HASHES*n/BITS))^HASHES)^GENERATIONS
+ *     where n is the number of keys added per generation.  eg. BITS=8192, HASHES=5, GENERATIONS=4 gives ~0.5% at
+ *     n = 500, or 0.05% at n = 300.  There are never false negatives (within the window).
+ * \tparam  BITS   bits per generation, must be a power of two.
+*/
+template <int BITS, int GENERATIONS = 4, int HASHES = 5>
+class RotatingBloomFilter {
+  static_assert(BITS >= 8 && (BITS & (BITS - 1)) == 0, "BITS must be a power of two");
+  static_assert(GENERATIONS >= 2, "need at least two generations");
+
+  uint8_t  _bits[GENERATIONS][BITS / 8];
+  uint32_t _last_rotate;   // by RTC clock
+  uint32_t _rotate_secs;
+  uint8_t  _curr;
+
+  static void hashesOf(const uint8_t* key, uint32_t& h1, uint32_t& h2) {
+    uint64_t x;
+    memcpy(&x, key, sizeof(x));
+    // splitmix64 finalizer, as rand_blobs are not uniform (first 4 bytes are a timestamp)
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27; x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    h1 = (uint32_t) x;
+    h2 = (uint32_t) (x >> 32) | 1;
+  }
+
+  int pendingRotations(uint32_t now) const {
+    if ((int32_t)(now - _last_rotate) < 0) return 0;   // clock was set backwards
+    uint32_t n = (now - _last_rotate) / _rotate_secs;
+    return n > GENERATIONS ? GENERATIONS : (int) n;
+  }
+
+  void rotate(uint32_t now) {
+    if ((int32_t)(now - _last_rotate) < 0) {
+      _last_rotate = now;   // clock was set backwards, restart the period
+      return;
+    }
+    int n = pendingRotations(now);
+    for (int i = 0; i < n; i++) {
+      _curr = (_curr + 1) % GENERATIONS;
+      memset(_bits[_curr], 0, BITS / 8);  // oldest generation becomes the new current
+    }
+    if (n == GENERATIONS) {
+      _last_rotate = now;
+    } else {
+      _last_rotate += n * _rotate_secs;
+    }
+  }
+
+public:
+  RotatingBloomFilter(uint32_t window_secs) {
+    _rotate_secs = window_secs / (GENERATIONS - 1);
+    if (_rotate_secs == 0) _rotate_secs = 1;
+    clear(0);
+  }
+
+  void clear(uint32_t now) {
+    memset(_bits, 0, sizeof(_bits));
+    _curr = 0;
+    _last_rotate = now;
+  }
+
+  uint32_t getLastRotateTime() const { return _last_rotate; }
+
+  /**
+   * \brief  moves the filter's time base by 'delta' secs, eg. when restored after the RTC clock has restarted.
+  */
+  void shiftTime(int32_t delta) { _last_rotate += delta; }
+
+  void add(const uint8_t* key, uint32_t now) {
+    rotate(now);
+
+    uint32_t h1, h2;
+    hashesOf(key, h1, h2);
+    for (int i = 0; i < HASHES; i++, h1 += h2) {
+      uint32_t b = h1 & (BITS - 1);
+      _bits[_curr][b >> 3] |= (1 << (b & 7));
+    }
+  }
+
+  bool contains(const uint8_t* key, uint32_t now) const {
+    uint32_t h1, h2;
+    hashesOf(key, h1, h2);
+
+    int live = GENERATIONS - pendingRotations(now);   // generations not yet due to be cleared
+    for (int age = 0; age < live; age++) {
+      const uint8_t* bits = _bits[(_curr + GENERATIONS - age) % GENERATIONS];
+      uint32_t h = h1;
+      int i = 0;
+      for (; i < HASHES; i++, h += h2) {
+        uint32_t b = h & (BITS - 1);
+        if ((bits[b >> 3] & (1 << (b & 7))) == 0) break;
+      }
+      if (i == HASHES) return true;  // all bits set
+    }
+    return false;
+  }
+};
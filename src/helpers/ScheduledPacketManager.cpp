@@ -0,0 +1,124 @@
+#include "ScheduledPacketManager.h"
+
+// NOTE: all time and sequence comparisons are by signed difference, to handle the wrap-around back to zero
+static bool isSoonerThan(const ScheduledEntry& a, const ScheduledEntry& b) {
+  int32_t diff = (int32_t)(a.scheduled_for - b.scheduled_for);
+  if (diff != 0) return diff < 0;
+  if (a.priority != b.priority) return a.priority < b.priority;
+  return (int32_t)(a.seq - b.seq) < 0;
+}
+
+static bool isMoreUrgentThan(const ScheduledEntry& a, const ScheduledEntry& b) {
+  if (a.priority != b.priority) return a.priority < b.priority;
+  return (int32_t)(a.seq - b.seq) < 0;
+}
+
+PacketHeap::PacketHeap(ScheduledEntry* entries, int max_entries, bool (*before)(const ScheduledEntry& a, const ScheduledEntry& b)) {
+  _entries = entries;
+  _size = max_entries;
+  _num = 0;
+  _before = before;
+}
+
+void PacketHeap::siftUp(int i) {
+  ScheduledEntry e = _entries[i];
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+    if (!_before(e, _entries[parent])) break;
+    _entries[i] = _entries[parent];
+    i = parent;
+  }
+  _entries[i] = e;
+}
+
+void PacketHeap::siftDown(int i) {
+  ScheduledEntry e = _entries[i];
+  while (true) {
+    int child = 2*i + 1;
+    if (child >= _num) break;
+    if (child + 1 < _num && _before(_entries[child + 1], _entries[child])) child++;   // pick the lesser child
+    if (!_before(_entries[child], e)) break;
+    _entries[i] = _entries[child];
+    i = child;
+  }
+  _entries[i] = e;
+}
+
+bool PacketHeap::push(const ScheduledEntry& entry) {
+  if (_num == _size) return false;   // heap is full
+
+  _entries[_num] = entry;
+  siftUp(_num++);
+  return true;
+}
+
+ScheduledEntry PacketHeap::pop() {
+  return removeAt(0);
+}
+
+ScheduledEntry PacketHeap::removeAt(int i) {
+  ScheduledEntry item = _entries[i];
+  _num--;
+  if (i < _num) {
+    _entries[i] = _entries[_num];  // move last into the hole, then restore heap order
+    if (i > 0 && _before(_entries[i], _entries[(i - 1) / 2])) {
+      siftUp(i);
+    } else {
+      siftDown(i);
+    }
+  }
+  return item;
+}
+
+ScheduledPacketManager::ScheduledPacketManager(ripple::Packet* pool, ScheduledEntry* pending_entries, ScheduledEntry* ready_entries, int pool_size)
+  : StaticPoolPacketManager(pool, pool_size, NULL, 0), _pending(pending_entries, pool_size, isSoonerThan), _ready(ready_entries, pool_size, isMoreUrgentThan)
+{
+  _next_seq = 0;
+}
+
+void ScheduledPacketManager::promoteDue(uint32_t now) {
+  while (_pending.count() > 0 && (int32_t)(_pending.top().scheduled_for - now) <= 0) {
+    _ready.push(_pending.pop());
+  }
+}
+
+void ScheduledPacketManager::queueOutbound(ripple::Packet* packet, uint8_t priority, uint32_t scheduled_for) {
+  ScheduledEntry e;
+  e.packet = packet;
+  e.scheduled_for = scheduled_for;
+  e.seq = _next_seq++;
+  e.priority = priority;
+  if (!_pending.push(e)) {
+    RIPPLE_DEBUG_PRINTLN("ScheduledPacketManager::queueOutbound(): FATAL: queue is full!");
+  }
+}
+
+ripple::Packet* ScheduledPacketManager::getNextOutbound(uint32_t now, uint8_t* priority) {
+  promoteDue(now);
+  if (_ready.count() == 0) return NULL;   // empty, or all items are still in the future
+
+  ScheduledEntry e = _ready.pop();
+  if (priority) *priority = e.priority;
+  return e.packet;
+}
+
+uint32_t ScheduledPacketManager::getNextOutboundTime() const {
+  if (_ready.count() > 0) return _ready.top().scheduled_for;   // already due
+  return _pending.top().scheduled_for;
+}
+
+int ScheduledPacketManager::getOutboundCount() const {
+  return _ready.count() + _pending.count();
+}
+
+ripple::Packet* ScheduledPacketManager::getOutboundByIdx(int i) {
+  if (i < _ready.count()) return _ready.itemAt(i).packet;
+  return _pending.itemAt(i - _ready.count()).packet;
+}
+
+ripple::Packet* ScheduledPacketManager::removeOutboundByIdx(int i) {
+  if (i >= getOutboundCount()) return NULL;  // invalid index
+
+  if (i < _ready.count()) return _ready.removeAt(i).packet;
+  return _pending.removeAt(i - _ready.count()).packet;
+}
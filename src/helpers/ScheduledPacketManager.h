@@ -0,0 +1,82 @@
+#pragma once
+
+#include "StaticPoolPacketManager.h"
+
+struct ScheduledEntry {
+  ripple::Packet* packet;
+  uint32_t scheduled_for;
+  uint32_t seq;       // insertion order, for FIFO amongst equal priorities
+  uint8_t  priority;
+};
+
+/**
+ * \brief  A fixed capacity binary min-heap of ScheduledEntry's, ordered by the given 'before' function.
+*/
+class PacketHeap {
+  ScheduledEntry* _entries;
+  int _size, _num;
+  bool (*_before)(const ScheduledEntry& a, const ScheduledEntry& b);
+
+  void siftUp(int i);
+  void siftDown(int i);
+
+public:
+  PacketHeap(ScheduledEntry* entries, int max_entries, bool (*before)(const ScheduledEntry& a, const ScheduledEntry& b));
+
+  bool push(const ScheduledEntry& entry);
+  ScheduledEntry pop();
+  ScheduledEntry removeAt(int i);
+  const ScheduledEntry& top() const { return _entries[0]; }
+  const ScheduledEntry& itemAt(int i) const { return _entries[i]; }
+  int count() const { return _num; }
+};
+
+/**
+ * \brief  Same Packet pool as StaticPoolPacketManager, but the outbound queue is split into two heaps:
+ *      'pending' ordered by scheduled_for (then priority), and 'ready' (already due) ordered by priority (then FIFO).
+ *      getNextOutbound() is O(log n), and getNextOutboundTime() is O(1).
+*/
+class ScheduledPacketManager : public StaticPoolPacketManager {
+  PacketHeap _pending, _ready;
+  uint32_t _next_seq;
+
+  void promoteDue(uint32_t now);
+
+protected:
+  /**
+   * \param pool  storage for 'pool_size' Packets
+   * \param pending_entries, ready_entries  storage for the heaps, 'pool_size' entries each
+  */
+  ScheduledPacketManager(ripple::Packet* pool, ScheduledEntry* pending_entries, ScheduledEntry* ready_entries, int pool_size);
+
+public:
+  void queueOutbound(ripple::Packet* packet, uint8_t priority, uint32_t scheduled_for) override;
+  ripple::Packet* getNextOutbound(uint32_t now, uint8_t* priority=NULL) override;
+  uint32_t getNextOutboundTime() const override;
+  int getOutboundCount() const override;
+  ripple::Packet* getOutboundByIdx(int i) override;
+  ripple::Packet* removeOutboundByIdx(int i) override;
+};
+
+template <int POOL_SIZE>
+struct ScheduledPoolStorage {
+  ripple::Packet _pool_storage[POOL_SIZE];
+  ScheduledEntry _pending_storage[POOL_SIZE];
+  ScheduledEntry _ready_storage[POOL_SIZE];
+};
+
+/**
+ * \brief  ScheduledPacketManager with its Packet pool, and heaps, statically allocated.
+ * \tparam  POOL_SIZE  number of Packets. Outbound queue can hold all of them.
+*/
+template <int POOL_SIZE>
+class SizedScheduledPacketManager : private ScheduledPoolStorage<POOL_SIZE>, public ScheduledPacketManager {
+  static_assert(POOL_SIZE >= 2, "need at least one inbound, and one outbound Packet");
+
+public:
+  SizedScheduledPacketManager()
+    : ScheduledPacketManager(this->_pool_storage, this->_pending_storage, this->_ready_storage, POOL_SIZE)
+  {
+    REPORT_RAM_FOOTPRINT(SizedScheduledPacketManager);
+  }
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <Identity.h>
+#include <string.h>
+
+/**
+ * \brief  A bounded cache of ECDH shared secrets, between this device's LocalIdentity and other Identities (eg. contacts),
+ *     keyed by the other's public key. Secrets are calculated on first use, so a large contact book costs nothing at boot,
+ *     and the least recently used secret is replaced when full. If the LocalIdentity's key changes, all secrets are
+ *     forgotten (on next use), as they were calculated with the previous key.
+ * \tparam  N  max secrets kept. Each is approx 68 bytes of RAM.
+*/
+template <int N>
+class SharedSecretCache {
+  static_assert(N > 0, "need at least one entry");
+
+  struct Entry {
+    uint8_t pub_key[PUB_KEY_SIZE];
+    uint8_t secret[PUB_KEY_SIZE];
+    uint32_t last_used;   // 0 = empty
+  };
+  Entry _entries[N];
+  ripple::LocalIdentity* _self;
+  uint8_t _self_key[PUB_KEY_SIZE];   // public key of _self, when _entries were calculated
+  uint32_t _clock;
+  uint32_t _hits, _misses;
+
+  Entry* find(const uint8_t* pub_key) {
+    for (int i = 0; i < N; i++) {
+      if (_entries[i].last_used && memcmp(_entries[i].pub_key, pub_key, PUB_KEY_SIZE) == 0) return &_entries[i];
+    }
+    return NULL;
+  }
+
+  Entry* leastRecentlyUsed() {
+    Entry* lru = &_entries[0];
+    for (int i = 1; i < N; i++) {
+      if (_entries[i].last_used < lru->last_used) lru = &_entries[i];
+    }
+    return lru;
+  }
+
+  void checkSelf() {
+    if (memcmp(_self_key, _self->pub_key, PUB_KEY_SIZE) != 0) {
+      clear();
+      memcpy(_self_key, _self->pub_key, PUB_KEY_SIZE);
+    }
+  }
+
+public:
+  SharedSecretCache(ripple::LocalIdentity& self) : _self(&self) {
+    _hits = _misses = 0;
+    clear();
+  }
+
+  /**
+   * \brief  forgets all secrets. (done automatically if the LocalIdentity has changed)
+  */
+  void clear() {
+    memset(_entries, 0, sizeof(_entries));
+    memset(_self_key, 0, sizeof(_self_key));
+    _clock = 0;
+  }
+
+  /**
+   * \returns  the shared secret (PUB_KEY_SIZE bytes) with 'other', calculating it if not cached.
+   *      NOTE: only valid until the next call to getSecret() or prefetch().
+  */
+  const uint8_t* getSecret(const ripple::Identity& other) {
+    checkSelf();
+    Entry* e = find(other.pub_key);
+    if (e) {
+      _hits++;
+    } else {
+      _misses++;
+      e = leastRecentlyUsed();
+      _self->calcSharedSecret(e->secret, other);
+      memcpy(e->pub_key, other.pub_key, PUB_KEY_SIZE);
+    }
+    e->last_used = ++_clock;
+    return e->secret;
+  }
+
+  /**
+   * \brief  calculates, together (which is cheaper than one at a time), the secrets for those of 'others' not already cached.
+   *      Only the first N are considered, as more would just replace each other. Those already cached count as used.
+   * \returns  number of secrets calculated.
+  */
+  int prefetch(const ripple::Identity* others, int count) {
+    if (count > N) count = N;
+    checkSelf();
+
+    // first mark those already cached as used, so the new secrets don't replace them
+    for (int i = 0; i < count; i++) {
+      Entry* e = find(others[i].pub_key);
+      if (e) e->last_used = ++_clock;
+    }
+
+    const int CHUNK = 8;
+    ripple::Identity todo[CHUNK];
+    uint8_t secrets[CHUNK*PUB_KEY_SIZE];
+    int n = 0, total = 0;
+    for (int i = 0; i <= count; i++) {
+      if (i < count && find(others[i].pub_key) == NULL) {
+        int j = 0;
+        while (j < n && memcmp(todo[j].pub_key, others[i].pub_key, PUB_KEY_SIZE) != 0) j++;
+        if (j == n) todo[n++] = others[i];   // (not a duplicate)
+      }
+      if (n == CHUNK || (i == count && n > 0)) {
+        _self->calcSharedSecrets(secrets, todo, n);
+        for (int j = 0; j < n; j++) {
+          Entry* e = leastRecentlyUsed();
+          memcpy(e->pub_key, todo[j].pub_key, PUB_KEY_SIZE);
+          memcpy(e->secret, &secrets[j*PUB_KEY_SIZE], PUB_KEY_SIZE);
+          e->last_used = ++_clock;
+        }
+        total += n;
+        n = 0;
+      }
+    }
+    return total;
+  }
+
+  uint32_t getNumHits() const { return _hits; }
+  uint32_t getNumMisses() const { return _misses; }   // secrets calculated by getSecret()
+};
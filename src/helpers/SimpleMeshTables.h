@@ -1,90 +1,452 @@
 #pragma once
 
 #include <MeshTransportNone.h>
+#include "RotatingBloomFilter.h"
+#include "SizeReport.h"
 
-#define MAX_RAND_BLOBS     64
-#define MAX_PACKET_HASHES  64
-#define MAX_DEST_HASHES    64
-#define MAX_MAPPING_HASHES 64
+// default capacities (see SizedMeshTables template)
+#ifndef MAX_PACKET_HASHES
+  #define MAX_PACKET_HASHES  64
+#endif
+#ifndef MAX_DEST_HASHES
+  #define MAX_DEST_HASHES    64
+#endif
+#ifndef MAX_MAPPING_HASHES
+  #define MAX_MAPPING_HASHES 64
+#endif
+
+// how long (at least) seen packet hashes, and forwarded Announce rand_blobs, are remembered
+#ifndef SEEN_FILTER_WINDOW_SECS
+  #define SEEN_FILTER_WINDOW_SECS  (15*60)
+#endif
+// filter sizes (bits per generation, 4 generations). See RotatingBloomFilter for false positive rates.
+#ifndef SEEN_FILTER_BITS
+  #define SEEN_FILTER_BITS   8192   // 4 KB total, ~0.5% false positive at 100 packets/min
+#endif
+#ifndef FWD_FILTER_BITS
+  #define FWD_FILTER_BITS    2048   // 1 KB total, ~0.2% false positive at 20 announces/min
+#endif
 
 // if destination has had activity within this many secs, then don't evict it from table
 #ifndef KEEP_ALIVE_SECS
   #define KEEP_ALIVE_SECS  60
 #endif
 
+#define DEST_INDEX_NIL   0xFFFF
+
+// journal is compacted (rewritten as a snapshot) once this many records have been appended
+#ifndef JOURNAL_COMPACT_RECORDS
+  #define JOURNAL_COMPACT_RECORDS  512
+#endif
+
+// journal writes are buffered, and only flushed (ie. written to flash) after a JREC_DEST record, once this many
+//  other records are buffered, or once the oldest has been buffered for JOURNAL_FLUSH_SECS
+#ifndef JOURNAL_FLUSH_RECORDS
+  #define JOURNAL_FLUSH_RECORDS  32
+#endif
+#ifndef JOURNAL_FLUSH_SECS
+  #define JOURNAL_FLUSH_SECS  60
+#endif
+
+#define JOURNAL_MAGIC      0x4A52   // 'RJ'
+#define JOURNAL_VERSION    3
+#define JOURNAL_HDR_SIZE   12   // magic(2), version(1), capacities(5), sizeof(DestPathEntry)(2), sizeof filters(2)
+
+// journal record types. Each record is: type(1), fixed size payload (by type), crc16 of type+payload(2)
+#define JREC_DEST          1   // slot(2), dest_hash(8), DestPathEntry
+#define JREC_REMOVE_DEST   2   // slot(2)
+#define JREC_SEEN          3   // packet_hash(8), code(1), timestamp(4)
+#define JREC_FORWARDED     4   // rand_blob(8), timestamp(4)
+#define JREC_MAPPING       5   // packet_hash(8), orig_dest(8), timestamp(4)
+#define JREC_CLEAR_MAPPING 6   // packet_hash(8)
+#define JREC_FILTERS       7   // raw filters (only in snapshots)
+#define JREC_NEXT_HOPS     8   // slot(2), hops(1), path_cost(1), header(1), num_alts(1), transport_id(8), alts (of a DestPathEntry)
+
+#define CHECKPOINT_MAGIC      0x4352   // 'RC'
+#define CHECKPOINT_VERSION    3
+#define CHECKPOINT_HDR_SIZE   9        // magic(2), version(1), DEST_CAPACITY(2), payload len(2), crc16 of payload(2)
+#define CHECKPOINT_DEST_SIZE  (2 + 2*DEST_HASH_SIZE + 3 + 4 + 4 + 8 + PUB_KEY_SIZE)
+#define CHECKPOINT_SEEN_SIZE  (DEST_HASH_SIZE + 1)
+#define CHECKPOINT_MAP_SIZE   (2*DEST_HASH_SIZE + 4)
+
 struct HashMappingEntry {
   uint8_t  packet_hash[DEST_HASH_SIZE];
   uint8_t  orig_dest[DEST_HASH_SIZE];
+  uint32_t timestamp;   // when set (by RTC clock), zero if unused
 };
 
-class SimpleMeshTables : public ripple::MeshTables {
-  uint8_t _fwd_blobs[MAX_RAND_BLOBS*8];
-  int _next_fwd_idx;
-
-  uint8_t _seen_hashes[MAX_PACKET_HASHES*DEST_HASH_SIZE];
-  uint8_t _hash_code[MAX_PACKET_HASHES];
+/**
+ * \brief  Destination table is indexed by an open addressing (linear probing) hash table, and slots are kept in an
+ *       intrusive LRU list (by last_timestamp), so lookup, insert and eviction are all O(1).
+ *
+ *       Persistence is by an append-only journal of table changes (see setJournal()), so each change costs a small
+ *       sequential write (buffered, see JOURNAL_FLUSH_RECORDS). Journal starts with a versioned header and a snapshot, and is periodically compacted
+ *       (ie. rewritten as just a snapshot) by writeSnapshot().  NOTE: touch() is not journalled (too frequent), so
+ *       after a replay, LRU order is by last save instead of last use.
+ * \tparam  DEST_CAPACITY  max number of destinations (up to 65534)
+ * \tparam  PACKET_HASHES  number of most recent packet hashes kept exactly (older are only in the seen filter)
+ * \tparam  MAPPING_HASHES  max number of packet_hash -> destination mappings (for forwarding signed replies)
+ * \tparam  SEEN_BITS, FWD_BITS  bits per generation of the seen packet, and forwarded Announce, filters
+*/
+template <int DEST_CAPACITY = MAX_DEST_HASHES, int PACKET_HASHES = MAX_PACKET_HASHES, int MAPPING_HASHES = MAX_MAPPING_HASHES,
+          int SEEN_BITS = SEEN_FILTER_BITS, int FWD_BITS = FWD_FILTER_BITS>
+class SizedMeshTables : public ripple::MeshTables {
+  static_assert(DEST_CAPACITY > 0 && DEST_CAPACITY < DEST_INDEX_NIL, "DEST_CAPACITY out of range");
+  static_assert(PACKET_HASHES > 0 && PACKET_HASHES <= 255, "PACKET_HASHES out of range");
+  static_assert(MAPPING_HASHES > 0 && MAPPING_HASHES <= 255, "MAPPING_HASHES out of range");
+  static_assert(DEST_HASH_SIZE == 8, "filters expect 8 byte keys");
+
+  static constexpr int indexSizeFor(int n, int sz=1) { return sz >= 2*n ? sz : indexSizeFor(n, sz*2); }
+  static const int DEST_INDEX_SIZE = indexSizeFor(DEST_CAPACITY);  // power of two, load factor <= 0.5
+
+  RotatingBloomFilter<FWD_BITS> _fwd_filter;
+  RotatingBloomFilter<SEEN_BITS> _seen_filter;   // all seen packet hashes, over the window
+
+  // most recent packet hashes, with their exact codes
+  uint8_t _seen_hashes[PACKET_HASHES*DEST_HASH_SIZE];
+  uint8_t _hash_code[PACKET_HASHES];
   int _next_hash_idx;
 
-  HashMappingEntry _hash_mappings[MAX_MAPPING_HASHES];
+  HashMappingEntry _hash_mappings[MAPPING_HASHES];
   int _next_mapping_idx;
 
-  uint8_t _dest_hashes[MAX_DEST_HASHES*DEST_HASH_SIZE];
-  ripple::DestPathEntry _dest_entries[MAX_DEST_HASHES];
+  int _sweep_idx;   // next entry to be examined by sweepExpired(), dest entries then mappings
+
+  Stream* _journal;   // where changes are appended, or NULL
+  int _journal_records;   // appended since last snapshot
+  int _journal_unflushed;   // appended since last flush
+  uint32_t _journal_unflushed_since;   // by RTC clock
+
+  uint8_t _dest_hashes[DEST_CAPACITY*DEST_HASH_SIZE];
+  ripple::DestPathEntry _dest_entries[DEST_CAPACITY];
+  uint16_t _dest_index[DEST_INDEX_SIZE];   // slot numbers, or DEST_INDEX_NIL
+  uint16_t _lru_prev[DEST_CAPACITY], _lru_next[DEST_CAPACITY];
+  uint16_t _lru_head, _lru_tail;   // head is most recently used. Unused slots (last_timestamp == 0) are at tail
 
   int lookupHashIndex(const uint8_t* hash) const {
     const uint8_t* sp = _seen_hashes;
-    for (int i = 0; i < MAX_PACKET_HASHES; i++, sp += DEST_HASH_SIZE) {
+    for (int i = 0; i < PACKET_HASHES; i++, sp += DEST_HASH_SIZE) {
       if (memcmp(hash, sp, DEST_HASH_SIZE) == 0) return i;
     }
     return -1;
   }
 
   int lookupMappingIndex(const uint8_t* packet_hash) const {
-    for (int i = 0; i < MAX_MAPPING_HASHES; i++) {
+    for (int i = 0; i < MAPPING_HASHES; i++) {
       if (memcmp(packet_hash, _hash_mappings[i].packet_hash, DEST_HASH_SIZE) == 0) return i;
     }
     return -1;
   }
 
-protected:
-  bool lookupDest(const uint8_t* hash, uint32_t& handle, ripple::DestPathEntry* dest) const override {
-    const uint8_t* sp = _dest_hashes;
-    for (int i = 0; i < MAX_DEST_HASHES; i++, sp += DEST_HASH_SIZE) {
-      if (_dest_entries[i].last_timestamp != 0 && memcmp(hash, sp, DEST_HASH_SIZE) == 0) {
-        handle = i;
-        if (dest) *dest = _dest_entries[i];
-        return true;
-      }
+  static int homeIndexOf(const uint8_t* hash) {
+    uint32_t h;
+    memcpy(&h, hash, sizeof(h));   // dest hashes are already (truncated) SHA256, so evenly distributed
+    return h & (DEST_INDEX_SIZE - 1);
+  }
+
+  int findIndexPos(const uint8_t* hash) const {
+    int pos = homeIndexOf(hash);
+    while (_dest_index[pos] != DEST_INDEX_NIL) {
+      if (memcmp(hash, &_dest_hashes[_dest_index[pos]*DEST_HASH_SIZE], DEST_HASH_SIZE) == 0) return pos;
+      pos = (pos + 1) & (DEST_INDEX_SIZE - 1);
     }
-    return false;
+    return -1;
   }
 
-  uint32_t findFreeDest() override {
-    int min_i = 0;
-    uint32_t min_time = 0xFFFFFFFF;
-    for (int i = 0; i < MAX_DEST_HASHES; i++) {
-      if (_dest_entries[i].last_timestamp < min_time) {
-        min_i = i;
-        min_time = _dest_entries[i].last_timestamp;
+  void insertIndex(const uint8_t* hash, uint16_t slot) {
+    int pos = homeIndexOf(hash);
+    while (_dest_index[pos] != DEST_INDEX_NIL) {
+      pos = (pos + 1) & (DEST_INDEX_SIZE - 1);
+    }
+    _dest_index[pos] = slot;
+  }
+
+  void removeIndexAt(int pos) {
+    // backward-shift deletion, so no 'tombstones' are needed
+    int i = pos, j = pos;
+    while (true) {
+      j = (j + 1) & (DEST_INDEX_SIZE - 1);
+      if (_dest_index[j] == DEST_INDEX_NIL) break;
+
+      int k = homeIndexOf(&_dest_hashes[_dest_index[j]*DEST_HASH_SIZE]);
+      bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);   // is home cyclically in (i, j] ?
+      if (!stays) {
+        _dest_index[i] = _dest_index[j];
+        i = j;
       }
     }
+    _dest_index[i] = DEST_INDEX_NIL;
+  }
+
+  void unlinkLRU(uint16_t slot) {
+    if (_lru_prev[slot] != DEST_INDEX_NIL) _lru_next[_lru_prev[slot]] = _lru_next[slot]; else _lru_head = _lru_next[slot];
+    if (_lru_next[slot] != DEST_INDEX_NIL) _lru_prev[_lru_next[slot]] = _lru_prev[slot]; else _lru_tail = _lru_prev[slot];
+  }
+
+  void insertLRUAfter(uint16_t prev, uint16_t slot) {   // prev == DEST_INDEX_NIL, for head
+    _lru_prev[slot] = prev;
+    _lru_next[slot] = prev == DEST_INDEX_NIL ? _lru_head : _lru_next[prev];
+    if (_lru_next[slot] != DEST_INDEX_NIL) _lru_prev[_lru_next[slot]] = slot; else _lru_tail = slot;
+    if (prev != DEST_INDEX_NIL) _lru_next[prev] = slot; else _lru_head = slot;
+  }
+
+  void initDestIndex() {   // all slots unused, so index is empty and LRU order is just slot order
+    memset(_dest_index, 0xFF, sizeof(_dest_index));
+    for (int i = 0; i < DEST_CAPACITY; i++) {
+      _lru_prev[i] = i > 0 ? i - 1 : DEST_INDEX_NIL;
+      _lru_next[i] = i < DEST_CAPACITY - 1 ? i + 1 : DEST_INDEX_NIL;
+    }
+    _lru_head = 0;
+    _lru_tail = DEST_CAPACITY - 1;
+  }
+
+  static int recordSizeOf(uint8_t type) {
+    switch (type) {
+      case JREC_DEST:          return 2 + DEST_HASH_SIZE + sizeof(ripple::DestPathEntry);
+      case JREC_REMOVE_DEST:   return 2;
+      case JREC_SEEN:          return DEST_HASH_SIZE + 1 + 4;
+      case JREC_FORWARDED:     return 8 + 4;
+      case JREC_MAPPING:       return 2*DEST_HASH_SIZE + 4;
+      case JREC_CLEAR_MAPPING: return DEST_HASH_SIZE;
+      case JREC_FILTERS:       return sizeof(_fwd_filter) + sizeof(_seen_filter);
+      case JREC_NEXT_HOPS:     return 2 + 4 + DEST_HASH_SIZE + sizeof(ripple::AltNextHop)*MAX_ALT_HOPS;
+    }
+    return -1;  // unknown
+  }
+
+  static void writeRecord(Stream& s, uint8_t type, const void* part1, int len1, const void* part2=NULL, int len2=0,
+                          const void* part3=NULL, int len3=0) {
+    uint16_t crc = ripple::Utils::crc16(&type, 1);
+    crc = ripple::Utils::crc16((const uint8_t *) part1, len1, crc);
+    if (len2 > 0) crc = ripple::Utils::crc16((const uint8_t *) part2, len2, crc);
+    if (len3 > 0) crc = ripple::Utils::crc16((const uint8_t *) part3, len3, crc);
+
+    s.write(&type, 1);
+    s.write((const uint8_t *) part1, len1);
+    if (len2 > 0) s.write((const uint8_t *) part2, len2);
+    if (len3 > 0) s.write((const uint8_t *) part3, len3);
+    s.write((const uint8_t *) &crc, 2);
+  }
+
+  void journal(uint8_t type, const void* part1, int len1, const void* part2=NULL, int len2=0, const void* part3=NULL, int len3=0) {
+    if (_journal) {
+      writeRecord(*_journal, type, part1, len1, part2, len2, part3, len3);
+      _journal_records++;
+      if (_journal_unflushed++ == 0) _journal_unflushed_since = _rtc->getCurrentTime();
+
+      // new paths are worth a flash write now, but the per-packet records (seen, mappings) are batched
+      if (type == JREC_DEST || _journal_unflushed >= JOURNAL_FLUSH_RECORDS) flushJournal();
+    }
+  }
+
+  void writeDestRecord(Stream& s, uint16_t slot) {
+    writeRecord(s, JREC_DEST, &slot, 2, &_dest_hashes[slot*DEST_HASH_SIZE], DEST_HASH_SIZE, &_dest_entries[slot], sizeof(_dest_entries[slot]));
+  }
+
+  static void headerOf(uint8_t* hdr) {   // JOURNAL_HDR_SIZE bytes
+    uint16_t v;
+    v = JOURNAL_MAGIC; memcpy(&hdr[0], &v, 2);
+    hdr[2] = JOURNAL_VERSION;
+    hdr[3] = PACKET_HASHES;
+    v = DEST_CAPACITY; memcpy(&hdr[4], &v, 2);
+    v = MAPPING_HASHES; memcpy(&hdr[6], &v, 2);
+    v = sizeof(ripple::DestPathEntry); memcpy(&hdr[8], &v, 2);
+    v = recordSizeOf(JREC_FILTERS); memcpy(&hdr[10], &v, 2);
+  }
+
+  void applySeen(const uint8_t* hash, int code, uint32_t now) {
+    _seen_filter.add(hash, now);
+
+    int i = lookupHashIndex(hash);
+    if (i >= 0) {
+      _hash_code[i] = (uint8_t) code;
+    } else {
+      memcpy(&_seen_hashes[_next_hash_idx*DEST_HASH_SIZE], hash, DEST_HASH_SIZE);
+      _hash_code[_next_hash_idx] = (uint8_t) code;
+
+      _next_hash_idx = (_next_hash_idx + 1) % PACKET_HASHES;  // cyclic table
+    }
+  }
+
+  void applyMapping(const uint8_t* packet_hash, const uint8_t* destination_hash, uint32_t timestamp) {
+    int i = lookupMappingIndex(packet_hash);
+    if (i < 0) {   // not found, append to table (cyclic)
+      i = _next_mapping_idx;
+      _next_mapping_idx = (_next_mapping_idx + 1) % MAPPING_HASHES;
+
+      memcpy(_hash_mappings[i].packet_hash, packet_hash, DEST_HASH_SIZE);  // set the key
+    }
+    memcpy(_hash_mappings[i].orig_dest, destination_hash, DEST_HASH_SIZE);
+    _hash_mappings[i].timestamp = timestamp;
+  }
+
+  // 'latest' is advanced to the time the record was written, if it has one
+  bool applyRecord(uint8_t type, const uint8_t* rec, uint32_t& latest) {
+    uint16_t slot;
+    uint32_t timestamp = 0;
+    switch (type) {
+      case JREC_DEST:
+        memcpy(&slot, rec, 2);
+        if (slot >= DEST_CAPACITY) return false;
+        ripple::DestPathEntry entry;
+        memcpy(&entry, &rec[2 + DEST_HASH_SIZE], sizeof(entry));
+        saveDest(slot, &rec[2], entry);
+        timestamp = entry.last_timestamp;
+        break;
+      case JREC_REMOVE_DEST:
+        memcpy(&slot, rec, 2);
+        if (slot >= DEST_CAPACITY) return false;
+        removeDest(slot);
+        break;
+      case JREC_SEEN:
+        memcpy(&timestamp, &rec[DEST_HASH_SIZE + 1], 4);
+        applySeen(rec, rec[DEST_HASH_SIZE], timestamp);
+        break;
+      case JREC_FORWARDED:
+        memcpy(&timestamp, &rec[8], 4);
+        _fwd_filter.add(rec, timestamp);
+        break;
+      case JREC_MAPPING:
+        memcpy(&timestamp, &rec[2*DEST_HASH_SIZE], 4);
+        applyMapping(rec, &rec[DEST_HASH_SIZE], timestamp);
+        break;
+      case JREC_CLEAR_MAPPING:
+        clearPacketHashDest(rec);
+        break;
+      case JREC_NEXT_HOPS:
+        memcpy(&slot, rec, 2);
+        if (slot >= DEST_CAPACITY || rec[5] > MAX_ALT_HOPS) return false;
+        if (_dest_entries[slot].last_timestamp != 0) {
+          ripple::DestPathEntry* e = &_dest_entries[slot];
+          e->hops = rec[2];
+          e->path_cost = rec[3];
+          e->header = rec[4];
+          e->num_alts = rec[5];
+          memcpy(e->transport_id, &rec[6], DEST_HASH_SIZE);
+          memcpy(e->alts, &rec[6 + DEST_HASH_SIZE], sizeof(e->alts));
+        }
+        break;
+    }
+    if ((int32_t)(timestamp - latest) > 0) latest = timestamp;
+    return true;
+  }
+
+  // moves all stored times by 'delta' secs
+  void shiftTimes(int32_t delta) {
+    for (int i = 0; i < DEST_CAPACITY; i++) {
+      if (_dest_entries[i].last_timestamp == 0) continue;   // unused
+      _dest_entries[i].create_timestamp += delta;
+      _dest_entries[i].last_timestamp += delta;
+    }
+    for (int i = 0; i < MAPPING_HASHES; i++) {
+      if (_hash_mappings[i].timestamp != 0) _hash_mappings[i].timestamp += delta;
+    }
+    _fwd_filter.shiftTime(delta);
+    _seen_filter.shiftTime(delta);
+  }
+
+  // times restored are by the RTC clock when saved. If that is ahead of the clock now (eg. a VolatileRTCClock, which
+  //  restarts from a fixed time), move them all back, as if no time had passed since 'saved_at'
+  void rebaseTimes(uint32_t saved_at) {
+    int32_t delta = _rtc->getCurrentTime() - saved_at;
+    if (delta < 0) shiftTimes(delta);
+  }
+
+protected:
+  bool lookupDest(const uint8_t* hash, uint32_t& handle, ripple::DestPathEntry* dest) const override {
+    int pos = findIndexPos(hash);
+    if (pos < 0) return false;
+
+    handle = _dest_index[pos];
+    if (dest) *dest = _dest_entries[handle];
+    return true;
+  }
+
+  uint32_t findFreeDest() override {
+    uint16_t lru = _lru_tail;   // least recently used, or an unused slot
 
     auto now = _rtc->getCurrentTime();
-    if (min_time > now - KEEP_ALIVE_SECS) return NIL_TABLE_HANDLE;
+    if (_dest_entries[lru].last_timestamp > now - KEEP_ALIVE_SECS) return NIL_TABLE_HANDLE;
 
-    return min_i;
+    return lru;
   }
 
   bool saveDest(uint32_t handle, const uint8_t* hash, const ripple::DestPathEntry& dest) override {
-    memcpy(&_dest_hashes[handle*DEST_HASH_SIZE], hash, DEST_HASH_SIZE);
+    uint8_t* sp = &_dest_hashes[handle*DEST_HASH_SIZE];
+    bool in_use = _dest_entries[handle].last_timestamp != 0;
+    if (!in_use || memcmp(hash, sp, DEST_HASH_SIZE) != 0) {   // new key for this slot
+      if (in_use) {
+        int pos = findIndexPos(sp);   // evicting previous dest
+        if (pos >= 0) removeIndexAt(pos);
+      }
+      memcpy(sp, hash, DEST_HASH_SIZE);
+      insertIndex(sp, handle);
+    }
     _dest_entries[handle] = dest;
+
+    unlinkLRU(handle);
+    insertLRUAfter(DEST_INDEX_NIL, handle);  // is now most recently used
+
+    if (_journal) {
+      uint16_t slot = handle;
+      journal(JREC_DEST, &slot, 2, sp, DEST_HASH_SIZE, &_dest_entries[handle], sizeof(_dest_entries[handle]));
+    }
     return true;
   }
 
+  const ripple::DestPathEntry* getDestEntry(uint32_t handle) const override {
+    return &_dest_entries[handle];
+  }
+
+  const uint8_t* getDestHash(uint32_t handle) const override {
+    return &_dest_hashes[handle*DEST_HASH_SIZE];
+  }
+
+  ripple::DestPathEntry* editNextHops(uint32_t handle) override {
+    return &_dest_entries[handle];
+  }
+
+  void saveNextHops(uint32_t handle) override {
+    if (_journal) {   // just the changed fields, rather than whole entry
+      const ripple::DestPathEntry* e = &_dest_entries[handle];
+      uint8_t rec[2 + 4 + DEST_HASH_SIZE + sizeof(e->alts)];
+      uint16_t slot = handle;
+      memcpy(&rec[0], &slot, 2);
+      rec[2] = e->hops;
+      rec[3] = e->path_cost;
+      rec[4] = e->header;
+      rec[5] = e->num_alts;
+      memcpy(&rec[6], e->transport_id, DEST_HASH_SIZE);
+      memcpy(&rec[6 + DEST_HASH_SIZE], e->alts, sizeof(e->alts));
+      journal(JREC_NEXT_HOPS, rec, sizeof(rec));
+    }
+  }
+
+  void touch(uint32_t handle) override {
+    _dest_entries[handle].last_timestamp = _rtc->getCurrentTime();
+
+    unlinkLRU(handle);
+    insertLRUAfter(DEST_INDEX_NIL, handle);  // is now most recently used
+  }
+
+  void removeDest(uint32_t handle) override {
+    int pos = findIndexPos(&_dest_hashes[handle*DEST_HASH_SIZE]);
+    if (pos >= 0) removeIndexAt(pos);
+    memset(&_dest_entries[handle], 0, sizeof(_dest_entries[handle]));  // last_timestamp = 0, ie. unused
+
+    unlinkLRU(handle);
+    insertLRUAfter(_lru_tail, handle);  // free slots are at tail
+
+    uint16_t slot = handle;
+    journal(JREC_REMOVE_DEST, &slot, 2);
+  }
+
 public:
-  SimpleMeshTables(ripple::RTCClock& rtc): ripple::MeshTables(rtc) { 
-    memset(_fwd_blobs, 0, sizeof(_fwd_blobs));
-    _next_fwd_idx = 0;
+  SizedMeshTables(ripple::RTCClock& rtc)
+    : ripple::MeshTables(rtc), _fwd_filter(SEEN_FILTER_WINDOW_SECS), _seen_filter(SEEN_FILTER_WINDOW_SECS)
+  { 
+    _fwd_filter.clear(rtc.getCurrentTime());
+    _seen_filter.clear(rtc.getCurrentTime());
 
     memset(_seen_hashes, 0, sizeof(_seen_hashes));
     memset(_hash_code, 0, sizeof(_hash_code));
@@ -92,101 +454,433 @@ public:
 
     memset(_hash_mappings, 0, sizeof(_hash_mappings));
     _next_mapping_idx = 0;
+    _sweep_idx = 0;
+    _journal = NULL;
+    _journal_records = 0;
+    _journal_unflushed = 0;
+    _journal_unflushed_since = 0;
 
     memset(_dest_entries, 0, sizeof(_dest_entries));  // set all last_timestamp fields to zero
+    initDestIndex();
+
+    REPORT_RAM_FOOTPRINT(SizedMeshTables);
+  }
+
+  /**
+   * \brief  Replays a journal (as written by writeSnapshot(), then appended to via setJournal()), into these tables,
+   *     which should be empty (ie. freshly constructed). Stops at the first incomplete, or corrupt, record (eg. a
+   *     write interrupted by power loss). If the RTC clock is now behind the latest time in the journal (ie. it has
+   *     restarted), all restored times are moved back by the difference.
+   * \returns  number of records replayed, or -1 if header is missing, or is for a different version or capacities.
+  */
+  int replayJournal(Stream& s) {
+    uint8_t hdr[JOURNAL_HDR_SIZE], expected[JOURNAL_HDR_SIZE];
+    uint16_t crc;
+    headerOf(expected);
+    if (s.available() < (int)sizeof(hdr) + 2) return -1;
+    s.readBytes(hdr, sizeof(hdr));
+    s.readBytes((uint8_t *) &crc, 2);
+    if (memcmp(hdr, expected, sizeof(hdr)) != 0 || crc != ripple::Utils::crc16(hdr, sizeof(hdr))) return -1;
+
+    Stream* saved = _journal;
+    _journal = NULL;   // don't re-journal while replaying
+    uint8_t rec[1 + 2 + DEST_HASH_SIZE + sizeof(ripple::DestPathEntry)];   // largest, except JREC_FILTERS
+    int num = 0;
+    uint32_t latest = _rtc->getCurrentTime();
+    while (s.available() > 0) {
+      s.readBytes(rec, 1);
+      int len = recordSizeOf(rec[0]);
+      if (len < 0 || s.available() < len + 2) break;   // corrupt, or truncated
+
+      if (rec[0] == JREC_FILTERS) {   // too big for stack, so read in-place
+        s.readBytes((uint8_t *) &_fwd_filter, sizeof(_fwd_filter));
+        s.readBytes((uint8_t *) &_seen_filter, sizeof(_seen_filter));
+        s.readBytes((uint8_t *) &crc, 2);
+        uint16_t actual = ripple::Utils::crc16(rec, 1);
+        actual = ripple::Utils::crc16((const uint8_t *) &_fwd_filter, sizeof(_fwd_filter), actual);
+        actual = ripple::Utils::crc16((const uint8_t *) &_seen_filter, sizeof(_seen_filter), actual);
+        if (crc != actual) {
+          _fwd_filter.clear(_rtc->getCurrentTime());
+          _seen_filter.clear(_rtc->getCurrentTime());
+          break;
+        }
+        if ((int32_t)(_seen_filter.getLastRotateTime() - latest) > 0) latest = _seen_filter.getLastRotateTime();
+      } else {
+        s.readBytes(&rec[1], len);
+        s.readBytes((uint8_t *) &crc, 2);
+        if (crc != ripple::Utils::crc16(rec, 1 + len)) break;
+
+        if (!applyRecord(rec[0], &rec[1], latest)) break;
+      }
+      num++;
+    }
+    rebaseTimes(latest);
+    _journal = saved;
+    return num;
+  }
+
+  /**
+   * \brief  After restoreCheckpoint(), fills in the parts of the Announces it doesn't keep (name_hash, signature,
+   *     app_data) from the journal current when the checkpoint was written, so a later writeSnapshot() doesn't replace
+   *     the journal's full entries with partial ones. Only entries still partial, and for the same Announce, are
+   *     changed. Other records are skipped, as the checkpoint is more recent.
+   * \returns  number of entries completed, or -1 if header is missing, or is for a different version or capacities.
+  */
+  int completeFromJournal(Stream& s) {
+    uint8_t hdr[JOURNAL_HDR_SIZE], expected[JOURNAL_HDR_SIZE];
+    uint16_t crc;
+    headerOf(expected);
+    if (s.available() < (int)sizeof(hdr) + 2) return -1;
+    s.readBytes(hdr, sizeof(hdr));
+    s.readBytes((uint8_t *) &crc, 2);
+    if (memcmp(hdr, expected, sizeof(hdr)) != 0 || crc != ripple::Utils::crc16(hdr, sizeof(hdr))) return -1;
+
+    uint8_t rec[1 + 2 + DEST_HASH_SIZE + sizeof(ripple::DestPathEntry)];
+    int num = 0;
+    while (s.available() > 0) {
+      s.readBytes(rec, 1);
+      int len = recordSizeOf(rec[0]);
+      if (len < 0 || s.available() < len + 2) break;   // corrupt, or truncated
+
+      if (rec[0] != JREC_DEST) {   // skip
+        for (int n = len + 2; n > 0; n -= sizeof(rec)) s.readBytes(rec, n < (int)sizeof(rec) ? n : sizeof(rec));
+        continue;
+      }
+      s.readBytes(&rec[1], len);
+      s.readBytes((uint8_t *) &crc, 2);
+      if (crc != ripple::Utils::crc16(rec, 1 + len)) break;
+
+      uint16_t slot;
+      memcpy(&slot, &rec[1], 2);
+      if (slot >= DEST_CAPACITY) break;
+      ripple::DestPathEntry* e = &_dest_entries[slot];
+      ripple::DestPathEntry from;
+      memcpy(&from, &rec[3 + DEST_HASH_SIZE], sizeof(from));
+      if (e->last_timestamp != 0 && (e->flags & DEST_FLAG_PARTIAL) && (from.flags & DEST_FLAG_PARTIAL) == 0
+          && from.app_data_len <= MAX_APP_DATA_SIZE
+          && memcmp(&_dest_hashes[slot*DEST_HASH_SIZE], &rec[3], DEST_HASH_SIZE) == 0
+          && memcmp(e->rand_blob, from.rand_blob, sizeof(e->rand_blob)) == 0) {
+        memcpy(e->name_hash, from.name_hash, NAME_HASH_SIZE);
+        memcpy(e->signature, from.signature, SIGNATURE_SIZE);
+        e->app_data_len = from.app_data_len;
+        memcpy(e->app_data, from.app_data, from.app_data_len);
+        e->flags &= ~DEST_FLAG_PARTIAL;
+        num++;
+      }
+    }
+    return num;
   }
 
-  void restoreFrom(File f) {
-    f.read(_fwd_blobs, sizeof(_fwd_blobs));
-    f.read((uint8_t *) &_next_fwd_idx, sizeof(_next_fwd_idx));
+  /**
+   * \brief  Writes a new journal, ie. header and a snapshot of current tables. Caller then typically replaces the
+   *     previous journal file with this one, and passes it (opened for append) to setJournal().
+  */
+  void writeSnapshot(Stream& s) {
+    uint8_t hdr[JOURNAL_HDR_SIZE];
+    headerOf(hdr);
+    uint16_t crc = ripple::Utils::crc16(hdr, sizeof(hdr));
+    s.write(hdr, sizeof(hdr));
+    s.write((const uint8_t *) &crc, 2);
+
+    writeRecord(s, JREC_FILTERS, &_fwd_filter, sizeof(_fwd_filter), &_seen_filter, sizeof(_seen_filter));
+
+    // least recently used first, so that replay rebuilds the same LRU order
+    for (uint16_t slot = _lru_tail; slot != DEST_INDEX_NIL; slot = _lru_prev[slot]) {
+      if (_dest_entries[slot].last_timestamp != 0) writeDestRecord(s, slot);
+    }
+
+    // cyclic tables, oldest first
+    static const uint8_t zeroes[DEST_HASH_SIZE] = { 0 };
+    uint32_t now = _rtc->getCurrentTime();
+    for (int n = 0; n < PACKET_HASHES; n++) {
+      int i = (_next_hash_idx + n) % PACKET_HASHES;
+      if (memcmp(&_seen_hashes[i*DEST_HASH_SIZE], zeroes, DEST_HASH_SIZE) == 0) continue;  // unused
+      writeRecord(s, JREC_SEEN, &_seen_hashes[i*DEST_HASH_SIZE], DEST_HASH_SIZE, &_hash_code[i], 1, &now, 4);
+    }
+    for (int n = 0; n < MAPPING_HASHES; n++) {
+      HashMappingEntry* m = &_hash_mappings[(_next_mapping_idx + n) % MAPPING_HASHES];
+      if (m->timestamp == 0) continue;  // unused
+      writeRecord(s, JREC_MAPPING, m->packet_hash, DEST_HASH_SIZE, m->orig_dest, DEST_HASH_SIZE, &m->timestamp, 4);
+    }
+    s.flush();
+    _journal_records = 0;
+  }
 
-    f.read(_seen_hashes, sizeof(_seen_hashes));
-    f.read(_hash_code, sizeof(_hash_code));
-    f.read((uint8_t *) &_next_hash_idx, sizeof(_next_hash_idx));
+  /**
+   * \brief  Writes a compact checkpoint of the hot routing state to 'mem', eg. just before deep sleep. Most recently
+   *     used destinations (hash, next-hop, hops, path_cost, timestamps, pub_key), the forwarded Announce filter, recent packet
+   *     hashes (with codes) and packet_hash mappings are kept, as many as will fit, in that order of priority.
+   *     Signatures, app_data, alternates and the seen packet filter are NOT kept.
+   * \returns  number of bytes used.
+  */
+  size_t checkpointTo(ripple::RetainedMemory& mem) const {
+    uint8_t* buf = mem.getBuffer();
+    int avail = (int) mem.getSize() - CHECKPOINT_HDR_SIZE - 4 - 5;   // (less the time, and counts)
+    if (avail < 0) return 0;
+
+    // how many of each fit
+    uint16_t num_dests = 0;
+    uint16_t oldest = DEST_INDEX_NIL;
+    for (uint16_t slot = _lru_head; slot != DEST_INDEX_NIL && _dest_entries[slot].last_timestamp != 0; slot = _lru_next[slot]) {
+      if (avail < CHECKPOINT_DEST_SIZE) break;
+      avail -= CHECKPOINT_DEST_SIZE;
+      num_dests++;
+      oldest = slot;
+    }
+    uint8_t has_fwd = avail >= (int) sizeof(_fwd_filter);
+    if (has_fwd) avail -= sizeof(_fwd_filter);
+    int num_seen = 0;
+    static const uint8_t zeroes[DEST_HASH_SIZE] = { 0 };
+    while (num_seen < PACKET_HASHES && num_seen < 255 && avail >= CHECKPOINT_SEEN_SIZE) {
+      int i = (_next_hash_idx + PACKET_HASHES - 1 - num_seen) % PACKET_HASHES;   // most recent first
+      if (memcmp(&_seen_hashes[i*DEST_HASH_SIZE], zeroes, DEST_HASH_SIZE) == 0) break;   // unused
+      avail -= CHECKPOINT_SEEN_SIZE;
+      num_seen++;
+    }
+    int num_maps = 0;
+    for (int i = 0; i < MAPPING_HASHES && num_maps < 255 && avail >= CHECKPOINT_MAP_SIZE; i++) {
+      if (_hash_mappings[i].timestamp == 0) continue;
+      avail -= CHECKPOINT_MAP_SIZE;
+      num_maps++;
+    }
 
-    f.read((uint8_t *) _hash_mappings, sizeof(_hash_mappings));
-    f.read((uint8_t *) &_next_mapping_idx, sizeof(_next_mapping_idx));
+    uint8_t* dp = &buf[CHECKPOINT_HDR_SIZE];
+    uint32_t now = _rtc->getCurrentTime();
+    memcpy(dp, &now, 4); dp += 4;   // for rebasing the times, if clock restarts
+    memcpy(dp, &num_dests, 2); dp += 2;
+    for (uint16_t slot = oldest; num_dests > 0 && slot != DEST_INDEX_NIL; slot = _lru_prev[slot]) {  // least recent first
+      const ripple::DestPathEntry* e = &_dest_entries[slot];
+      memcpy(dp, &slot, 2); dp += 2;
+      memcpy(dp, &_dest_hashes[slot*DEST_HASH_SIZE], DEST_HASH_SIZE); dp += DEST_HASH_SIZE;
+      memcpy(dp, e->transport_id, DEST_HASH_SIZE); dp += DEST_HASH_SIZE;
+      *dp++ = e->header;
+      *dp++ = e->hops;
+      *dp++ = e->path_cost;
+      memcpy(dp, &e->create_timestamp, 4); dp += 4;
+      memcpy(dp, &e->last_timestamp, 4); dp += 4;
+      memcpy(dp, e->rand_blob, 8); dp += 8;
+      memcpy(dp, e->pub_key, PUB_KEY_SIZE); dp += PUB_KEY_SIZE;
+    }
+    *dp++ = has_fwd;
+    if (has_fwd) {
+      memcpy(dp, &_fwd_filter, sizeof(_fwd_filter)); dp += sizeof(_fwd_filter);
+    }
+    *dp++ = num_seen;
+    for (int n = num_seen - 1; n >= 0; n--) {   // oldest first
+      int i = (_next_hash_idx + PACKET_HASHES - 1 - n) % PACKET_HASHES;
+      memcpy(dp, &_seen_hashes[i*DEST_HASH_SIZE], DEST_HASH_SIZE); dp += DEST_HASH_SIZE;
+      *dp++ = _hash_code[i];
+    }
+    *dp++ = num_maps;
+    for (int i = 0; i < MAPPING_HASHES && num_maps > 0; i++) {
+      const HashMappingEntry* m = &_hash_mappings[i];
+      if (m->timestamp == 0) continue;
+      memcpy(dp, m->packet_hash, DEST_HASH_SIZE); dp += DEST_HASH_SIZE;
+      memcpy(dp, m->orig_dest, DEST_HASH_SIZE); dp += DEST_HASH_SIZE;
+      memcpy(dp, &m->timestamp, 4); dp += 4;
+      num_maps--;
+    }
 
-    f.read(_dest_hashes, sizeof(_dest_hashes));
-    f.read((uint8_t *) _dest_entries, sizeof(_dest_entries));
+    uint16_t len = dp - &buf[CHECKPOINT_HDR_SIZE];
+    uint16_t v;
+    v = CHECKPOINT_MAGIC; memcpy(&buf[0], &v, 2);
+    buf[2] = CHECKPOINT_VERSION;
+    v = DEST_CAPACITY; memcpy(&buf[3], &v, 2);
+    memcpy(&buf[5], &len, 2);
+    v = ripple::Utils::crc16(&buf[CHECKPOINT_HDR_SIZE], len); memcpy(&buf[7], &v, 2);
+    return CHECKPOINT_HDR_SIZE + len;
   }
-  void saveTo(File f) {
-    f.write(_fwd_blobs, sizeof(_fwd_blobs));
-    f.write((const uint8_t *) &_next_fwd_idx, sizeof(_next_fwd_idx));
 
-    f.write(_seen_hashes, sizeof(_seen_hashes));
-    f.write(_hash_code, sizeof(_hash_code));
-    f.write((const uint8_t *) &_next_hash_idx, sizeof(_next_hash_idx));
+  /**
+   * \brief  Restores a checkpoint (from checkpointTo()) into these tables, which should be empty. The checkpoint is then
+   *     invalidated, so is only ever used once. Restored destinations are flagged DEST_FLAG_PARTIAL, so are used for
+   *     routing, and verifying signed replies, but aren't replayed for path requests until a fresh Announce is heard,
+   *     or completeFromJournal() is called. If the RTC clock is now behind the time of the checkpoint (ie. it has
+   *     restarted), the restored times are moved back by the difference.
+   * \returns  false if 'mem' holds no valid checkpoint (for this build).
+  */
+  bool restoreCheckpoint(ripple::RetainedMemory& mem) {
+    uint8_t* buf = mem.getBuffer();
+    uint16_t magic, capacity, len, crc;
+    if (mem.getSize() < CHECKPOINT_HDR_SIZE) return false;
+    memcpy(&magic, &buf[0], 2);
+    memcpy(&capacity, &buf[3], 2);
+    memcpy(&len, &buf[5], 2);
+    memcpy(&crc, &buf[7], 2);
+    if (magic != CHECKPOINT_MAGIC || buf[2] != CHECKPOINT_VERSION || capacity != DEST_CAPACITY
+      || len > mem.getSize() - CHECKPOINT_HDR_SIZE || crc != ripple::Utils::crc16(&buf[CHECKPOINT_HDR_SIZE], len)) {
+      return false;
+    }
+    memset(buf, 0, CHECKPOINT_HDR_SIZE);   // invalidate
+
+    // check the counts fit in 'len' (the CRC only guards against corruption)
+    const uint8_t* sp = &buf[CHECKPOINT_HDR_SIZE];
+    const uint8_t* end = sp + len;
+    uint32_t saved_at;
+    uint16_t num_dests;
+    if (end - sp < 4 + 2) return false;
+    memcpy(&saved_at, sp, 4); sp += 4;
+    memcpy(&num_dests, sp, 2); sp += 2;
+    if (end - sp < num_dests*CHECKPOINT_DEST_SIZE + 1) return false;
+    const uint8_t* dests = sp; sp += num_dests*CHECKPOINT_DEST_SIZE;
+    uint8_t has_fwd = *sp++;
+    if (has_fwd && end - sp < (int) sizeof(_fwd_filter)) return false;
+    const uint8_t* fwd = has_fwd ? sp : NULL; sp += has_fwd ? sizeof(_fwd_filter) : 0;
+    if (end - sp < 1) return false;
+    int num_seen = *sp++;
+    if (end - sp < num_seen*CHECKPOINT_SEEN_SIZE + 1) return false;
+    const uint8_t* seen = sp; sp += num_seen*CHECKPOINT_SEEN_SIZE;
+    int num_maps = *sp++;
+    if (end - sp < num_maps*CHECKPOINT_MAP_SIZE) return false;
+    const uint8_t* maps = sp;
+
+    Stream* saved = _journal;
+    _journal = NULL;   // journal already has these
+    sp = dests;
+    ripple::DestPathEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.flags = DEST_FLAG_PARTIAL;
+    for (int n = 0; n < num_dests; n++) {
+      uint16_t slot;
+      memcpy(&slot, sp, 2); sp += 2;
+      const uint8_t* hash = sp; sp += DEST_HASH_SIZE;
+      memcpy(entry.transport_id, sp, DEST_HASH_SIZE); sp += DEST_HASH_SIZE;
+      entry.header = *sp++;
+      entry.hops = *sp++;
+      entry.path_cost = *sp++;
+      memcpy(&entry.create_timestamp, sp, 4); sp += 4;
+      memcpy(&entry.last_timestamp, sp, 4); sp += 4;
+      memcpy(entry.rand_blob, sp, 8); sp += 8;
+      memcpy(entry.pub_key, sp, PUB_KEY_SIZE); sp += PUB_KEY_SIZE;
+      if (slot < DEST_CAPACITY) saveDest(slot, hash, entry);   // (least recent first, so LRU order is kept)
+    }
+    if (fwd) memcpy(&_fwd_filter, fwd, sizeof(_fwd_filter));
+    // NOTE: tables are empty, so no need to lookup existing entries (as applySeen(), applyMapping() do)
+    for (int n = 0; n < num_maps; n++, maps += CHECKPOINT_MAP_SIZE) {
+      HashMappingEntry* m = &_hash_mappings[_next_mapping_idx];
+      _next_mapping_idx = (_next_mapping_idx + 1) % MAPPING_HASHES;
+      memcpy(m->packet_hash, maps, DEST_HASH_SIZE);
+      memcpy(m->orig_dest, &maps[DEST_HASH_SIZE], DEST_HASH_SIZE);
+      memcpy(&m->timestamp, &maps[2*DEST_HASH_SIZE], 4);
+    }
+    rebaseTimes(saved_at);
+
+    uint32_t now = _rtc->getCurrentTime();
+    _seen_filter.clear(now);   // (not kept, so isn't to be rebased)
+    sp = seen;
+    for (int n = 0; n < num_seen; n++, sp += CHECKPOINT_SEEN_SIZE) {
+      _seen_filter.add(sp, now);
+      memcpy(&_seen_hashes[_next_hash_idx*DEST_HASH_SIZE], sp, DEST_HASH_SIZE);
+      _hash_code[_next_hash_idx] = sp[DEST_HASH_SIZE];
+      _next_hash_idx = (_next_hash_idx + 1) % PACKET_HASHES;
+    }
+    _journal = saved;
+    return true;
+  }
 
-    f.write((const uint8_t *) _hash_mappings, sizeof(_hash_mappings));
-    f.write((const uint8_t *) &_next_mapping_idx, sizeof(_next_mapping_idx));
+  /**
+   * \brief  From now on, all table changes are appended to 'journal'. (NULL to stop)
+  */
+  void setJournal(Stream* journal) {
+    flushJournal();
+    _journal = journal;
+  }
 
-    f.write(_dest_hashes, sizeof(_dest_hashes));
-    f.write((const uint8_t *) _dest_entries, sizeof(_dest_entries));
+  /**
+   * \brief  Writes out any buffered journal records. Is done periodically by sweepExpired(), but call before power down.
+  */
+  void flushJournal() {
+    if (_journal && _journal_unflushed > 0) _journal->flush();
+    _journal_unflushed = 0;
   }
 
+  /**
+   * \returns  true if enough has been appended to journal since last writeSnapshot() that it should be compacted.
+  */
+  bool needsCompaction() const { return _journal_records >= JOURNAL_COMPACT_RECORDS; }
+
   bool hasForwarded(const uint8_t* rand_blob) const override {
-    const uint8_t* sp = _fwd_blobs;
-    while (sp - _fwd_blobs < sizeof(_fwd_blobs)) {
-      if (memcmp(rand_blob, sp, 8) == 0) return true;
-      sp += 8;
-    }
-    return false;
+    return _fwd_filter.contains(rand_blob, _rtc->getCurrentTime());
   }
 
   void setHasForwarded(const uint8_t* rand_blob) override {
-    memcpy(&_fwd_blobs[_next_fwd_idx*8], rand_blob, 8);
-    _next_fwd_idx = (_next_fwd_idx + 1) % MAX_RAND_BLOBS;  // cyclic table
+    uint32_t now = _rtc->getCurrentTime();
+    _fwd_filter.add(rand_blob, now);
+    journal(JREC_FORWARDED, rand_blob, 8, &now, 4);
   }
 
   int getSeenPacketHash(const uint8_t* hash) const override {
     int i = lookupHashIndex(hash);
-    return i >= 0 ? _hash_code[i] : 0;
+    if (i >= 0) return _hash_code[i];   // recent, so know the exact code
+
+    // older, but still within window. (codes other than 1 are only kept in recent table)
+    return _seen_filter.contains(hash, _rtc->getCurrentTime()) ? 1 : 0;
   }
 
   void setSeenPacketHash(const uint8_t* hash, int code) override {
-    int i = lookupHashIndex(hash);
-    if (i >= 0) {
-      _hash_code[i] = (uint8_t) code;
-    } else {
-      memcpy(&_seen_hashes[_next_hash_idx*DEST_HASH_SIZE], hash, DEST_HASH_SIZE);
-      _hash_code[_next_hash_idx] = (uint8_t) code;
+    uint32_t now = _rtc->getCurrentTime();
+    applySeen(hash, code, now);
 
-      _next_hash_idx = (_next_hash_idx + 1) % MAX_PACKET_HASHES;  // cyclic table
-    }
+    uint8_t c = code;
+    journal(JREC_SEEN, hash, DEST_HASH_SIZE, &c, 1, &now, 4);
   }
 
   bool getPacketHashDest(const uint8_t* packet_hash, uint8_t* destination_hash) override {
     int i = lookupMappingIndex(packet_hash);
-    if (i >= 0) {
+    if (i >= 0 && _rtc->getCurrentTime() - _hash_mappings[i].timestamp <= MAPPING_EXPIRY_SECS) {
       memcpy(destination_hash, _hash_mappings[i].orig_dest, DEST_HASH_SIZE);
       return true;
     }
     return false;
   }
   void setPacketHashDest(const uint8_t* packet_hash, const uint8_t* destination_hash) override {
-    int i = lookupMappingIndex(packet_hash);
-    if (i < 0) {   // not found, append to table (cyclic)
-      i = _next_mapping_idx;
-      _next_mapping_idx = (_next_mapping_idx + 1) % MAX_MAPPING_HASHES;
-
-      memcpy(_hash_mappings[i].packet_hash, packet_hash, DEST_HASH_SIZE);  // set the key
-    }
-    memcpy(_hash_mappings[i].orig_dest, destination_hash, DEST_HASH_SIZE);
+    uint32_t now = _rtc->getCurrentTime();
+    applyMapping(packet_hash, destination_hash, now);
+    journal(JREC_MAPPING, packet_hash, DEST_HASH_SIZE, destination_hash, DEST_HASH_SIZE, &now, 4);
   }
   void clearPacketHashDest(const uint8_t* packet_hash) override {
     int i = lookupMappingIndex(packet_hash);
     if (i >= 0) {
       memset(_hash_mappings[i].packet_hash, 0, DEST_HASH_SIZE);  // clear the key
+      _hash_mappings[i].timestamp = 0;
+      journal(JREC_CLEAR_MAPPING, packet_hash, DEST_HASH_SIZE);
     }
   }
 
+  int sweepExpired(int max_entries) override {
+    uint32_t now = _rtc->getCurrentTime();
+    if (_journal_unflushed > 0 && now - _journal_unflushed_since >= JOURNAL_FLUSH_SECS) flushJournal();   // (this is called periodically)
+
+    int num_removed = 0;
+    for (int n = 0; n < max_entries; n++) {
+      int i = _sweep_idx;
+      _sweep_idx = (_sweep_idx + 1) % (DEST_CAPACITY + MAPPING_HASHES);
+
+      if (i < DEST_CAPACITY) {
+        if (_dest_entries[i].last_timestamp != 0 && isPathExpired(&_dest_entries[i])) {
+          removeDest(i);
+          num_removed++;
+        }
+      } else {
+        HashMappingEntry* m = &_hash_mappings[i - DEST_CAPACITY];
+        if (m->timestamp != 0 && now - m->timestamp > MAPPING_EXPIRY_SECS) {
+          journal(JREC_CLEAR_MAPPING, m->packet_hash, DEST_HASH_SIZE);
+          memset(m, 0, sizeof(*m));
+          num_removed++;
+        }
+      }
+    }
+    return num_removed;
+  }
+
   uint32_t getActiveNextHopCount(uint32_t max_age_secs) const override {
     uint32_t count = 0;
     uint32_t min_time = _rtc->getCurrentTime() - max_age_secs;
-    for (int i = 0; i < MAX_DEST_HASHES; i++) {
+    for (int i = 0; i < DEST_CAPACITY; i++) {
       if (_dest_entries[i].last_timestamp > min_time) count++;
     }
     return count;
   }
 };
+
+typedef SizedMeshTables<> SimpleMeshTables;
\ No newline at end of file
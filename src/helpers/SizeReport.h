@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * \brief  Build time report of the RAM footprint of each instantiation of the sized helpers (SizedMeshTables, etc).
+ *     Build with -D SIZE_REPORT (and without -w), and the compiler emits a warning per instantiation, like:
+ *        warning: '... RamFootprint<T, SIZE>::bytes() [with T = SizedMeshTables<64, 64, 64, 8192, 2048>; SIZE = 19832]'
+ *          is deprecated: RAM footprint report
+*/
+#if SIZE_REPORT
+  template <typename T, size_t SIZE = sizeof(T)>
+  struct RamFootprint {
+    [[deprecated("RAM footprint report")]] static constexpr size_t bytes() { return SIZE; }
+  };
+  #define REPORT_RAM_FOOTPRINT(T)   static_assert(RamFootprint<T>::bytes() > 0, "")
+#else
+  #define REPORT_RAM_FOOTPRINT(T)
+#endif
@@ -1,46 +1,43 @@
 #include "StaticPoolPacketManager.h"
+#include <string.h>
 
-PacketQueue::PacketQueue(int max_entries) {
-  _table = new ripple::Packet*[max_entries];
-  _pri_table = new uint8_t[max_entries];
-  _schedule_table = new uint32_t[max_entries];
+PacketQueue::PacketQueue(QueueEntry* entries, int max_entries) {
+  _entries = entries;
   _size = max_entries;
   _num = 0;
 }
 
-ripple::Packet* PacketQueue::get(uint32_t now) {
+ripple::Packet* PacketQueue::get(uint32_t now, uint8_t* priority) {
   uint8_t min_pri = 0xFF;
   int best_idx = -1;
   for (int j = 0; j < _num; j++) {
-    if (_schedule_table[j] > now) continue;   // scheduled for future... ignore for now
-    if (_pri_table[j] < min_pri) {  // select most important priority amongst non-future entries
-      min_pri = _pri_table[j];
+    if ((int32_t)(_entries[j].scheduled_for - now) > 0) continue;   // scheduled for future... ignore for now  (handles millis() wrap-around)
+    if (_entries[j].priority < min_pri) {  // select most important priority amongst non-future entries
+      min_pri = _entries[j].priority;
       best_idx = j;
     }
   }
   if (best_idx < 0) return NULL;   // empty, or all items are still in the future
+  if (priority) *priority = min_pri;
 
-  ripple::Packet* top = _table[best_idx];
-  int i = best_idx;
-  _num--;
-  while (i < _num) {
-    _table[i] = _table[i+1];
-    _pri_table[i] = _pri_table[i+1];
-    _schedule_table[i] = _schedule_table[i+1];
-    i++;
+  return removeByIdx(best_idx);
+}
+
+uint32_t PacketQueue::nextScheduled() const {
+  uint32_t soonest = _entries[0].scheduled_for;
+  for (int j = 1; j < _num; j++) {
+    if ((int32_t)(_entries[j].scheduled_for - soonest) < 0) soonest = _entries[j].scheduled_for;
   }
-  return top;
+  return soonest;
 }
 
 ripple::Packet* PacketQueue::removeByIdx(int i) {
   if (i >= _num) return NULL;  // invalid index
 
-  ripple::Packet* item = _table[i];
+  ripple::Packet* item = _entries[i].packet;
   _num--;
   while (i < _num) {
-    _table[i] = _table[i+1];
-    _pri_table[i] = _pri_table[i+1];
-    _schedule_table[i] = _schedule_table[i+1];
+    _entries[i] = _entries[i+1];
     i++;
   }
   return item;
@@ -51,34 +48,82 @@ void PacketQueue::add(ripple::Packet* packet, uint8_t priority, uint32_t schedul
     // TODO: log "FATAL: queue is full!"
     return;
   }
-  _table[_num] = packet;
-  _pri_table[_num] = priority;
-  _schedule_table[_num] = scheduled_for;
+  _entries[_num].packet = packet;
+  _entries[_num].priority = priority;
+  _entries[_num].scheduled_for = scheduled_for;
   _num++;
 }
 
-StaticPoolPacketManager::StaticPoolPacketManager(int pool_size): unused(pool_size), send_queue(pool_size) {
-  // load up our unusued Packet pool
-  for (int i = 0; i < pool_size; i++) {
-    unused.add(new ripple::Packet(), 0, 0);
+// while a Packet is in the free list, its payload holds the link to the next free Packet
+static inline ripple::Packet* getFreeLink(const ripple::Packet* packet) {
+  ripple::Packet* next;
+  memcpy(&next, packet->payload, sizeof(next));
+  return next;
+}
+static inline void setFreeLink(ripple::Packet* packet, ripple::Packet* next) {
+  memcpy(packet->payload, &next, sizeof(next));
+}
+
+StaticPoolPacketManager::StaticPoolPacketManager(ripple::Packet* pool, int pool_size, QueueEntry* send_queue_entries, int send_queue_size)
+  : send_queue(send_queue_entries, send_queue_size)
+{
+  _pool = pool;
+  _pool_size = pool_size;
+
+  // load up our unused Packet pool (in order, so first allocNew() gets _pool[0])
+  _free_head = NULL;
+  for (int i = pool_size - 1; i >= 0; i--) {
+    setFreeLink(&_pool[i], _free_head);
+    _free_head = &_pool[i];
   }
+  _num_free = pool_size;
+}
+
+int StaticPoolPacketManager::poolIndexOf(const ripple::Packet* packet) const {
+  if (packet < _pool || packet >= &_pool[_pool_size]) return -1;   // not from our pool
+  return packet - _pool;
 }
 
 ripple::Packet* StaticPoolPacketManager::allocNew() {
-  return unused.removeByIdx(0);  // just get first one (returns NULL if empty)
+  ripple::Packet* packet = _free_head;
+  if (packet == NULL) return NULL;   // pool is empty
+
+  _free_head = getFreeLink(packet);
+  _num_free--;
+  return packet;
 }
 
 void StaticPoolPacketManager::free(ripple::Packet* packet) {
-  unused.add(packet, 0, 0);
+#if RIPPLE_DEBUG
+  int i = poolIndexOf(packet);
+  if (i < 0) {
+    RIPPLE_DEBUG_PRINTLN("StaticPoolPacketManager::free(): FATAL: packet is not from this pool!");
+    return;
+  }
+  for (ripple::Packet* p = _free_head; p; p = getFreeLink(p)) {   // O(n), but only in debug builds
+    if (p == packet) {
+      RIPPLE_DEBUG_PRINTLN("StaticPoolPacketManager::free(): FATAL: packet double-free, idx=%d", i);
+      return;
+    }
+  }
+#endif
+  packet->resetPayload();   // (free link, and next user, expect it in the usual position)
+  setFreeLink(packet, _free_head);
+  _free_head = packet;
+  _num_free++;
 }
 
 void StaticPoolPacketManager::queueOutbound(ripple::Packet* packet, uint8_t priority, uint32_t scheduled_for) {
   send_queue.add(packet, priority, scheduled_for);
 }
 
-ripple::Packet* StaticPoolPacketManager::getNextOutbound(uint32_t now) {
+ripple::Packet* StaticPoolPacketManager::getNextOutbound(uint32_t now, uint8_t* priority) {
   //send_queue.sort();   // sort by scheduled_for/priority first
-  return send_queue.get(now);
+  return send_queue.get(now, priority);
+}
+
+uint32_t StaticPoolPacketManager::getNextOutboundTime() const {
+  return send_queue.nextScheduled();
 }
 
 int  StaticPoolPacketManager::getOutboundCount() const {
@@ -86,7 +131,7 @@ int  StaticPoolPacketManager::getOutboundCount() const {
 }
 
 int StaticPoolPacketManager::getFreeCount() const {
-  return unused.count();
+  return _num_free;
 }
 
 ripple::Packet* StaticPoolPacketManager::getOutboundByIdx(int i) {
@@ -1,34 +1,79 @@
 #pragma once
 
 #include <Dispatcher.h>
+#include "SizeReport.h"
+
+struct QueueEntry {
+  ripple::Packet* packet;
+  uint32_t scheduled_for;
+  uint8_t  priority;
+};
 
 class PacketQueue {
-  ripple::Packet** _table;
-  uint8_t* _pri_table;
-  uint32_t* _schedule_table;
+  QueueEntry* _entries;
   int _size, _num;
 
 public:
-  PacketQueue(int max_entries);
-  ripple::Packet* get(uint32_t now);
+  PacketQueue(QueueEntry* entries, int max_entries);
+  ripple::Packet* get(uint32_t now, uint8_t* priority=NULL);
+  uint32_t nextScheduled() const;
   void add(ripple::Packet* packet, uint8_t priority, uint32_t scheduled_for);
   int count() const { return _num; }
-  ripple::Packet* itemAt(int i) const { return _table[i]; }
+  ripple::Packet* itemAt(int i) const { return _entries[i].packet; }
   ripple::Packet* removeByIdx(int i);
 };
 
+/**
+ * \brief  Packets are allocated from a fixed pool. Unused Packets are kept in an intrusive LIFO free list,
+ *       (the link to next free Packet is stored in the unused Packet's payload) so allocNew() and free() are O(1).
+ *       Storage is provided by sub-classes, see SizedPoolPacketManager.
+*/
 class StaticPoolPacketManager : public ripple::PacketManager {
-  PacketQueue unused, send_queue;
+  ripple::Packet* _pool;
+  ripple::Packet* _free_head;
+  int _pool_size, _num_free;
+  PacketQueue send_queue;
 
-public:
-  StaticPoolPacketManager(int pool_size);
+  int poolIndexOf(const ripple::Packet* packet) const;
 
+protected:
+  /**
+   * \param pool  storage for 'pool_size' Packets
+   * \param send_queue_entries  storage for the outbound queue (NULL, if sub-class manages its own outbound queue)
+  */
+  StaticPoolPacketManager(ripple::Packet* pool, int pool_size, QueueEntry* send_queue_entries, int send_queue_size);
+
+public:
   ripple::Packet* allocNew() override;
   void free(ripple::Packet* packet) override;
   void queueOutbound(ripple::Packet* packet, uint8_t priority, uint32_t scheduled_for) override;
-  ripple::Packet* getNextOutbound(uint32_t now) override;
+  ripple::Packet* getNextOutbound(uint32_t now, uint8_t* priority=NULL) override;
+  uint32_t getNextOutboundTime() const override;
   int getOutboundCount() const override;
   int getFreeCount() const override;
   ripple::Packet* getOutboundByIdx(int i) override;
   ripple::Packet* removeOutboundByIdx(int i) override;
-};
\ No newline at end of file
+};
+
+// is a base class (rather than members) of the managers, so is constructed first
+template <int POOL_SIZE>
+struct PacketPoolStorage {
+  ripple::Packet _pool_storage[POOL_SIZE];
+  QueueEntry _queue_storage[POOL_SIZE];
+};
+
+/**
+ * \brief  StaticPoolPacketManager with its Packet pool, and outbound queue, statically allocated.
+ * \tparam  POOL_SIZE  number of Packets. Outbound queue can hold all of them.
+*/
+template <int POOL_SIZE>
+class SizedPoolPacketManager : private PacketPoolStorage<POOL_SIZE>, public StaticPoolPacketManager {
+  static_assert(POOL_SIZE >= 2, "need at least one inbound, and one outbound Packet");
+
+public:
+  SizedPoolPacketManager()
+    : StaticPoolPacketManager(this->_pool_storage, POOL_SIZE, this->_queue_storage, POOL_SIZE)
+  {
+    REPORT_RAM_FOOTPRINT(SizedPoolPacketManager);
+  }
+};
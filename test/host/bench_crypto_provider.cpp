@@ -0,0 +1,73 @@
+#include "test.h"
+#include <string.h>
+#include <CryptoProvider.h>
+
+/*
+ * Throughput of the CryptoSHA256 / CryptoAES128 backend this is built with, versus the plain SHA256 / AES128 reference
+ * classes (as the software backend uses), at packet sizes and for a large buffer. AES is ECB, including setKey(), as
+ * Utils::encryptThenMAC() does it per packet. Compare: make bench BUILD=build-soft DEFS=-DCRYPTO_PROVIDER=0
+*/
+using namespace ripple;
+
+static uint8_t buf[4096], out[4096];
+
+// best of several runs, as the host is often busy with other work
+template<typename F> double bestNanos(F fn) {
+  double best = 1e18;
+  for (int i = 0; i < 7; i++) {
+    double t = benchNanos(fn, 50);
+    if (t < best) best = t;
+  }
+  return best;
+}
+
+int main() {
+  for (int i = 0; i < (int) sizeof(buf); i++) buf[i] = i * 7;
+  uint8_t hash[32], key[16] = { 1, 2, 3 };
+
+  printf("provider: %s\n", getCryptoProviderName());
+  printf("%-22s %12s %12s %8s %10s\n", "us per call", "reference", "provider", "", "MB/s");
+  int sizes[] = { 100, 184, 4096 };
+  for (int len : sizes) {
+    double ref = bestNanos([&]() {
+      SHA256 sha;
+      sha.update(buf, len);
+      sha.finalize(hash, 32);
+      buf[0] ^= hash[0];
+    });
+    double provider = bestNanos([&]() {
+      CryptoSHA256 sha;
+      sha.update(buf, len);
+      sha.finalize(hash, 32);
+      buf[0] ^= hash[0];
+    });
+    printf("sha256 %4d bytes       %12.2f %12.2f  (x%4.1f) %10.0f\n", len, ref / 1000, provider / 1000, ref / provider, len * 1e3 / provider);
+  }
+  for (int len : sizes) {
+    double provider = bestNanos([&]() {
+      CryptoSHA256 sha;
+      sha.resetHMAC(key, sizeof(key));
+      sha.update(buf, len);
+      sha.finalizeHMAC(key, sizeof(key), hash, 32);
+      buf[0] ^= hash[0];
+    });
+    printf("hmac-sha256 %4d bytes  %12s %12.2f  %8s %10.0f\n", len, "", provider / 1000, "", len * 1e3 / provider);
+  }
+  for (int len : sizes) {
+    int num_blocks = len / 16;
+    double ref = bestNanos([&]() {
+      AES128 aes;
+      aes.setKey(key, 16);
+      for (int b = 0; b < num_blocks; b++) aes.encryptBlock(&out[16*b], &buf[16*b]);
+      key[0] ^= out[0];
+    });
+    double provider = bestNanos([&]() {
+      CryptoAES128 aes;
+      aes.setKey(key, 16);
+      aes.encryptBlocks(out, buf, num_blocks);
+      key[0] ^= out[0];
+    });
+    printf("aes128 %4d bytes       %12.2f %12.2f  (x%4.1f) %10.0f\n", num_blocks*16, ref / 1000, provider / 1000, ref / provider, num_blocks*16 * 1e3 / provider);
+  }
+  return 0;
+}
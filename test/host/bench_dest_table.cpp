@@ -0,0 +1,141 @@
+#include "test.h"
+#include "sim.h"
+#include <helpers/SimpleMeshTables.h>
+#include <new>
+
+/*
+ * Destination table operations on the hash index + LRU list of SizedMeshTables, versus the previous linear scans
+ * (of every slot for lookupDest(), and for the oldest last_timestamp in findFreeDest()), at various capacities.
+ * Also the cost of constructing an empty table, at capacities up to the limit.
+*/
+using namespace ripple;
+
+struct TestClock : public RTCClock {
+  uint32_t now = 1715770351;
+  uint32_t getCurrentTime() override { return now; }
+  void setCurrentTime(uint32_t time) override { now = time; }
+};
+
+// the previous destination table. Other tables are stubbed out, as they aren't measured here
+template <int N>
+class LinearMeshTables : public MeshTables {
+  uint8_t _dest_hashes[N*DEST_HASH_SIZE];
+  DestPathEntry _dest_entries[N];
+
+protected:
+  bool lookupDest(const uint8_t* hash, uint32_t& handle, DestPathEntry* dest) const override {
+    const uint8_t* sp = _dest_hashes;
+    for (int i = 0; i < N; i++, sp += DEST_HASH_SIZE) {
+      if (_dest_entries[i].last_timestamp != 0 && memcmp(hash, sp, DEST_HASH_SIZE) == 0) {
+        handle = i;
+        if (dest) *dest = _dest_entries[i];
+        return true;
+      }
+    }
+    return false;
+  }
+  uint32_t findFreeDest() override {
+    int min_i = 0;
+    uint32_t min_time = 0xFFFFFFFF;
+    for (int i = 0; i < N; i++) {
+      if (_dest_entries[i].last_timestamp < min_time) {
+        min_i = i;
+        min_time = _dest_entries[i].last_timestamp;
+      }
+    }
+    if (min_time > _rtc->getCurrentTime() - KEEP_ALIVE_SECS) return NIL_TABLE_HANDLE;
+    return min_i;
+  }
+  bool saveDest(uint32_t handle, const uint8_t* hash, const DestPathEntry& dest) override {
+    memcpy(&_dest_hashes[handle*DEST_HASH_SIZE], hash, DEST_HASH_SIZE);
+    _dest_entries[handle] = dest;
+    return true;
+  }
+  const DestPathEntry* getDestEntry(uint32_t handle) const override { return &_dest_entries[handle]; }
+  const uint8_t* getDestHash(uint32_t handle) const override { return &_dest_hashes[handle*DEST_HASH_SIZE]; }
+  DestPathEntry* editNextHops(uint32_t handle) override { return &_dest_entries[handle]; }
+  void saveNextHops(uint32_t handle) override { }
+  void touch(uint32_t handle) override { _dest_entries[handle].last_timestamp = _rtc->getCurrentTime(); }
+  void removeDest(uint32_t handle) override { _dest_entries[handle].last_timestamp = 0; }
+
+public:
+  LinearMeshTables(RTCClock& rtc): MeshTables(rtc) { memset(_dest_entries, 0, sizeof(_dest_entries)); }
+
+  bool hasForwarded(const uint8_t* rand_blob) const override { return false; }
+  void setHasForwarded(const uint8_t* rand_blob) override { }
+  int getSeenPacketHash(const uint8_t* hash) const override { return 0; }
+  void setSeenPacketHash(const uint8_t* hash, int code) override { }
+  bool getPacketHashDest(const uint8_t* packet_hash, uint8_t* destination_hash) override { return false; }
+  void setPacketHashDest(const uint8_t* packet_hash, const uint8_t* destination_hash) override { }
+  void clearPacketHashDest(const uint8_t* packet_hash) override { }
+  int sweepExpired(int max_entries) override { return 0; }
+  uint32_t getActiveNextHopCount(uint32_t max_age_secs) const override { return 0; }
+};
+
+static void makeHash(uint8_t* hash, uint32_t n) {
+  uint32_t x = n * 2654435761u;
+  for (int i = 0; i < DEST_HASH_SIZE; i++, x = x * 1103515245u + 12345) hash[i] = x >> 24;
+}
+
+struct Timings { double hit, miss, insert; };
+
+template <typename T> Timings measure(int n) {
+  TestClock clock;
+  T* tables = new T(clock);   // (not deleted, as MeshTables has no virtual destructor)
+  Packet pkt;
+  uint8_t hash[DEST_HASH_SIZE], next_hop[DEST_HASH_SIZE];
+
+  for (int i = 0; i < n; i++) {   // fill
+    makeHash(hash, i);
+    makeTableAnnounce(&pkt, clock.now, i, 2);
+    tables->updateNextHop(hash, &pkt);
+  }
+  clock.now += KEEP_ALIVE_SECS + 1;
+
+  Timings t;
+  uint32_t k = 0;
+  t.hit = benchNanos([&]() { makeHash(hash, (k++ * 7919) % n); tables->getNextHop(hash, next_hop); }, 100);
+  t.miss = benchNanos([&]() { makeHash(hash, n + (k++ % 100000)); tables->getNextHop(hash, next_hop); }, 100);
+
+  // new destinations, each evicting the least recently used
+  uint32_t next = 1000000;
+  t.insert = benchNanos([&]() {
+    clock.now += KEEP_ALIVE_SECS + 1;
+    makeHash(hash, next);
+    makeTableAnnounce(&pkt, clock.now, next++, 2);
+    tables->updateNextHop(hash, &pkt);
+  }, 100);
+
+  return t;
+}
+
+template <int N> void row() {
+  Timings lin = measure<LinearMeshTables<N>>(N);
+  Timings idx = measure<SizedMeshTables<N>>(N);
+  printf("%8d %10.0f %10.0f %10.0f %10.0f %10.0f %10.0f\n", N, lin.hit, idx.hit, lin.miss, idx.miss, lin.insert, idx.insert);
+}
+
+// constructing an empty table (eg. in static init), into the same (already touched) memory each time
+template <int N> void constructRow() {
+  TestClock clock;
+  void* mem = malloc(sizeof(SizedMeshTables<N>));
+  double ns = benchNanos([&]() { new (mem) SizedMeshTables<N>(clock); }, 100);
+  free(mem);
+  printf("%8d %10.1f\n", N, ns / 1000);
+}
+
+int main() {
+  printf("ns per op %21s %21s %21s\n", "getNextHop (hit)", "getNextHop (miss)", "insert + evict");
+  printf("%8s %10s %10s %10s %10s %10s %10s\n", "capacity", "linear", "hashed", "linear", "hashed", "linear", "hashed");
+  row<64>();
+  row<256>();
+  row<1024>();
+  row<4096>();
+
+  printf("\nconstruct (us)\n");
+  constructRow<1024>();
+  constructRow<4096>();
+  constructRow<16384>();
+  constructRow<65000>();
+  return 0;
+}
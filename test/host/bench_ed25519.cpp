@@ -0,0 +1,40 @@
+#include "test.h"
+#include <string.h>
+#include <ed_25519.h>
+extern "C" {
+#include <fe.h>   // (for ED25519_FE_51)
+}
+
+/*
+ * lib/ed25519 sign, verify and key exchange, in whichever field arithmetic it is built with. Compare the default
+ * (51 bit limbs, fe_51.c, on 64-bit hosts) with: make bench BUILD=build-fe32 DEFS=-DED25519_FE_32
+*/
+
+// best of several runs, as the host is often busy with other work
+template<typename F> double bestNanos(F fn) {
+  double best = 1e18;
+  for (int i = 0; i < 7; i++) {
+    double t = benchNanos(fn, 50);
+    if (t < best) best = t;
+  }
+  return best;
+}
+
+int main() {
+  uint8_t seed[32] = { 3 }, pub[32], prv[64], pub2[32], prv2[64], sig[64], msg[64] = { 1 }, secret[32];
+  ed25519_create_keypair(pub, prv, seed);
+  seed[0] = 4;
+  ed25519_create_keypair(pub2, prv2, seed);
+  ed25519_sign(sig, msg, sizeof(msg), pub, prv);
+
+#ifdef ED25519_FE_51
+  printf("us per call (51 bit limbs)\n");
+#else
+  printf("us per call (26/25 bit limbs)\n");
+#endif
+  printf("%-16s %8.1f\n", "create_keypair", bestNanos([&]() { ed25519_create_keypair(pub2, prv2, seed); }) / 1000);
+  printf("%-16s %8.1f\n", "sign", bestNanos([&]() { ed25519_sign(sig, msg, sizeof(msg), pub, prv); }) / 1000);
+  printf("%-16s %8.1f\n", "verify", bestNanos([&]() { ed25519_verify(sig, msg, sizeof(msg), pub); }) / 1000);
+  printf("%-16s %8.1f\n", "key_exchange", bestNanos([&]() { ed25519_key_exchange(secret, pub2, prv); }) / 1000);
+  return 0;
+}
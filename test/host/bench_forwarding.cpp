@@ -0,0 +1,122 @@
+#include "test.h"
+#include "sim.h"
+#include <MeshTransportFull.h>
+#include <helpers/SimpleMeshTables.h>
+#include <helpers/StaticPoolPacketManager.h>
+
+/*
+ * Datagram forwarding throughput of a repeater (host CPU time, from frame received to frame sent), with the
+ * in-place table accessors, versus the previous by-value path, where getNextHop() copied the whole DestPathEntry
+ * out of the table, and saveDest() copied it back in, just to update last_timestamp.
+*/
+using namespace ripple;
+
+static SimClock ms;
+static SimRTC rtc;
+static SimRNG rng;
+
+#define NUM_DESTS  64
+// one datagram per (simulated) second, so the seen packet filter stays at its designed load, and paths don't expire
+#define NUM_DATAGRAMS  20000
+
+// the previous getNextHop(): lookupDest() to a copy, then saveDest() of the copy, with the new last_timestamp
+struct ByValueTables : public SimpleMeshTables {
+  mutable DestPathEntry _copy;
+
+  ByValueTables(RTCClock& rtc): SimpleMeshTables(rtc) { }
+
+  bool lookupDest(const uint8_t* hash, uint32_t& handle, DestPathEntry* dest) const override {
+    return SimpleMeshTables::lookupDest(hash, handle, dest ? dest : &_copy);
+  }
+  void touch(uint32_t handle) override {
+    _copy.last_timestamp = _rtc->getCurrentTime();
+    saveDest(handle, getDestHash(handle), _copy);
+  }
+  void addPath(const uint8_t* dest_hash, const Packet* announce) { updateNextHop(dest_hash, announce); }
+};
+
+struct BenchRepeater : public MeshTransportFull {
+  BenchRepeater(Radio& radio, PacketManager& mgr, MeshTables& tables) : MeshTransportFull(radio, ms, rng, rtc, mgr, tables) {
+    setDutyCycle(0);
+    for (int i = 0; i < NUM_AIRTIME_CLASSES; i++) setAirtimeBudget(i, 0, 100000);
+  }
+};
+
+static void makeDestHash(uint8_t* hash, int n) {
+  for (int i = 0; i < DEST_HASH_SIZE; i++) hash[i] = 0x40 + n + i;
+}
+
+struct Timings { double get_next_hop, forward; long n_dropped; };
+
+template <typename T> Timings measure(int payload_len) {
+  srand(3);
+  host_millis = 1000;
+  FrameRadio radio;
+  SizedPoolPacketManager<8> mgr;
+  T* tables = new T(rtc);   // (not deleted, as MeshTables has no virtual destructor)
+  BenchRepeater node(radio, mgr, *tables);
+  node.self_id = LocalIdentity(&rng);
+  node.begin();
+
+  uint8_t self_hash[DEST_HASH_SIZE], dest_hash[DEST_HASH_SIZE];
+  Destination self(node.self_id, "trans.data");
+  memcpy(self_hash, self.hash, DEST_HASH_SIZE);
+
+  Packet announce;
+  for (int d = 0; d < NUM_DESTS; d++) {
+    makeDestHash(dest_hash, d);
+    makeTableAnnounce(&announce, rtc.getCurrentTime(), d, 2);
+    tables->addPath(dest_hash, &announce);
+  }
+
+  std::vector<uint8_t> frame;
+  frame.push_back(PH_TYPE_DATA | PH_HAS_TRANS_ADDRESS);
+  frame.push_back(1);
+  frame.insert(frame.end(), self_hash, self_hash + DEST_HASH_SIZE);
+  frame.insert(frame.end(), DEST_HASH_SIZE, 0);
+  size_t dest_ofs = 2 + DEST_HASH_SIZE;
+  frame.insert(frame.end(), payload_len, 0x5A);
+
+  Timings t;
+  uint8_t next_hop[DEST_HASH_SIZE];
+  int d = 0;
+  t.get_next_hop = benchNanos([&]() {
+    makeDestHash(dest_hash, d++ % NUM_DESTS);
+    tables->getNextHop(dest_hash, next_hop);
+  });
+
+  long n_forwarded = 0;
+  double start = nowNanos();
+  for (uint32_t seq = 0; seq < NUM_DATAGRAMS; seq++) {
+    makeDestHash(&frame[dest_ofs], seq % NUM_DESTS);
+    memcpy(&frame[dest_ofs + DEST_HASH_SIZE], &seq, sizeof(seq));   // so each datagram has a new packet_hash
+    radio.rx.push_back(frame);
+    node.loop();    // received, and queued for retransmit
+    node.loop();    // sent
+    host_millis += 1000;
+    node.loop();    // send completed
+    n_forwarded += radio.sent.size();
+    radio.sent.clear();
+  }
+  t.forward = (nowNanos() - start) / NUM_DATAGRAMS;
+  t.n_dropped = NUM_DATAGRAMS - n_forwarded;   // false positives of the seen packet filter
+  return t;
+}
+
+struct InPlaceTables : public SimpleMeshTables {
+  InPlaceTables(RTCClock& rtc): SimpleMeshTables(rtc) { }
+  void addPath(const uint8_t* dest_hash, const Packet* announce) { updateNextHop(dest_hash, announce); }
+};
+
+int main() {
+  printf("forwarding, ns per datagram (%d destinations, DestPathEntry is %d bytes)\n", NUM_DESTS, (int) sizeof(DestPathEntry));
+  printf("%-16s %25s %25s\n", "", "getNextHop()", "receive to sent");
+  printf("%-16s %12s %12s %12s %12s %12s\n", "payload", "by-value", "in-place", "by-value", "in-place", "not fwded");
+  int sizes[] = { 16, 64, 184 };
+  for (int len : sizes) {
+    Timings before = measure<ByValueTables>(len);
+    Timings after = measure<InPlaceTables>(len);
+    printf("%-16d %12.0f %12.0f %12.0f %12.0f %12ld\n", len, before.get_next_hop, after.get_next_hop, before.forward, after.forward, after.n_dropped);
+  }
+  return 0;
+}
@@ -0,0 +1,89 @@
+#include "test.h"
+#include "sim.h"
+#include <Identity.h>
+#include <ed_25519.h>
+
+/*
+ * Cost of decompressing a public key (ed25519_prepare_key()), and of a verify with the key decompressed each time,
+ * already decompressed (as in a key cache hit), and with its precomputed multiples too (PUBKEY_CACHE_TABLES).
+ * Then Identity::verify() itself, cycling over fewer, and more, identities than PUBKEY_CACHE_SIZE.
+*/
+using namespace ripple;
+
+#define NUM_IDS   64
+#define MSG_LEN   80
+
+static SimRNG rng;
+static Identity ids[NUM_IDS];
+static uint8_t sigs[NUM_IDS][SIGNATURE_SIZE], msgs[NUM_IDS][MSG_LEN];
+static ed25519_key_point points[NUM_IDS];
+static ed25519_key_table tables[NUM_IDS];
+
+// best of several runs, as the host is often busy with other work
+template<typename F> double bestNanos(F fn) {
+  double best = 1e18;
+  for (int i = 0; i < 7; i++) {
+    double t = benchNanos(fn, 50);
+    if (t < best) best = t;
+  }
+  return best;
+}
+
+int main() {
+  srand(1);
+  for (int i = 0; i < NUM_IDS; i++) {
+    LocalIdentity id(&rng);
+    rng.random(msgs[i], MSG_LEN);
+    id.sign(sigs[i], msgs[i], MSG_LEN);
+    ids[i] = id;
+    ed25519_prepare_key(&points[i], &tables[i], ids[i].pub_key);
+  }
+
+  int n = 0;
+  ed25519_key_point A;
+  ed25519_key_table table;
+  printf("us per call\n");
+  printf("%-36s %8.1f\n", "prepare key", bestNanos([&]() {
+    ed25519_prepare_key(&A, NULL, ids[n].pub_key);
+    n = (n + 1) % NUM_IDS;
+  }) / 1000);
+  printf("%-36s %8.1f\n", "prepare key, and its multiples", bestNanos([&]() {
+    ed25519_prepare_key(&A, &table, ids[n].pub_key);
+    n = (n + 1) % NUM_IDS;
+  }) / 1000);
+
+  double plain = bestNanos([&]() {
+    ed25519_verify(sigs[n], msgs[n], MSG_LEN, ids[n].pub_key);
+    n = (n + 1) % NUM_IDS;
+  });
+  printf("%-36s %8.1f\n", "verify, decompressing the key", plain / 1000);
+  double prepared = bestNanos([&]() {
+    ed25519_iovec iov = { msgs[n], MSG_LEN };
+    ed25519_verify_prepared(sigs[n], &iov, 1, ids[n].pub_key, &points[n], NULL);
+    n = (n + 1) % NUM_IDS;
+  });
+  printf("%-36s %8.1f  (x%.2f)\n", "verify, key prepared", prepared / 1000, plain / prepared);
+  double with_table = bestNanos([&]() {
+    ed25519_iovec iov = { msgs[n], MSG_LEN };
+    ed25519_verify_prepared(sigs[n], &iov, 1, ids[n].pub_key, &points[n], &tables[n]);
+    n = (n + 1) % NUM_IDS;
+  });
+  printf("%-36s %8.1f  (x%.2f)\n", "verify, key and multiples prepared", with_table / 1000, plain / with_table);
+
+  // through the cache (PUBKEY_CACHE_SIZE, PUBKEY_CACHE_TABLES as built)
+  int num_ids[] = { 4, NUM_IDS };
+  for (int count : num_ids) {
+    uint32_t hits = Identity::getNumKeyCacheHits(), misses = Identity::getNumKeyCacheMisses();
+    double t = bestNanos([&]() {
+      ids[n].verify(sigs[n], msgs[n], MSG_LEN);
+      n = (n + 1) % count;
+    });
+    hits = Identity::getNumKeyCacheHits() - hits;
+    misses = Identity::getNumKeyCacheMisses() - misses;
+    char label[48];
+    snprintf(label, sizeof(label), "Identity::verify(), %d identities", count);
+    printf("%-36s %8.1f  (x%.2f)  %.0f%% hits\n", label, t / 1000, plain / t, 100.0 * hits / (hits + misses));
+  }
+  printf("(PUBKEY_CACHE_SIZE %d, PUBKEY_CACHE_TABLES %d)\n", PUBKEY_CACHE_SIZE, PUBKEY_CACHE_TABLES);
+  return 0;
+}
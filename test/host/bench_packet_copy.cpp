@@ -0,0 +1,144 @@
+#include "test.h"
+#include "sim.h"
+#include <helpers/StaticPoolPacketManager.h>
+
+/*
+ * Bytes copied per received and sent frame, by the in-place frame buffer in Packet, versus the previous
+ * path through a stack buffer. This binary is linked with --wrap for memcpy/memmove, so every
+ * variable-length copy is counted. (fixed size copies, eg. of 8 byte hashes, are inlined by the compiler,
+ * and are the same in both versions). A received payload is only moved if forwarded with a longer frame header than
+ * it arrived with (eg. an Announce given a transport_id), and then once, on send.
+*/
+using namespace ripple;
+
+static volatile bool counting = false;   // volatile, as the compiler assumes memcpy() reads no globals
+static volatile long bytes_copied = 0;
+
+extern "C" {
+  void* __real_memcpy(void* dest, const void* src, size_t n);
+  void* __real_memmove(void* dest, const void* src, size_t n);
+  void* __wrap_memcpy(void* dest, const void* src, size_t n) {
+    if (counting) bytes_copied += n;
+    return __real_memcpy(dest, src, n);
+  }
+  void* __wrap_memmove(void* dest, const void* src, size_t n) {
+    if (counting) bytes_copied += n;
+    return __real_memmove(dest, src, n);
+  }
+}
+
+// the radio's own transfer (ie. over SPI) is needed either way, so isn't counted
+struct UncountedRadio : public FrameRadio {
+  int recvRaw(uint8_t* bytes, int sz) override {
+    bool c = counting;
+    counting = false;
+    int len = FrameRadio::recvRaw(bytes, sz);
+    counting = c;
+    return len;
+  }
+  void startSendRaw(const uint8_t* bytes, int len) override {
+    bool c = counting;
+    counting = false;
+    FrameRadio::startSendRaw(bytes, len);
+    sent.clear();
+    counting = c;
+  }
+};
+
+static SimClock ms;
+
+struct BenchDispatcher : public Dispatcher {
+  BenchDispatcher(Radio& radio, PacketManager& mgr): Dispatcher(radio, ms, mgr) {
+    setDutyCycle(0);
+    for (int i = 0; i < NUM_AIRTIME_CLASSES; i++) setAirtimeBudget(i, 0, 100000);
+  }
+  DispatcherAction onRecvPacket(Packet* pkt) override { return ACTION_RELEASE; }
+};
+
+// the previous receive path: whole frame into a stack buffer, then fields and payload copied into the Packet
+static void legacyRecv(Radio& radio, PacketManager& mgr) {
+  uint8_t raw[MAX_TRANS_UNIT];
+  int len = radio.recvRaw(raw, MAX_TRANS_UNIT);
+  Packet* pkt = mgr.allocNew();
+  int i = 0;
+  pkt->header = raw[i++];
+  pkt->hops = raw[i++];
+  if (pkt->header & PH_HAS_TRANS_ADDRESS) {
+    memcpy(pkt->transport_id, &raw[i], DEST_HASH_SIZE); i += DEST_HASH_SIZE;
+  }
+  if (pkt->getPacketType() != PH_TYPE_ANNOUNCE) {
+    memcpy(pkt->destination_hash, &raw[i], DEST_HASH_SIZE); i += DEST_HASH_SIZE;
+  }
+  pkt->payload_len = len - i;
+  memcpy(pkt->payload, &raw[i], pkt->payload_len);
+  mgr.free(pkt);
+}
+
+// the previous send path: frame header and payload assembled in a stack buffer
+static void legacySend(Radio& radio, Packet* pkt) {
+  uint8_t raw[MAX_TRANS_UNIT];
+  int len = 0;
+  raw[len++] = pkt->header;
+  raw[len++] = pkt->hops;
+  if (pkt->header & PH_HAS_TRANS_ADDRESS) {
+    memcpy(&raw[len], pkt->transport_id, DEST_HASH_SIZE); len += DEST_HASH_SIZE;
+  }
+  if (pkt->getPacketType() != PH_TYPE_ANNOUNCE) {
+    memcpy(&raw[len], pkt->destination_hash, DEST_HASH_SIZE); len += DEST_HASH_SIZE;
+  }
+  memcpy(&raw[len], pkt->payload, pkt->payload_len); len += pkt->payload_len;
+  radio.startSendRaw(raw, len);
+}
+
+static std::vector<uint8_t> makeFrame(uint8_t header, int payload_len) {
+  std::vector<uint8_t> f(2 + payload_len);
+  f[0] = header;
+  if (header & PH_HAS_TRANS_ADDRESS) f.insert(f.begin() + 2, DEST_HASH_SIZE, 0xA5);
+  if ((header & PH_TYPE_MASK) != PH_TYPE_ANNOUNCE) f.insert(f.begin() + 2, DEST_HASH_SIZE, 0x5A);
+  return f;
+}
+
+int main() {
+  struct { const char* name; uint8_t header; int payload_len; } cases[] = {
+    { "announce, 136 B payload", PH_TYPE_ANNOUNCE, 136 },
+    { "datagram, 64 B", PH_TYPE_DATA, 64 },
+    { "datagram, 64 B, transport_id", PH_TYPE_DATA | PH_HAS_TRANS_ADDRESS, 64 },
+    { "datagram, 235 B, transport_id", PH_TYPE_DATA | PH_HAS_TRANS_ADDRESS, 235 },
+  };
+  printf("%-32s %12s %12s %12s %12s\n", "bytes copied per frame", "recv before", "recv after", "send before", "send after");
+  for (auto& c : cases) {
+    std::vector<uint8_t> frame = makeFrame(c.header, c.payload_len);
+    UncountedRadio radio;
+    SizedPoolPacketManager<4> mgr;
+    BenchDispatcher disp(radio, mgr);
+
+    long recv_before, recv_after, send_before, send_after;
+
+    radio.rx.push_back(frame);
+    bytes_copied = 0; counting = true;
+    legacyRecv(radio, mgr);
+    counting = false; recv_before = bytes_copied;
+
+    radio.rx.push_back(frame);
+    bytes_copied = 0; counting = true;
+    disp.loop();
+    counting = false; recv_after = bytes_copied;
+
+    Packet* pkt = mgr.allocNew();
+    pkt->header = c.header;
+    pkt->payload_len = c.payload_len;
+    bytes_copied = 0; counting = true;
+    legacySend(radio, pkt);
+    counting = false; send_before = bytes_copied;
+
+    radio.sending = false;
+    host_millis += 1000;
+    disp.sendPacket(pkt, 0);
+    bytes_copied = 0; counting = true;
+    disp.loop();
+    counting = false; send_after = bytes_copied;
+
+    printf("%-32s %12ld %12ld %12ld %12ld\n", c.name, recv_before, recv_after, send_before, send_after);
+  }
+  return 0;
+}
@@ -0,0 +1,38 @@
+#include "test.h"
+#include <helpers/StaticPoolPacketManager.h>
+#include <vector>
+
+// the previous allocator: unused Packets kept in a PacketQueue, allocNew() did removeByIdx(0)
+struct QueuePool {
+  std::vector<QueueEntry> entries;
+  PacketQueue unused;
+  QueuePool(ripple::Packet* pool, int n): entries(n), unused(entries.data(), n) {
+    for (int i = 0; i < n; i++) unused.add(&pool[i], 0, 0);
+  }
+  ripple::Packet* allocNew() { return unused.removeByIdx(0); }
+  void free(ripple::Packet* p) { unused.add(p, 0, 0); }
+};
+
+struct FreeListPool : public StaticPoolPacketManager {
+  FreeListPool(ripple::Packet* pool, int n): StaticPoolPacketManager(pool, n, NULL, 0) { }
+};
+
+// allocates 8 Packets, then frees them, with the pool otherwise full (ie. the worst case for removeByIdx(0))
+template<typename P> double allocFreeNanos(P& pool) {
+  ripple::Packet* held[8];
+  return benchNanos([&]() {
+    for (int i = 0; i < 8; i++) held[i] = pool.allocNew();
+    for (int i = 0; i < 8; i++) pool.free(held[i]);
+  }) / 8;
+}
+
+int main() {
+  printf("%8s %16s %16s   (ns per allocNew+free)\n", "pool", "free list", "PacketQueue");
+  for (int n = 16; n <= 4096; n *= 4) {
+    std::vector<ripple::Packet> storage(n);
+    FreeListPool fl(storage.data(), n);
+    QueuePool qp(storage.data(), n);
+    printf("%8d %16.1f %16.1f\n", n, allocFreeNanos(fl), allocFreeNanos(qp));
+  }
+  return 0;
+}
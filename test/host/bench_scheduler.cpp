@@ -0,0 +1,55 @@
+#include "test.h"
+#include <helpers/ScheduledPacketManager.h>
+#include <vector>
+
+struct QueueManager : public StaticPoolPacketManager {
+  QueueManager(ripple::Packet* pool, int n, QueueEntry* q): StaticPoolPacketManager(pool, n, q, n) { }
+};
+struct HeapManager : public ScheduledPacketManager {
+  HeapManager(ripple::Packet* pool, int n, ScheduledEntry* pending, ScheduledEntry* ready): ScheduledPacketManager(pool, pending, ready, n) { }
+};
+
+/*
+ * 'n' announces delayed over the next 60 secs (as after a burst of flood announces), with the Dispatcher
+ * polling getNextOutbound() every millisecond. Reports the average cost of each poll, and of each send.
+*/
+static void run(ripple::PacketManager& mgr, int n, double& poll_ns, double& send_ns) {
+  srand(2);
+  uint32_t now = 0xFFFFF000;
+  for (int i = 0; i < n; i++) {
+    mgr.queueOutbound(mgr.allocNew(), rand() % 4, now + rand() % 60000);
+  }
+  long polls = 0, sends = 0;
+  double poll_total = 0, send_total = 0;
+  while (mgr.getOutboundCount() > 0) {
+    double t0 = nowNanos();
+    ripple::Packet* p = mgr.getNextOutbound(now);
+    double t = nowNanos() - t0;
+    if (p) {
+      send_total += t; sends++;
+      mgr.free(p);
+    } else {
+      poll_total += t; polls++;
+      now++;
+    }
+  }
+  poll_ns = poll_total / polls;
+  send_ns = send_total / sends;
+}
+
+int main() {
+  printf("%8s %22s %22s   (ns per getNextOutbound)\n", "queued", "PacketQueue idle/send", "heaps idle/send");
+  for (int n = 100; n <= 1000; n += 300) {
+    std::vector<ripple::Packet> pool(n);
+    std::vector<QueueEntry> q(n);
+    std::vector<ScheduledEntry> pending(n), ready(n);
+    QueueManager linear(pool.data(), n, q.data());
+    HeapManager heap(pool.data(), n, pending.data(), ready.data());
+
+    double lp, ls, hp, hs;
+    run(linear, n, lp, ls);
+    run(heap, n, hp, hs);
+    printf("%8d %11.1f %10.1f %11.1f %10.1f\n", n, lp, ls, hp, hs);
+  }
+  return 0;
+}
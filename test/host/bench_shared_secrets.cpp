@@ -0,0 +1,50 @@
+#include "test.h"
+#include "sim.h"
+#include <helpers/SharedSecretCache.h>
+
+/*
+ * Time to have the shared secrets for N contacts (eg. at boot): calcSharedSecret() for each, as addContact() did,
+ * versus calcSharedSecrets() of them all (one shared field inversion per batch), and SharedSecretCache::prefetch().
+*/
+using namespace ripple;
+
+#define MAX_CONTACTS  1000
+
+static SimRNG rng;
+static Identity contacts[MAX_CONTACTS];
+static uint8_t secrets[MAX_CONTACTS*PUB_KEY_SIZE];
+
+// best of several runs, as the host is often busy with other work
+template<typename F> double bestMillis(F fn, int runs) {
+  double best = 1e18;
+  for (int i = 0; i < runs; i++) {
+    double start = nowNanos();
+    fn();
+    double t = nowNanos() - start;
+    if (t < best) best = t;
+  }
+  return best / 1e6;
+}
+
+int main() {
+  srand(1);
+  LocalIdentity self(&rng);
+  for (int i = 0; i < MAX_CONTACTS; i++) contacts[i] = LocalIdentity(&rng);
+
+  printf("ms to calculate N shared secrets\n");
+  printf("%-8s %14s %14s %14s\n", "N", "one at a time", "batched", "prefetch(32)");
+  int sizes[] = { 10, 100, 1000 };
+  for (int n : sizes) {
+    int runs = n >= 1000 ? 5 : 9;
+    double single = bestMillis([&]() {
+      for (int i = 0; i < n; i++) self.calcSharedSecret(&secrets[i*PUB_KEY_SIZE], contacts[i]);
+    }, runs);
+    double batched = bestMillis([&]() { self.calcSharedSecrets(secrets, contacts, n); }, runs);
+    double prefetch = bestMillis([&]() {
+      SharedSecretCache<32> cache(self);   // (only the first 32 are kept)
+      cache.prefetch(contacts, n);
+    }, runs);
+    printf("%-8d %14.2f %14.2f %14.2f   (batched -%.1f%%)\n", n, single, batched, prefetch, 100 * (1 - batched / single));
+  }
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include "test.h"
+#include "sim.h"
+#include <Identity.h>
+
+/*
+ * Signature verifications per second, with Identity::verifyBatch() at batch sizes 1-32, versus one Identity::verify()
+ * at a time. Each signature is by a different identity (as in an Announce storm), so the key cache doesn't help.
+ * (Signatures are only combined if built with ED25519_COFACTORED, see Makefile)
+*/
+using namespace ripple;
+
+#define MAX_BATCH  32
+#define MSG_LEN    80   // approx an Announce's signed part
+
+static SimRNG rng;
+static uint8_t sigs[MAX_BATCH][SIGNATURE_SIZE], msgs[MAX_BATCH][MSG_LEN];
+static MsgFragment frags[MAX_BATCH];
+static SignedMsg batch[MAX_BATCH];
+static Identity ids[MAX_BATCH];
+static uint64_t scratch[MAX_BATCH*SIG_BATCH_SCRATCH_SIZE/8];
+static uint8_t random_bytes[MAX_BATCH*16];
+
+// best of several runs, as the host is often busy with other work
+template<typename F> double bestNanos(F fn) {
+  double best = 1e18;
+  for (int i = 0; i < 7; i++) {
+    double t = benchNanos(fn, 50);
+    if (t < best) best = t;
+  }
+  return best;
+}
+
+int main() {
+  srand(1);
+  for (int i = 0; i < MAX_BATCH; i++) {
+    LocalIdentity id(&rng);
+    rng.random(msgs[i], MSG_LEN);
+    id.sign(sigs[i], msgs[i], MSG_LEN);
+    ids[i] = id;
+    frags[i] = { msgs[i], MSG_LEN };
+    batch[i] = { sigs[i], ids[i].pub_key, &frags[i], 1 };
+  }
+  rng.random(random_bytes, sizeof(random_bytes));
+
+  int n = 0;
+  double single = 1e9 / bestNanos([&]() {
+    ids[n].verify(sigs[n], msgs[n], MSG_LEN);
+    n = (n + 1) % MAX_BATCH;
+  });
+  printf("signature verify, per second\n");
+  printf("%-24s %10.0f\n", "verify()", single);
+
+  int valid[MAX_BATCH];
+  int sizes[] = { 1, 2, 4, 8, 16, 32 };
+  for (int size : sizes) {
+    bool ok = true;
+    double rate = size * 1e9 / bestNanos([&]() { ok &= Identity::verifyBatch(batch, size, random_bytes, scratch, valid); });
+    char label[32];
+    snprintf(label, sizeof(label), "verifyBatch() of %d", size);
+    printf("%-24s %10.0f  (x%.2f)%s\n", label, rate, rate / single, ok ? "" : "  FAILED");
+  }
+
+  // one forged signature, so the batch fails, and every signature is then checked on its own
+  sigs[3][5] ^= 1;
+  for (int size : { 8, 32 }) {
+    double rate = size * 1e9 / bestNanos([&]() { Identity::verifyBatch(batch, size, random_bytes, scratch, valid); });
+    char label[32];
+    snprintf(label, sizeof(label), "  %d, with 1 forged", size);
+    printf("%-24s %10.0f  (x%.2f)%s\n", label, rate, rate / single, valid[3] ? "  NOT DETECTED" : "");
+  }
+  return 0;
+}
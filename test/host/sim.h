@@ -0,0 +1,218 @@
+#pragma once
+
+// simulated clocks, RNG and radios, for driving the mesh classes on the host
+#include <Arduino.h>
+#include <Mesh.h>
+#include <vector>
+#include <deque>
+
+struct SimClock : public ripple::MillisecondClock {
+  unsigned long getMillis() override { return host_millis; }
+};
+
+struct SimRTC : public ripple::RTCClock {
+  uint32_t base = 1715770351;
+  uint32_t getCurrentTime() override { return base + host_millis / 1000; }
+  void setCurrentTime(uint32_t time) override { base = time - host_millis / 1000; }
+};
+
+// deterministic, so runs are repeatable (seed with srand())
+struct SimRNG : public ripple::RNG {
+  void random(uint8_t* dest, size_t sz) override {
+    for (size_t i = 0; i < sz; i++) dest[i] = rand() & 0xFF;
+  }
+};
+
+/**
+ * \brief  a radio with a queue of frames to 'receive', and which records every frame sent.
+ *      Sends complete after getEstAirtimeFor() millis of (simulated) time.
+*/
+struct FrameRadio : public ripple::Radio {
+  std::deque<std::vector<uint8_t>> rx;
+  std::vector<std::vector<uint8_t>> sent;
+  unsigned long tx_done = 0;
+  bool sending = false;
+
+  int recvRaw(uint8_t* bytes, int sz) override {
+    if (rx.empty()) return 0;
+    std::vector<uint8_t> f = rx.front();
+    rx.pop_front();
+    int len = (int) f.size() < sz ? (int) f.size() : sz;   // as a real radio, truncates to the buffer
+    memcpy(bytes, f.data(), len);
+    return len;
+  }
+  uint32_t getEstAirtimeFor(int len_bytes) override { return 50 + len_bytes; }
+  void startSendRaw(const uint8_t* bytes, int len) override {
+    sent.push_back(std::vector<uint8_t>(bytes, bytes + len));
+    sending = true;
+    tx_done = host_millis + getEstAirtimeFor(len);
+  }
+  bool isSendComplete() override { return sending && (long)(host_millis - tx_done) >= 0; }
+  void onSendFinished() override { sending = false; }
+};
+
+struct AirRadio;
+
+/**
+ * \brief  a shared radio channel. A frame reaches each neighbour of the sender when its airtime ends, unless it
+ *      overlapped another frame that neighbour could hear, or the neighbour's own transmit (ie. a collision).
+ *      Call tick() once per simulated millisecond.
+*/
+struct Air {
+  struct Link { int to; float snr; int loss_pct; };
+  struct Tx { int from; unsigned long start, end; std::vector<uint8_t> frame; };
+
+  std::vector<AirRadio*> radios;
+  std::vector<std::vector<Link>> links;    // links[i] = who can hear radio i
+  std::vector<Tx> txs;
+  bool collisions = true;
+  long n_delivered = 0, n_collided = 0, n_lost = 0;
+
+  int add(AirRadio* radio);
+  void addLink(int a, int b, float snr = 8.0f, int loss_pct = 0) {
+    links[a].push_back({ b, snr, loss_pct });
+    links[b].push_back({ a, snr, loss_pct });
+  }
+  bool canHear(int rx, int tx) const {
+    for (const Link& l : links[tx]) if (l.to == rx) return true;
+    return false;
+  }
+  bool isBusyAt(int rx) const {   // a neighbour is mid-transmit
+    for (const Tx& t : txs) {
+      if (host_millis >= t.start && host_millis < t.end && canHear(rx, t.from)) return true;
+    }
+    return false;
+  }
+  void transmit(int from, const uint8_t* bytes, int len, uint32_t airtime) {
+    txs.push_back({ from, host_millis, host_millis + airtime, std::vector<uint8_t>(bytes, bytes + len) });
+  }
+  void tick();
+};
+
+struct AirRadio : public ripple::Radio {
+  Air* air;
+  int id;
+  bool cad = true;     // listen-before-talk supported
+  std::deque<std::pair<std::vector<uint8_t>, float>> rx;   // frame, and its SNR
+  float last_snr = 0;
+  unsigned long tx_done = 0;
+  bool sending = false;
+  int n_sent = 0;
+  long airtime = 0;
+
+  AirRadio(Air& a) : air(&a) { id = a.add(this); }
+
+  int recvRaw(uint8_t* bytes, int sz) override {
+    if (rx.empty()) return 0;
+    std::vector<uint8_t> f = rx.front().first;
+    last_snr = rx.front().second;
+    rx.pop_front();
+    int len = (int) f.size() < sz ? (int) f.size() : sz;
+    memcpy(bytes, f.data(), len);
+    return len;
+  }
+  uint32_t getEstAirtimeFor(int len_bytes) override { return 100 + len_bytes; }
+  void startSendRaw(const uint8_t* bytes, int len) override {
+    sending = true;
+    tx_done = host_millis + getEstAirtimeFor(len);
+    n_sent++;
+    airtime += getEstAirtimeFor(len);
+    air->transmit(id, bytes, len, getEstAirtimeFor(len));
+  }
+  bool isSendComplete() override { return sending && (long)(host_millis - tx_done) >= 0; }
+  void onSendFinished() override { sending = false; }
+  bool isChannelActive() override { return cad && air->isBusyAt(id); }
+  float getLastSNR() const override { return last_snr; }
+};
+
+inline int Air::add(AirRadio* radio) {
+  radios.push_back(radio);
+  links.resize(radios.size());
+  return radios.size() - 1;
+}
+
+inline void Air::tick() {
+  for (size_t t = 0; t < txs.size(); ) {
+    const Tx& tx = txs[t];
+    if (tx.end == host_millis) {
+      for (const Link& l : links[tx.from]) {
+        bool collided = false;
+        if (collisions) {
+          for (size_t u = 0; u < txs.size() && !collided; u++) {
+            if (u == t || txs[u].start >= tx.end || txs[u].end <= tx.start) continue;   // no overlap
+            if (txs[u].from == l.to || canHear(l.to, txs[u].from)) collided = true;
+          }
+        }
+        if (collided) {
+          n_collided++;
+        } else if (rand() % 100 < l.loss_pct) {
+          n_lost++;
+        } else {
+          n_delivered++;
+          radios[l.to]->rx.push_back(std::make_pair(tx.frame, l.snr));
+        }
+      }
+    }
+    if (tx.end + 2000 < host_millis) {
+      txs.erase(txs.begin() + t);
+    } else {
+      t++;
+    }
+  }
+}
+
+// advances simulated time by 'millis', running every node's loop() once per milli
+template<typename N> void runFor(Air& air, std::vector<N*>& nodes, unsigned long millis) {
+  for (unsigned long i = 0; i < millis; i++) {
+    air.tick();
+    for (N* n : nodes) n->loop();
+    host_millis++;
+  }
+}
+
+// host stand-in for RTC slow memory (eg. ESP32RetainedMemory). As on the device, contents are garbage at power on
+struct HostRetainedMemory : public ripple::RetainedMemory {
+  std::vector<uint8_t> buf;
+
+  HostRetainedMemory(size_t size) : buf(size) { powerOn(); }
+  void powerOn() { for (uint8_t& b : buf) b = rand() & 0xFF; }
+  uint8_t* getBuffer() override { return buf.data(); }
+  size_t getSize() const override { return buf.size(); }
+};
+
+// an in-memory Stream, eg. for table journals
+struct MemStream : public Stream {
+  std::vector<uint8_t> data;
+  size_t pos = 0;
+
+  size_t write(uint8_t c) override { data.push_back(c); return 1; }
+  size_t write(const uint8_t* buf, size_t len) override { data.insert(data.end(), buf, buf + len); return len; }
+  int available() override { return data.size() - pos; }
+  int read() override { return pos < data.size() ? data[pos++] : -1; }
+  int peek() override { return pos < data.size() ? data[pos] : -1; }
+};
+
+/**
+ * \brief  fills in an Announce, as the tables see it (ie. not signed). 'via' is the transport_id, or NULL if heard
+ *      directly from the destination. 'rand_tag' makes the rand_blob unique.
+*/
+inline void makeTableAnnounce(ripple::Packet* pkt, uint32_t timestamp, uint32_t rand_tag, uint8_t hops, const uint8_t* via = NULL) {
+  pkt->header = PH_TYPE_ANNOUNCE;
+  pkt->hops = hops;
+  pkt->path_cost = hops;
+  memset(pkt->transport_id, 0, DEST_HASH_SIZE);
+  if (via) {
+    pkt->header |= PH_HAS_TRANS_ADDRESS;
+    memcpy(pkt->transport_id, via, DEST_HASH_SIZE);
+  }
+  uint8_t* p = pkt->payload;
+  for (int i = 0; i < PUB_KEY_SIZE; i++) *p++ = (rand_tag + i) & 0xFF;   // pub_key
+  memset(p, 0x4E, NAME_HASH_SIZE); p += NAME_HASH_SIZE;
+  memcpy(p, &timestamp, 4); p += 4;   // rand_blob starts with timestamp
+  memcpy(p, &rand_tag, 4); p += 4;
+  memset(p, 0x51, SIGNATURE_SIZE); p += SIGNATURE_SIZE;
+  memcpy(p, "app", 3); p += 3;
+  pkt->payload_len = p - pkt->payload;
+}
+
+inline const uint8_t* announceRandBlob(const ripple::Packet* pkt) { return &pkt->payload[PUB_KEY_SIZE + NAME_HASH_SIZE]; }
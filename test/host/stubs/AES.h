@@ -0,0 +1,15 @@
+#pragma once
+
+// host stand-in for the rweather/Crypto AES128 class (plain byte-oriented FIPS-197 implementation)
+#include <stdint.h>
+#include <stddef.h>
+
+class AES128 {
+  uint8_t _round_keys[11*16];
+public:
+  size_t keySize() const { return 16; }
+  bool setKey(const uint8_t* key, size_t len);
+  void encryptBlock(uint8_t* output, const uint8_t* input);
+  void decryptBlock(uint8_t* output, const uint8_t* input);
+  void clear();
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+// host (Linux) stand-in for the parts of the Arduino core that the library uses
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <Stream.h>
+
+#define ICACHE_RAM_ATTR
+
+// simulated clock: tests advance this directly, and delay() adds to it
+extern unsigned long host_millis;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+  size_t write(const uint8_t* buf, size_t len) override { return fwrite(buf, 1, len, stdout); }
+  int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,72 @@
+#pragma once
+
+// host stand-in for the ESP32 FS/File API, backed by real files under a root directory
+#include <Stream.h>
+#include <memory>
+#include <string>
+#include <stdio.h>
+
+class File : public Stream {
+  std::shared_ptr<FILE> _fp;
+public:
+  File() { }
+  File(FILE* fp): _fp(fp, fclose) { }
+
+  int available() override {
+    if (!_fp) return 0;
+    long pos = ftell(_fp.get());
+    fseek(_fp.get(), 0, SEEK_END);
+    long end = ftell(_fp.get());
+    fseek(_fp.get(), pos, SEEK_SET);
+    return (int) (end - pos);
+  }
+  int read() override { return _fp ? fgetc(_fp.get()) : -1; }
+  int peek() override {
+    int c = read();
+    if (c >= 0) ungetc(c, _fp.get());
+    return c;
+  }
+  size_t read(uint8_t* buf, size_t len) { return _fp ? fread(buf, 1, len, _fp.get()) : 0; }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t len) override { return _fp ? fwrite(buf, 1, len, _fp.get()) : 0; }
+  void flush() override { if (_fp) fflush(_fp.get()); }
+  bool seek(uint32_t pos) { return _fp && fseek(_fp.get(), pos, SEEK_SET) == 0; }
+  size_t position() const { return _fp ? ftell(_fp.get()) : 0; }
+  size_t size() const {
+    if (!_fp) return 0;
+    long pos = ftell(_fp.get());
+    fseek(_fp.get(), 0, SEEK_END);
+    long end = ftell(_fp.get());
+    fseek(_fp.get(), pos, SEEK_SET);
+    return end;
+  }
+  void close() { _fp.reset(); }
+  operator bool() const { return (bool) _fp; }
+};
+
+namespace fs {
+
+class FS {
+  std::string _root;
+  std::string fullPath(const char* path) const { return _root + path; }
+public:
+  FS(const char* root): _root(root) { }
+
+  File open(const char* path, const char* mode = "r", bool create = false) {
+    std::string m = mode;
+    FILE* fp = fopen(fullPath(path).c_str(), m == "r" ? "rb" : (m == "a" ? "ab+" : "wb+"));
+    return fp ? File(fp) : File();
+  }
+  bool exists(const char* path) {
+    FILE* fp = fopen(fullPath(path).c_str(), "rb");
+    if (fp) fclose(fp);
+    return fp != NULL;
+  }
+  bool remove(const char* path) { return ::remove(fullPath(path).c_str()) == 0; }
+  bool rename(const char* from, const char* to) { return ::rename(fullPath(from).c_str(), fullPath(to).c_str()) == 0; }
+  bool mkdir(const char* path);
+};
+
+}
+
+using fs::FS;
@@ -0,0 +1,21 @@
+#pragma once
+
+// host stand-in for the rweather/Crypto SHA256 class (plain reference implementation)
+#include <stdint.h>
+#include <stddef.h>
+
+class SHA256 {
+  uint32_t _h[8];
+  uint8_t  _buf[64];
+  size_t   _buf_len;
+  uint64_t _total_len;
+  void processBlock(const uint8_t* block);
+public:
+  SHA256() { reset(); }
+  size_t hashSize() const { return 32; }
+  size_t blockSize() const { return 64; }
+  void reset();
+  void update(const void* data, size_t len);
+  void finalize(void* hash, size_t len);
+  void clear() { reset(); }
+};
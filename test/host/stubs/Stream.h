@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+// host stand-in for the Arduino Print/Stream classes: everything funnels into write()
+class Print {
+public:
+  virtual ~Print() { }
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t len) {
+    size_t n = 0;
+    while (len-- > 0 && write(*buf++) == 1) n++;
+    return n;
+  }
+  virtual void flush() { }
+
+  size_t print(const char* s) { return write((const uint8_t *) s, strlen(s)); }
+  size_t print(char c) { return write((uint8_t) c); }
+  size_t print(int v) { return printNum("%d", v); }
+  size_t print(unsigned int v) { return printNum("%u", v); }
+  size_t print(long v) { return printNum("%ld", v); }
+  size_t print(unsigned long v) { return printNum("%lu", v); }
+  size_t print(double v) { char tmp[32]; snprintf(tmp, sizeof(tmp), "%.2f", v); return print(tmp); }
+
+  size_t println() { return print("\r\n"); }
+  template<typename T> size_t println(T v) { return print(v) + println(); }
+
+private:
+  template<typename T> size_t printNum(const char* fmt, T v) { char tmp[24]; snprintf(tmp, sizeof(tmp), fmt, v); return print(tmp); }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() { return -1; }
+
+  size_t readBytes(uint8_t* buf, size_t len) {
+    size_t i = 0;
+    for (; i < len; i++) {
+      int c = read();
+      if (c < 0) break;
+      buf[i] = c;
+    }
+    return i;
+  }
+  size_t readBytes(char* buf, size_t len) { return readBytes((uint8_t *) buf, len); }
+};
@@ -0,0 +1,182 @@
+#include <SHA256.h>
+#include <AES.h>
+#include <string.h>
+
+/* ------------------------------ SHA-256 (FIPS 180-4) -------------------------------- */
+
+static const uint32_t K256[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t ror(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+void SHA256::reset() {
+  static const uint32_t iv[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+  memcpy(_h, iv, sizeof(_h));
+  _buf_len = 0;
+  _total_len = 0;
+}
+
+void SHA256::processBlock(const uint8_t* p) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = ((uint32_t)p[4*i] << 24) | ((uint32_t)p[4*i + 1] << 16) | ((uint32_t)p[4*i + 2] << 8) | p[4*i + 3];
+  }
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = ror(w[i-15], 7) ^ ror(w[i-15], 18) ^ (w[i-15] >> 3);
+    uint32_t s1 = ror(w[i-2], 17) ^ ror(w[i-2], 19) ^ (w[i-2] >> 10);
+    w[i] = w[i-16] + s0 + w[i-7] + s1;
+  }
+  uint32_t a = _h[0], b = _h[1], c = _h[2], d = _h[3], e = _h[4], f = _h[5], g = _h[6], h = _h[7];
+  for (int i = 0; i < 64; i++) {
+    uint32_t t1 = h + (ror(e, 6) ^ ror(e, 11) ^ ror(e, 25)) + ((e & f) ^ (~e & g)) + K256[i] + w[i];
+    uint32_t t2 = (ror(a, 2) ^ ror(a, 13) ^ ror(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+  }
+  _h[0] += a; _h[1] += b; _h[2] += c; _h[3] += d; _h[4] += e; _h[5] += f; _h[6] += g; _h[7] += h;
+}
+
+void SHA256::update(const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t *) data;
+  _total_len += len;
+  while (len > 0) {
+    size_t n = 64 - _buf_len;
+    if (n > len) n = len;
+    memcpy(&_buf[_buf_len], p, n);
+    _buf_len += n; p += n; len -= n;
+    if (_buf_len == 64) {
+      processBlock(_buf);
+      _buf_len = 0;
+    }
+  }
+}
+
+void SHA256::finalize(void* hash, size_t len) {
+  uint64_t bits = _total_len * 8;
+  uint8_t pad = 0x80;
+  update(&pad, 1);
+  pad = 0;
+  while (_buf_len != 56) update(&pad, 1);
+  uint8_t be_len[8];
+  for (int i = 0; i < 8; i++) be_len[i] = bits >> (56 - 8*i);
+  update(be_len, 8);
+
+  uint8_t out[32];
+  for (int i = 0; i < 8; i++) {
+    out[4*i] = _h[i] >> 24; out[4*i + 1] = _h[i] >> 16; out[4*i + 2] = _h[i] >> 8; out[4*i + 3] = _h[i];
+  }
+  memcpy(hash, out, len < 32 ? len : 32);
+}
+
+/* ------------------------------ AES-128 (FIPS 197) -------------------------------- */
+
+static uint8_t sbox[256], inv_sbox[256];
+
+static inline uint8_t xtime(uint8_t x) { return (x << 1) ^ ((x & 0x80) ? 0x1B : 0); }
+
+static uint8_t gmul(uint8_t a, uint8_t b) {
+  uint8_t r = 0;
+  while (b) {
+    if (b & 1) r ^= a;
+    a = xtime(a);
+    b >>= 1;
+  }
+  return r;
+}
+
+// derives the S-box from its definition (multiplicative inverse, then the affine transform)
+static void initSBox() {
+  if (sbox[0] == 0x63) return;
+  for (int x = 0; x < 256; x++) {
+    uint8_t inv = 0;
+    if (x) {
+      for (int y = 1; y < 256; y++) if (gmul(x, y) == 1) { inv = y; break; }
+    }
+    uint8_t s = inv;
+    for (int i = 1; i <= 4; i++) s ^= (uint8_t) ((inv << i) | (inv >> (8 - i)));
+    s ^= 0x63;
+    sbox[x] = s;
+    inv_sbox[s] = x;
+  }
+}
+
+bool AES128::setKey(const uint8_t* key, size_t len) {
+  if (len != 16) return false;
+  initSBox();
+  memcpy(_round_keys, key, 16);
+  uint8_t rcon = 1;
+  for (int i = 16; i < 176; i += 4) {
+    uint8_t t[4];
+    memcpy(t, &_round_keys[i - 4], 4);
+    if (i % 16 == 0) {
+      uint8_t t0 = t[0];
+      t[0] = sbox[t[1]] ^ rcon; t[1] = sbox[t[2]]; t[2] = sbox[t[3]]; t[3] = sbox[t0];
+      rcon = xtime(rcon);
+    }
+    for (int j = 0; j < 4; j++) _round_keys[i + j] = _round_keys[i - 16 + j] ^ t[j];
+  }
+  return true;
+}
+
+static void addRoundKey(uint8_t* s, const uint8_t* k) {
+  for (int i = 0; i < 16; i++) s[i] ^= k[i];
+}
+
+void AES128::encryptBlock(uint8_t* output, const uint8_t* input) {
+  uint8_t s[16], t[16];
+  memcpy(s, input, 16);
+  addRoundKey(s, _round_keys);
+  for (int round = 1; round <= 10; round++) {
+    for (int c = 0; c < 4; c++) {    // SubBytes + ShiftRows
+      for (int r = 0; r < 4; r++) t[4*c + r] = sbox[s[4*((c + r) % 4) + r]];
+    }
+    if (round < 10) {   // MixColumns
+      for (int c = 0; c < 4; c++) {
+        uint8_t* col = &t[4*c];
+        uint8_t a0 = col[0], a1 = col[1], a2 = col[2], a3 = col[3];
+        col[0] = xtime(a0) ^ (xtime(a1) ^ a1) ^ a2 ^ a3;
+        col[1] = a0 ^ xtime(a1) ^ (xtime(a2) ^ a2) ^ a3;
+        col[2] = a0 ^ a1 ^ xtime(a2) ^ (xtime(a3) ^ a3);
+        col[3] = (xtime(a0) ^ a0) ^ a1 ^ a2 ^ xtime(a3);
+      }
+    }
+    memcpy(s, t, 16);
+    addRoundKey(s, &_round_keys[16*round]);
+  }
+  memcpy(output, s, 16);
+}
+
+void AES128::decryptBlock(uint8_t* output, const uint8_t* input) {
+  uint8_t s[16], t[16];
+  memcpy(s, input, 16);
+  addRoundKey(s, &_round_keys[160]);
+  for (int round = 9; round >= 0; round--) {
+    for (int c = 0; c < 4; c++) {    // InvShiftRows + InvSubBytes
+      for (int r = 0; r < 4; r++) t[4*((c + r) % 4) + r] = inv_sbox[s[4*c + r]];
+    }
+    addRoundKey(t, &_round_keys[16*round]);
+    if (round > 0) {   // InvMixColumns
+      for (int c = 0; c < 4; c++) {
+        uint8_t* col = &t[4*c];
+        uint8_t a0 = col[0], a1 = col[1], a2 = col[2], a3 = col[3];
+        col[0] = gmul(a0, 14) ^ gmul(a1, 11) ^ gmul(a2, 13) ^ gmul(a3, 9);
+        col[1] = gmul(a0, 9) ^ gmul(a1, 14) ^ gmul(a2, 11) ^ gmul(a3, 13);
+        col[2] = gmul(a0, 13) ^ gmul(a1, 9) ^ gmul(a2, 14) ^ gmul(a3, 11);
+        col[3] = gmul(a0, 11) ^ gmul(a1, 13) ^ gmul(a2, 9) ^ gmul(a3, 14);
+      }
+    }
+    memcpy(s, t, 16);
+  }
+  memcpy(output, s, 16);
+}
+
+void AES128::clear() {
+  memset(_round_keys, 0, sizeof(_round_keys));
+}
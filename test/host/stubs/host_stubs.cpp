@@ -0,0 +1,27 @@
+#include <Arduino.h>
+#include <stdarg.h>
+
+unsigned long host_millis = 0;
+
+unsigned long millis() { return host_millis; }
+unsigned long micros() { return host_millis * 1000; }
+void delay(unsigned long ms) { host_millis += ms; }
+
+long random(long max) { return max > 0 ? rand() % max : 0; }
+long random(long min, long max) { return max > min ? min + rand() % (max - min) : min; }
+void randomSeed(unsigned long seed) { srand(seed); }
+
+HardwareSerial Serial;
+
+int HardwareSerial::printf(const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int n = vprintf(fmt, args);
+  va_end(args);
+  return n;
+}
+
+#include <FS.h>
+#include <sys/stat.h>
+
+bool fs::FS::mkdir(const char* path) { return ::mkdir(fullPath(path).c_str(), 0755) == 0; }
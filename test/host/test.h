@@ -0,0 +1,42 @@
+#pragma once
+
+// minimal test/benchmark helpers for the host harness
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); test_failures++; } \
+  } while (0)
+
+#define CHECK_EQ(a, b) do { \
+    long long _a = (long long) (a), _b = (long long) (b); \
+    if (_a != _b) { printf("%s:%d: CHECK failed: %s == %s (%lld vs %lld)\n", __FILE__, __LINE__, #a, #b, _a, _b); test_failures++; } \
+  } while (0)
+
+// for main(): prints the outcome, and returns the process exit code
+static inline int testResult(const char* name) {
+  printf("%s: %s\n", name, test_failures ? "FAILED" : "passed");
+  return test_failures ? 1 : 0;
+}
+
+// wall clock in nanoseconds, for benchmarks
+static inline double nowNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// runs 'fn' repeatedly for about 'min_ms' of wall time, returns nanoseconds per call
+template<typename F> double benchNanos(F fn, double min_ms = 200) {
+  long iters = 0;
+  double start = nowNanos(), elapsed;
+  do {
+    for (int i = 0; i < 64; i++) fn();
+    iters += 64;
+    elapsed = nowNanos() - start;
+  } while (elapsed < min_ms * 1e6);
+  return elapsed / iters;
+}
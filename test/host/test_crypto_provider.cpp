@@ -0,0 +1,182 @@
+#include "test.h"
+#include <string.h>
+#include <CryptoProvider.h>
+
+/*
+ * Known answers for the CryptoSHA256 / CryptoAES128 backend this is built with (the x86 one by default, the software
+ * one with DEFS=-DCRYPTO_PROVIDER=0), and a cross-check against the plain SHA256 / AES128 reference classes, over
+ * random lengths, split updates, key sizes and block counts.
+*/
+using namespace ripple;
+
+static void fromHex(uint8_t* dest, const char* hex) {
+  for (size_t i = 0; i < strlen(hex) / 2; i++) sscanf(&hex[2*i], "%2hhx", &dest[i]);
+}
+
+static bool equalsHex(const uint8_t* data, const char* hex) {
+  uint8_t expected[64];
+  fromHex(expected, hex);
+  return memcmp(data, expected, strlen(hex) / 2) == 0;
+}
+
+// FIPS 180-4 examples (via NIST CSRC), and the 1,000,000 x 'a' vector
+static void testSHA256() {
+  uint8_t hash[32];
+  CryptoSHA256 sha;
+  sha.update("abc", 3);
+  sha.finalize(hash, 32);
+  CHECK(equalsHex(hash, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+
+  sha.reset();
+  sha.finalize(hash, 32);
+  CHECK(equalsHex(hash, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+
+  const char* msg = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  sha.reset();
+  sha.update(msg, strlen(msg));
+  sha.finalize(hash, 32);
+  CHECK(equalsHex(hash, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+
+  uint8_t a[997];
+  memset(a, 'a', sizeof(a));
+  sha.reset();
+  size_t left = 1000000;
+  for (int step = 1; left > 0; step++) {   // in odd sized pieces, so the block buffering is exercised
+    size_t n = (step * 37) % sizeof(a) + 1;
+    if (n > left) n = left;
+    sha.update(a, n);
+    left -= n;
+  }
+  sha.finalize(hash, 32);
+  CHECK(equalsHex(hash, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"));
+
+  sha.reset();
+  sha.update("abc", 3);
+  uint8_t truncated[8];
+  sha.finalize(truncated, sizeof(truncated));
+  CHECK(equalsHex(truncated, "ba7816bf8f01cfea"));
+}
+
+// RFC 4231, test cases 1, 2 and 6 (key longer than a block)
+static void testHMAC() {
+  uint8_t hash[32], key[131];
+  CryptoSHA256 sha;
+  memset(key, 0x0b, 20);
+  sha.resetHMAC(key, 20);
+  sha.update("Hi There", 8);
+  sha.finalizeHMAC(key, 20, hash, 32);
+  CHECK(equalsHex(hash, "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7"));
+
+  const char* msg = "what do ya want for nothing?";
+  sha.resetHMAC("Jefe", 4);
+  sha.update(msg, strlen(msg));
+  sha.finalizeHMAC("Jefe", 4, hash, 32);
+  CHECK(equalsHex(hash, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"));
+
+  memset(key, 0xaa, sizeof(key));
+  msg = "Test Using Larger Than Block-Size Key - Hash Key First";
+  sha.resetHMAC(key, sizeof(key));
+  sha.update(msg, strlen(msg));
+  sha.finalizeHMAC(key, sizeof(key), hash, 32);
+  CHECK(equalsHex(hash, "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54"));
+}
+
+// FIPS 197, appendix B and C.1
+static void testAES128() {
+  uint8_t key[16], plain[16], cipher[16], decrypted[16];
+  CryptoAES128 aes;
+  fromHex(key, "000102030405060708090a0b0c0d0e0f");
+  fromHex(plain, "00112233445566778899aabbccddeeff");
+  CHECK(aes.setKey(key, 16));
+  aes.encryptBlock(cipher, plain);
+  CHECK(equalsHex(cipher, "69c4e0d86a7b0430d8cdb78070b4c55a"));
+  aes.decryptBlock(decrypted, cipher);
+  CHECK(memcmp(decrypted, plain, 16) == 0);
+
+  fromHex(key, "2b7e151628aed2a6abf7158809cf4f3c");
+  fromHex(plain, "3243f6a8885a308d313198a2e0370734");
+  CHECK(aes.setKey(key, 16));
+  aes.encryptBlock(cipher, plain);
+  CHECK(equalsHex(cipher, "3925841d02dc09fbdc118597196a0b32"));
+
+  CHECK(!aes.setKey(key, 32));   // only AES-128
+}
+
+// HMAC-SHA256 by the RFC 2104 definition, on the reference SHA256 class
+static void referenceHMAC(uint8_t* out, const uint8_t* key, size_t key_len, const uint8_t* msg, size_t len) {
+  uint8_t block[64], inner[32];
+  SHA256 sha;
+  memset(block, 0, sizeof(block));
+  if (key_len > 64) {
+    sha.update(key, key_len);
+    sha.finalize(block, 32);
+    sha.reset();
+  } else {
+    memcpy(block, key, key_len);
+  }
+  for (int i = 0; i < 64; i++) block[i] ^= 0x36;
+  sha.update(block, 64);
+  sha.update(msg, len);
+  sha.finalize(inner, 32);
+  for (int i = 0; i < 64; i++) block[i] ^= 0x36 ^ 0x5c;
+  sha.reset();
+  sha.update(block, 64);
+  sha.update(inner, 32);
+  sha.finalize(out, 32);
+}
+
+static void testAgainstReference() {
+  srand(1);
+  int bad_hash = 0, bad_hmac = 0, bad_aes = 0;
+  for (int t = 0; t < 3000; t++) {
+    uint8_t msg[300], key[100], got[32], expected[32];
+    size_t len = rand() % sizeof(msg), key_len = rand() % sizeof(key), split = len ? rand() % len : 0;
+    for (size_t i = 0; i < len; i++) msg[i] = rand();
+    for (size_t i = 0; i < key_len; i++) key[i] = rand();
+
+    CryptoSHA256 sha;
+    sha.update(msg, split);
+    sha.update(&msg[split], len - split);
+    sha.finalize(got, 32);
+    SHA256 ref;
+    ref.update(msg, len);
+    ref.finalize(expected, 32);
+    if (memcmp(got, expected, 32) != 0) bad_hash++;
+
+    sha.resetHMAC(key, key_len);
+    sha.update(msg, split);
+    sha.update(&msg[split], len - split);
+    sha.finalizeHMAC(key, key_len, got, 16);
+    referenceHMAC(expected, key, key_len, msg, len);
+    if (memcmp(got, expected, 16) != 0) bad_hmac++;
+  }
+  for (int t = 0; t < 500; t++) {
+    uint8_t key[16], plain[16*13], cipher[16*13], decrypted[16*13], expected[16];
+    for (uint8_t& b : key) b = rand();
+    for (uint8_t& b : plain) b = rand();
+    int num_blocks = t % 14;
+    CryptoAES128 aes;
+    aes.setKey(key, 16);
+    aes.encryptBlocks(cipher, plain, num_blocks);
+    aes.decryptBlocks(decrypted, cipher, num_blocks);
+    AES128 ref;
+    ref.setKey(key, 16);
+    for (int b = 0; b < num_blocks; b++) {
+      ref.encryptBlock(expected, &plain[16*b]);
+      if (memcmp(expected, &cipher[16*b], 16) != 0) bad_aes++;
+    }
+    if (memcmp(decrypted, plain, 16*num_blocks) != 0) bad_aes++;
+  }
+  CHECK_EQ(bad_hash, 0);
+  CHECK_EQ(bad_hmac, 0);
+  CHECK_EQ(bad_aes, 0);
+}
+
+int main() {
+  printf("provider: %s\n", getCryptoProviderName());
+  testSHA256();
+  testHMAC();
+  testAES128();
+  testAgainstReference();
+  return testResult("test_crypto_provider");
+}
@@ -0,0 +1,63 @@
+#include "test.h"
+#include "sim.h"
+#include <MeshTransportFull.h>
+#include <helpers/SimpleMeshTables.h>
+#include <helpers/ScheduledPacketManager.h>
+
+using namespace ripple;
+
+static SimClock ms;
+static SimRTC rtc;
+static SimRNG rng;
+
+struct Repeater : public MeshTransportFull {
+  Repeater(Radio& radio) : MeshTransportFull(radio, ms, rng, rtc, *new SizedScheduledPacketManager<64>(), *new SimpleMeshTables(rtc)) {
+    for (int i = 0; i < NUM_AIRTIME_CLASSES; i++) setAirtimeBudget(i, 0.5, 3000);
+  }
+};
+
+struct Result { long delivered, collided; uint32_t deferred; };
+
+// 12 repeaters all in range of each other, each flooding an announce within the same 3 secs
+static Result run(bool cad) {
+  srand(7);
+  host_millis = 1000;
+  Air air;
+  std::vector<AirRadio*> radios;
+  std::vector<Repeater*> nodes;
+  for (int i = 0; i < 12; i++) {
+    radios.push_back(new AirRadio(air));
+    radios[i]->cad = cad;
+  }
+  for (int i = 0; i < 12; i++) {
+    for (int j = i + 1; j < 12; j++) air.addLink(i, j);
+  }
+  for (int i = 0; i < 12; i++) {
+    nodes.push_back(new Repeater(*radios[i]));
+    nodes[i]->self_id = LocalIdentity(&rng);
+    nodes[i]->begin();
+  }
+  for (Repeater* n : nodes) {
+    n->sendPacket(n->createAnnounce("repeater.request", n->self_id), 2, rand() % 3000);
+  }
+  runFor(air, nodes, 120000);
+
+  Result r = { air.n_delivered, air.n_collided, 0 };
+  for (Repeater* n : nodes) r.deferred += n->getNumTxDeferred();
+  return r;
+}
+
+int main() {
+  Result none = run(false);
+  Result csma = run(true);
+  printf("no listen-before-talk: delivered=%ld collided=%ld\n", none.delivered, none.collided);
+  printf("CAD + backoff:         delivered=%ld collided=%ld deferred=%u\n", csma.delivered, csma.collided, csma.deferred);
+
+  double none_ratio = (double) none.collided / (none.delivered + none.collided);
+  double csma_ratio = (double) csma.collided / (csma.delivered + csma.collided);
+  CHECK(csma.deferred > 0);
+  CHECK(csma_ratio < none_ratio / 2);
+  CHECK(csma.delivered > 2 * none.delivered);
+
+  return testResult("test_csma_sim");
+}
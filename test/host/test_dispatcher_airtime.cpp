@@ -0,0 +1,228 @@
+#include "test.h"
+#include "sim.h"
+#include <helpers/StaticPoolPacketManager.h>
+
+/*
+ * Airtime accounting of the Dispatcher (class budgets, and the regulatory duty cycle), and where listen-before-talk
+ * fits among those checks.
+*/
+using namespace ripple;
+
+static SimClock ms;
+
+// a radio whose sends never signal completion (eg. a missed interrupt), so they time out
+struct StuckRadio : public FrameRadio {
+  bool isSendComplete() override { return false; }
+};
+
+// a radio which counts listen-before-talk probes
+struct ProbedRadio : public FrameRadio {
+  bool busy = false;
+  int n_probes = 0;
+  bool isChannelActive() override { n_probes++; return busy; }
+};
+
+struct TestDispatcher : public Dispatcher {
+  int n_sent = 0;
+  int airtime_class = -1;   // if set, all packets are charged to this class
+  TestDispatcher(Radio& radio, PacketManager& mgr): Dispatcher(radio, ms, mgr) { }
+
+  uint8_t getAirtimeClass(const Packet* packet) const override {
+    return airtime_class >= 0 ? airtime_class : Dispatcher::getAirtimeClass(packet);
+  }
+
+  DispatcherAction onRecvPacket(Packet* pkt) override { return ACTION_RELEASE; }
+  void onPacketSent(Packet* packet) override { n_sent++; Dispatcher::onPacketSent(packet); }
+};
+
+static Packet* newDataPacket(Dispatcher& disp) {
+  Packet* out = disp.obtainNewPacket();
+  out->header = PH_TYPE_DATA;
+  out->hops = 0;
+  memset(out->destination_hash, 0x22, DEST_HASH_SIZE);
+  out->payload_len = 100;
+  memset(out->payload, 0x33, out->payload_len);
+  return out;
+}
+
+// a send which times out may have been on air all along, so is charged like a completed one
+static void testTimedOutSendIsCharged() {
+  StuckRadio radio;
+  SizedPoolPacketManager<4> mgr;
+  TestDispatcher disp(radio, mgr);
+  disp.begin();
+  host_millis = 1000;
+  disp.setDutyCycle(1);   // 36 secs per hour
+  uint32_t duty_before = disp.getDutyCycleRemaining();
+  float tokens_before = disp.getAirtimeBudgetTokens(AIRTIME_CLASS_DATA);
+
+  disp.sendPacket(newDataPacket(disp), 0);
+  disp.loop();
+  CHECK_EQ(radio.sent.size(), 1);
+  if (radio.sent.size() != 1) return;
+
+  uint32_t max_airtime = radio.getEstAirtimeFor(radio.sent[0].size())*3/2;
+  for (uint32_t i = 0; i <= max_airtime; i++) {   // until timed out
+    host_millis++;
+    disp.loop();
+  }
+  CHECK_EQ(mgr.getFreeCount(), 4);   // released
+  CHECK_EQ(disp.n_sent, 0);
+
+  long elapsed = max_airtime + 1;
+  CHECK_EQ(disp.getTotalAirTime(), elapsed);
+  CHECK_EQ(duty_before - disp.getDutyCycleRemaining(), elapsed);
+  // (refilled at 1/6th of a milli, per milli elapsed)
+  float tokens = disp.getAirtimeBudgetTokens(AIRTIME_CLASS_DATA);
+  CHECK(tokens <= tokens_before - elapsed + elapsed / 6.0f + 1);
+}
+
+// the channel is only probed (which interrupts receive) for a packet which is otherwise ready to go on air
+static void testProbeOnlyBeforeSend() {
+  ProbedRadio radio;
+  SizedPoolPacketManager<4> mgr;
+  TestDispatcher disp(radio, mgr);
+  disp.begin();
+  host_millis = 1000;
+
+  disp.setDutyCycle(0.001f);   // 36 millis per hour, less than any packet
+  disp.sendPacket(newDataPacket(disp), 2);
+  disp.loop();
+  CHECK_EQ(disp.getNumTxDutyDropped(), 1);
+  CHECK_EQ(radio.n_probes, 0);
+  CHECK_EQ(disp.getNumTxForced(), 0);
+
+  // a send uses up the class budget, so the next is held back by it, however long the channel is busy
+  disp.setDutyCycle(0);
+  disp.setAirtimeBudget(AIRTIME_CLASS_DATA, 1000.0, 10);
+  disp.sendPacket(newDataPacket(disp), 0);
+  for (int i = 0; i < 1000 && disp.n_sent == 0; i++) {
+    host_millis++;
+    disp.loop();
+  }
+  CHECK_EQ(disp.n_sent, 1);
+  CHECK_EQ(radio.n_probes, 1);
+
+  radio.busy = true;
+  disp.sendPacket(newDataPacket(disp), 0);
+  for (int i = 0; i < CSMA_MAX_DEFER_MILLIS*2; i++) {
+    host_millis++;
+    disp.loop();
+  }
+  CHECK_EQ(radio.sent.size(), 1);
+  CHECK_EQ(radio.n_probes, 1);
+  CHECK_EQ(disp.getNumTxForced(), 0);
+
+  // budget available, but channel busy: deferred, and still queued
+  disp.setAirtimeBudget(AIRTIME_CLASS_DATA, 5.0, DEFAULT_AIRTIME_BURST_MILLIS);
+  for (int i = 0; i < 1000*1000 && radio.n_probes == 1; i++) {   // (until its re-scheduled time)
+    host_millis++;
+    disp.loop();
+  }
+  CHECK_EQ(radio.n_probes, 2);
+  CHECK_EQ(disp.getNumTxDeferred(), 1);
+  CHECK_EQ(mgr.getOutboundCount(), 1);
+
+  radio.busy = false;
+  for (int i = 0; i < 1000 && radio.sent.size() < 2; i++) {
+    host_millis++;
+    disp.loop();
+  }
+  CHECK_EQ(radio.sent.size(), 2);
+  CHECK_EQ(disp.getNumTxForced(), 0);
+}
+
+// a packet deferred by a busy channel, then held back by its budget, must not leave the next packet a shortened (or
+//  no) backoff, ie. budget -> busy -> budget -> busy
+static void testBudgetResetsBackoff() {
+  ProbedRadio radio;
+  SizedPoolPacketManager<4> mgr;
+  TestDispatcher disp(radio, mgr);
+  disp.begin();
+  host_millis = 1000;
+  disp.setDutyCycle(0);
+
+  // use up the data budget
+  disp.airtime_class = AIRTIME_CLASS_DATA;
+  disp.setAirtimeBudget(AIRTIME_CLASS_DATA, 1000.0, 10);
+  disp.sendPacket(newDataPacket(disp), 0);
+  for (int i = 0; i < 1000 && disp.n_sent == 0; i++) {
+    host_millis++;
+    disp.loop();
+  }
+  CHECK_EQ(disp.n_sent, 1);
+
+  // within budget (of another class), but channel busy
+  radio.busy = true;
+  disp.airtime_class = AIRTIME_CLASS_REPLY;
+  disp.sendPacket(newDataPacket(disp), 0);
+  disp.loop();
+  CHECK_EQ(disp.getNumTxDeferred(), 1);
+
+  // now over budget, so re-scheduled (long after CSMA_MAX_DEFER_MILLIS)
+  disp.airtime_class = AIRTIME_CLASS_DATA;
+  int probes = radio.n_probes;
+  for (int i = 0; i < 1000 && mgr.getOutboundCount() > 0 && (long)(mgr.getNextOutboundTime() - host_millis) < 60*1000; i++) {
+    host_millis++;
+    disp.loop();
+  }
+  CHECK_EQ(radio.n_probes, probes);
+
+  // a different packet, much later, finds the channel busy: is deferred, not forced
+  host_millis += CSMA_MAX_DEFER_MILLIS + 1;
+  disp.airtime_class = AIRTIME_CLASS_REPLY;
+  disp.sendPacket(newDataPacket(disp), 0);
+  disp.loop();
+  CHECK_EQ(radio.n_probes, probes + 1);
+  CHECK_EQ(disp.getNumTxDeferred(), 2);
+  CHECK_EQ(disp.getNumTxForced(), 0);
+  CHECK_EQ(radio.sent.size(), 1);
+}
+
+// over the duty cycle limit, only Announces are dropped. Replies (however low their priority number) just wait
+static void testReplySurvivesDutyCycle() {
+  FrameRadio radio;
+  SizedPoolPacketManager<4> mgr;
+  TestDispatcher disp(radio, mgr);
+  disp.begin();
+  host_millis = 1000;
+  disp.setDutyCycle(250 * 100.0f / (DUTY_CYCLE_WINDOW_SLOTS * DUTY_CYCLE_SLOT_MILLIS));   // 250 millis per window
+
+  disp.sendPacket(newDataPacket(disp), 0);
+  for (int i = 0; i < 1000 && disp.n_sent == 0; i++) {
+    host_millis++;
+    disp.loop();
+  }
+  CHECK_EQ(disp.n_sent, 1);
+
+  Packet* reply = newDataPacket(disp);
+  reply->header = PH_TYPE_REPLY;
+  disp.sendPacket(reply, 3);   // as a forwarded reply
+  Packet* announce = newDataPacket(disp);
+  announce->header = PH_TYPE_ANNOUNCE;
+  disp.sendPacket(announce, 3);
+  host_millis++;
+  disp.loop();
+  disp.loop();
+  CHECK_EQ(disp.getNumTxDutyDropped(), 1);   // the Announce
+  CHECK_EQ(disp.getNumTxDutyDeferred(), 1);
+  CHECK_EQ(mgr.getOutboundCount(), 1);
+
+  // sent once the first send has left the window
+  host_millis += (DUTY_CYCLE_WINDOW_SLOTS + 2) * DUTY_CYCLE_SLOT_MILLIS;
+  for (int i = 0; i < 1000 && disp.n_sent == 1; i++) {
+    host_millis++;
+    disp.loop();
+  }
+  CHECK_EQ(disp.n_sent, 2);
+  CHECK_EQ(radio.sent.size(), 2);
+  if (radio.sent.size() == 2) CHECK_EQ(radio.sent[1][0], PH_TYPE_REPLY);
+}
+
+int main() {
+  testTimedOutSendIsCharged();
+  testProbeOnlyBeforeSend();
+  testBudgetResetsBackoff();
+  testReplySurvivesDutyCycle();
+  return testResult("test_dispatcher_airtime");
+}
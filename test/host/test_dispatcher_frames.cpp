@@ -0,0 +1,147 @@
+#include "test.h"
+#include "sim.h"
+#include <helpers/StaticPoolPacketManager.h>
+
+using namespace ripple;
+
+static SimClock ms;
+
+struct TestDispatcher : public Dispatcher {
+  std::vector<Packet*> received;
+  TestDispatcher(Radio& radio, PacketManager& mgr): Dispatcher(radio, ms, mgr) { setDutyCycle(0); }
+
+  DispatcherAction onRecvPacket(Packet* pkt) override {
+    received.push_back(pkt);
+    return ACTION_MANUAL_HOLD;
+  }
+  void release(Packet* pkt) { releasePacket(pkt); }
+};
+
+static std::vector<uint8_t> makeFrame(uint8_t header, int payload_len) {
+  std::vector<uint8_t> f;
+  f.push_back(header);
+  f.push_back(3);   // hops
+  if (header & PH_HAS_TRANS_ADDRESS) for (int i = 0; i < DEST_HASH_SIZE; i++) f.push_back(0xA0 + i);
+  if ((header & PH_TYPE_MASK) != PH_TYPE_ANNOUNCE) for (int i = 0; i < DEST_HASH_SIZE; i++) f.push_back(0xD0 + i);
+  for (int i = 0; i < payload_len; i++) f.push_back(i & 0xFF);
+  return f;
+}
+
+int main() {
+  FrameRadio radio;
+  SizedPoolPacketManager<4> mgr;
+  TestDispatcher disp(radio, mgr);
+  disp.begin();
+  host_millis = 1000;
+
+  // frame with the shortest header, and the largest legal payload
+  radio.rx.push_back(makeFrame(PH_TYPE_ANNOUNCE, MAX_PACKET_PAYLOAD));
+  disp.loop();
+  CHECK_EQ(disp.received.size(), 1);
+  if (disp.received.size() == 1) {
+    Packet* p = disp.received[0];
+    CHECK_EQ(p->payload_len, MAX_PACKET_PAYLOAD);
+    CHECK_EQ(p->hops, 3);
+    CHECK(p->payload == &p->frame[2]);   // in place, not shifted into position
+    bool ok = true;
+    for (int i = 0; i < MAX_PACKET_PAYLOAD; i++) ok = ok && p->payload[i] == (i & 0xFF);
+    CHECK(ok);
+    disp.release(p);
+  }
+
+  // the full header, and largest payload
+  radio.rx.push_back(makeFrame(PH_TYPE_DATA | PH_HAS_TRANS_ADDRESS, MAX_PACKET_PAYLOAD));
+  disp.loop();
+  CHECK_EQ(disp.received.size(), 2);
+  if (disp.received.size() == 2) {
+    Packet* p = disp.received[1];
+    CHECK_EQ(p->payload_len, MAX_PACKET_PAYLOAD);
+    CHECK_EQ(p->transport_id[0], 0xA0);
+    CHECK_EQ(p->destination_hash[DEST_HASH_SIZE - 1], 0xD7);
+    CHECK_EQ(p->payload[MAX_PACKET_PAYLOAD - 1], (MAX_PACKET_PAYLOAD - 1) & 0xFF);
+    disp.release(p);
+  }
+
+  // short header, but payload longer than MAX_PACKET_PAYLOAD: must be dropped, without writing past the Packet
+  Packet* pool[4];
+  for (int i = 0; i < 4; i++) {
+    pool[i] = mgr.allocNew();
+    pool[i]->header = pool[i]->hops = 0x5A;
+    pool[i]->payload_len = 7;
+  }
+  for (int i = 0; i < 4; i++) mgr.free(pool[i]);
+  radio.rx.push_back(makeFrame(PH_TYPE_ANNOUNCE, MAX_PACKET_PAYLOAD + 16));
+  disp.loop();
+  CHECK_EQ(disp.received.size(), 2);
+  CHECK_EQ(mgr.getFreeCount(), 4);
+  for (int i = 0; i < 4; i++) {
+    CHECK(pool[i]->payload == &pool[i]->frame[MAX_WIRE_PREFIX]);
+    CHECK_EQ(pool[i]->payload_len, 7);
+    if (i != 3) CHECK_EQ(pool[i]->hops, 0x5A);   // [3] was used for the receive (free list is LIFO)
+  }
+
+  // frames shorter than their header are dropped too
+  radio.rx.push_back(std::vector<uint8_t>{ PH_TYPE_DATA, 1, 0xD0 });
+  disp.loop();
+  CHECK_EQ(disp.received.size(), 2);
+  CHECK_EQ(mgr.getFreeCount(), 4);
+
+  // send: frame header is written in front of the payload, in place
+  Packet* out = disp.obtainNewPacket();
+  out->header = PH_TYPE_DATA | PH_HAS_TRANS_ADDRESS;
+  out->hops = 1;
+  memset(out->transport_id, 0x11, DEST_HASH_SIZE);
+  memset(out->destination_hash, 0x22, DEST_HASH_SIZE);
+  out->payload_len = MAX_PACKET_PAYLOAD;
+  for (int i = 0; i < MAX_PACKET_PAYLOAD; i++) out->payload[i] = 0xFF - (i & 0x7F);
+  disp.sendPacket(out, 0);
+  disp.loop();
+  CHECK_EQ(radio.sent.size(), 1);
+  if (radio.sent.size() == 1) {
+    const std::vector<uint8_t>& f = radio.sent[0];
+    CHECK_EQ(f.size(), MAX_WIRE_PREFIX + MAX_PACKET_PAYLOAD);
+    CHECK_EQ(f[0], PH_TYPE_DATA | PH_HAS_TRANS_ADDRESS);
+    CHECK_EQ(f[1], 1);
+    CHECK_EQ(f[2], 0x11);
+    CHECK_EQ(f[2 + DEST_HASH_SIZE], 0x22);
+    CHECK_EQ(f[MAX_WIRE_PREFIX], 0xFF);
+    CHECK_EQ(f.back(), 0xFF - ((MAX_PACKET_PAYLOAD - 1) & 0x7F));
+
+    // and the sent frame parses back to the same packet
+    radio.rx.push_back(f);
+    host_millis += 1000;
+    disp.loop();
+    CHECK_EQ(disp.received.size(), 3);
+    if (disp.received.size() == 3) {
+      CHECK_EQ(disp.received[2]->payload_len, MAX_PACKET_PAYLOAD);
+      CHECK(memcmp(disp.received[2]->payload, &f[MAX_WIRE_PREFIX], MAX_PACKET_PAYLOAD) == 0);
+      disp.release(disp.received[2]);
+    }
+  }
+
+  // a received Announce forwarded with a longer frame header: payload is moved back for the header to fit in front
+  radio.rx.push_back(makeFrame(PH_TYPE_ANNOUNCE, 100));
+  disp.loop();
+  CHECK_EQ(disp.received.size(), 4);
+  if (disp.received.size() == 4) {
+    Packet* fwd = disp.received[3];
+    fwd->header |= PH_HAS_TRANS_ADDRESS;
+    memset(fwd->transport_id, 0x33, DEST_HASH_SIZE);
+    memset(fwd->destination_hash, 0x44, DEST_HASH_SIZE);
+    host_millis += 1000;
+    disp.sendPacket(fwd, 0);
+    disp.loop();
+    CHECK_EQ(radio.sent.size(), 2);
+    if (radio.sent.size() == 2) {
+      const std::vector<uint8_t>& f = radio.sent[1];
+      CHECK_EQ(f.size(), 2 + DEST_HASH_SIZE + 100);
+      CHECK_EQ(f[0], PH_TYPE_ANNOUNCE | PH_HAS_TRANS_ADDRESS);
+      CHECK_EQ(f[2], 0x33);
+      bool ok = true;
+      for (int i = 0; i < 100; i++) ok = ok && f[2 + DEST_HASH_SIZE + i] == i;
+      CHECK(ok);
+    }
+  }
+
+  return testResult("test_dispatcher_frames");
+}
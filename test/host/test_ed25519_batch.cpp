@@ -0,0 +1,130 @@
+#include "test.h"
+#include <string.h>
+#include <ed_25519.h>
+extern "C" {
+#include <ge.h>
+#include <sc.h>
+#include <sha512.h>
+}
+
+/*
+ * ed25519_verify_batch() must give the same result as ed25519_verify() for every item: an all valid batch, a batch
+ * with one forged item, and signatures whose R has a small order component added (which an uncofactored batch
+ * equation lets through in pairs, as the components cancel out).
+*/
+
+#define BATCH     8
+#define MSG_LEN   40
+
+struct Item {
+  uint8_t pub[32], prv[64], sig[64], msg[MSG_LEN];
+};
+
+static Item items[BATCH];
+static ed25519_iovec iovs[BATCH];
+static ed25519_batch_item batch[BATCH];
+static uint8_t scratch[BATCH*ED25519_BATCH_SCRATCH_PER_ITEM] __attribute__((aligned(8)));
+static uint8_t random_bytes[BATCH*16];
+
+static void randomBytes(uint8_t* dest, int len) {
+  for (int i = 0; i < len; i++) dest[i] = rand() & 0xFF;
+}
+
+static void makeItems() {
+  for (int i = 0; i < BATCH; i++) {
+    uint8_t seed[32];
+    randomBytes(seed, 32);
+    randomBytes(items[i].msg, MSG_LEN);
+    ed25519_create_keypair(items[i].pub, items[i].prv, seed);
+    ed25519_sign(items[i].sig, items[i].msg, MSG_LEN, items[i].pub, items[i].prv);
+    iovs[i] = { items[i].msg, MSG_LEN };
+    batch[i] = { items[i].sig, items[i].pub, &iovs[i], 1 };
+  }
+}
+
+// signs with R = rB + T, where T = (0, -1) has order 2. So SB - hA is R - T, which is only equal to R cofactored
+static void signWithSmallOrderR(Item& item) {
+  static const uint8_t order2[32] = { 0xec, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+                                      0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f };
+  uint8_t r[64], h[64];
+  randomBytes(r, 64);
+  sc_reduce(r);
+
+  ge_p3 rB, T, R;
+  ge_cached t_cached;
+  ge_p1p1 sum;
+  ge_scalarmult_base(&rB, r);
+  CHECK_EQ(ge_frombytes_negate_vartime(&T, order2), 0);   // (-T is T)
+  ge_p3_to_cached(&t_cached, &T);
+  ge_add(&sum, &rB, &t_cached);
+  ge_p1p1_to_p3(&R, &sum);
+  ge_p3_tobytes(item.sig, &R);
+
+  sha512_context hash;
+  sha512_init(&hash);
+  sha512_update(&hash, item.sig, 32);
+  sha512_update(&hash, item.pub, 32);
+  sha512_update(&hash, item.msg, MSG_LEN);
+  sha512_final(&hash, h);
+  sc_reduce(h);
+  sc_muladd(&item.sig[32], h, item.prv, r);   // S = r + ha
+}
+
+// each result of the batch is what ed25519_verify() says
+static void checkAgrees(int count) {
+  int valid[BATCH];
+  int all = ed25519_verify_batch(batch, count, random_bytes, scratch, valid);
+  int expected_all = 1;
+  for (int i = 0; i < count; i++) {
+    int single = ed25519_verify(items[i].sig, items[i].msg, MSG_LEN, items[i].pub);
+    CHECK_EQ(valid[i], single);
+    expected_all &= single;
+  }
+  CHECK_EQ(all, expected_all);
+}
+
+static void testAllValid() {
+  makeItems();
+  randomBytes(random_bytes, sizeof(random_bytes));
+  int valid[BATCH];
+  CHECK(ed25519_verify_batch(batch, BATCH, random_bytes, scratch, valid));
+  for (int i = 0; i < BATCH; i++) CHECK_EQ(valid[i], 1);
+  checkAgrees(BATCH);
+}
+
+static void testOneForged() {
+  makeItems();
+  randomBytes(random_bytes, sizeof(random_bytes));
+  items[5].msg[0] ^= 1;
+  int valid[BATCH];
+  CHECK(!ed25519_verify_batch(batch, BATCH, random_bytes, scratch, valid));
+  for (int i = 0; i < BATCH; i++) CHECK_EQ(valid[i], i != 5);
+  checkAgrees(BATCH);
+}
+
+static void testSmallOrderR() {
+  for (int trial = 0; trial < 100; trial++) {
+    makeItems();
+    randomBytes(random_bytes, sizeof(random_bytes));
+    signWithSmallOrderR(items[0]);
+    signWithSmallOrderR(items[1]);
+#ifdef ED25519_COFACTORED
+    CHECK(ed25519_verify(items[0].sig, items[0].msg, MSG_LEN, items[0].pub));   // valid, cofactored
+#else
+    CHECK(!ed25519_verify(items[0].sig, items[0].msg, MSG_LEN, items[0].pub));
+#endif
+    checkAgrees(2);   // the pair on its own
+    checkAgrees(BATCH);
+
+    signWithSmallOrderR(items[4]);   // an odd number of them
+    checkAgrees(BATCH);
+  }
+}
+
+int main() {
+  srand(1);
+  testAllValid();
+  testOneForged();
+  testSmallOrderR();
+  return testResult("test_ed25519_batch");
+}
@@ -0,0 +1,158 @@
+#include "test.h"
+#include <string.h>
+#include <ed_25519.h>
+extern "C" {
+#include <fe.h>
+}
+
+/*
+ * Known answers for lib/ed25519, in whichever field arithmetic it is built with (fe_51.c by default on 64-bit hosts,
+ * fe.c with DEFS=-DED25519_FE_32). The RFC 8032 vectors are checked directly. Everything else is hashed into digests
+ * of many pseudo-random operations, whose expected values were taken from the 10 limb (fe.c) build, so both builds
+ * must produce exactly the same bytes.
+*/
+
+#define NUM_KEYS      300
+#define NUM_FIELD_OPS 2000
+
+// xorshift, so every build sees the same inputs
+static uint64_t rand_state = 88172645463325252ULL;
+static uint8_t nextByte() {
+  rand_state ^= rand_state << 13;
+  rand_state ^= rand_state >> 7;
+  rand_state ^= rand_state << 17;
+  return rand_state >> 24;
+}
+static void randomBytes(uint8_t* dest, int len) {
+  for (int i = 0; i < len; i++) dest[i] = nextByte();
+}
+
+// FNV-1a
+struct Digest {
+  uint64_t h = 14695981039346656037ULL;
+  void add(const void* data, int len) {
+    for (int i = 0; i < len; i++) { h ^= ((const uint8_t *) data)[i]; h *= 1099511628211ULL; }
+  }
+};
+
+static void fromHex(uint8_t* dest, const char* hex, int len) {
+  for (int i = 0; i < len; i++) sscanf(&hex[2*i], "%2hhx", &dest[i]);
+}
+
+// RFC 8032, section 7.1, TEST 1 (empty message) and TEST 2 (0x72)
+static void testRFC8032() {
+  static const char* secrets[] = { "9d61b19deffd5a60ba844af492ec2cc44449c5697b326919703bac031cae7f60",
+                                   "4ccd089b28ff96da9db6c346ec114e0f5b8a319f35aba624da8cf6ed4fb8a6fb" };
+  static const char* publics[] = { "d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a",
+                                   "3d4017c3e843895a92b70aa74d1b7ebc9c982ccf2ec4968cc0cd55f12af4660c" };
+  static const char* sigs[] = { "e5564300c360ac729086e2cc806e828a84877f1eb8e5d974d873e065224901555fb8821590a33bacc61e39701cf9b46bd25bf5f0595bbe24655141438e7a100b",
+                                "92a009a9f0d4cab8720e820b5f642540a2b27b5416503f8fb3762223ebdb69da085ac1e43e15996e458f3613d0f11d8c387b2eaeb4302aeeb00d291612bb0c00" };
+  for (int t = 0; t < 2; t++) {
+    uint8_t seed[32], pub[32], prv[64], sig[64], expected_pub[32], expected_sig[64], msg[1] = { 0x72 };
+    fromHex(seed, secrets[t], 32);
+    fromHex(expected_pub, publics[t], 32);
+    fromHex(expected_sig, sigs[t], 64);
+    ed25519_create_keypair(pub, prv, seed);
+    ed25519_sign(sig, msg, t, pub, prv);
+    CHECK(memcmp(pub, expected_pub, 32) == 0);
+    CHECK(memcmp(sig, expected_sig, 64) == 0);
+    CHECK(ed25519_verify(sig, msg, t, pub));
+  }
+}
+
+// key pairs, signatures, key exchange (both ways agree) and add_scalar
+static void testKeysAndSignatures() {
+  Digest keys, secrets;
+  for (int i = 0; i < NUM_KEYS; i++) {
+    uint8_t seed[32], pub[32], prv[64], sig[64], msg[50], pub2[32], prv2[64], x[32], y[32], scalar[32];
+    randomBytes(seed, 32);
+    randomBytes(msg, sizeof(msg));
+    ed25519_create_keypair(pub, prv, seed);
+    ed25519_sign(sig, msg, i % 50, pub, prv);
+    keys.add(pub, 32);
+    keys.add(sig, 64);
+    CHECK(ed25519_verify(sig, msg, i % 50, pub));
+    sig[i % 64] ^= 1;
+    CHECK(!ed25519_verify(sig, msg, i % 50, pub));
+
+    randomBytes(seed, 32);
+    ed25519_create_keypair(pub2, prv2, seed);
+    ed25519_key_exchange(x, pub2, prv);
+    ed25519_key_exchange(y, pub, prv2);
+    CHECK(memcmp(x, y, 32) == 0);
+    secrets.add(x, 32);
+
+    randomBytes(scalar, 32);
+    ed25519_add_scalar(pub, prv, scalar);
+    keys.add(pub, 32);
+    keys.add(prv, 64);
+  }
+  CHECK(keys.h == 0xff0cb111d5a2c7ebULL);
+  CHECK(secrets.h == 0x0cfe6580fd10fc48ULL);
+}
+
+// each field operation, on random inputs, and some edge cases (p, 2^255-1, non-canonical, zero)
+static void testFieldOps() {
+  Digest ops;
+  for (int i = 0; i < NUM_FIELD_OPS; i++) {
+    uint8_t a[32], b[32], out[32];
+    fe f, g, h;
+    randomBytes(a, 32);
+    randomBytes(b, 32);
+    if (i < 8) {
+      memset(a, i < 4 ? 0xff : 0, 32);
+      a[31] = (i & 1) ? 0x7f : 0xff;
+      a[0] ^= (i & 2) ? 0x12 : 0;
+    }
+    fe_frombytes(f, a);
+    fe_frombytes(g, b);
+
+    fe_tobytes(out, f); ops.add(out, 32);
+    fe_mul(h, f, g); fe_tobytes(out, h); ops.add(out, 32);
+    fe_sq(h, f); fe_tobytes(out, h); ops.add(out, 32);
+    fe_sq2(h, g); fe_tobytes(out, h); ops.add(out, 32);
+    fe_add(h, f, g); fe_tobytes(out, h); ops.add(out, 32);
+    fe_sub(h, f, g); fe_tobytes(out, h); ops.add(out, 32);
+    fe_sub(h, g, f); fe_tobytes(out, h); ops.add(out, 32);
+    fe_neg(h, f); fe_tobytes(out, h); ops.add(out, 32);
+    fe_invert(h, f); fe_tobytes(out, h); ops.add(out, 32);
+    fe_pow22523(h, g); fe_tobytes(out, h); ops.add(out, 32);
+    fe_mul121666(h, f); fe_tobytes(out, h); ops.add(out, 32);
+    int flags = fe_isnegative(f) + 2*fe_isnonzero(g);
+    ops.add(&flags, sizeof(flags));
+    fe_copy(h, f);
+    fe_cswap(h, g, i & 1); fe_tobytes(out, h); ops.add(out, 32);
+    fe_cmov(h, f, (i >> 1) & 1); fe_tobytes(out, h); ops.add(out, 32);
+  }
+  CHECK(ops.h == 0x86a95942040f3e55ULL);
+}
+
+// batched key exchange matches one at a time, including for keys which aren't valid points
+static void testKeyExchangeBatch() {
+  uint8_t seed[32] = { 9 }, pub[32], prv[64], pub_keys[20*32], batch[20*32], single[32];
+  ed25519_create_keypair(pub, prv, seed);
+  randomBytes(pub_keys, sizeof(pub_keys));
+  memset(&pub_keys[3*32], 0, 32); pub_keys[3*32] = 1;   // y = 1, the identity point
+  memset(&pub_keys[11*32], 0, 32);
+  ed25519_key_exchange_batch(batch, pub_keys, 20, prv);
+  for (int i = 0; i < 20; i++) {
+    ed25519_key_exchange(single, &pub_keys[i*32], prv);
+    CHECK(memcmp(single, &batch[i*32], 32) == 0);
+  }
+  Digest d;
+  d.add(batch, sizeof(batch));
+  CHECK(d.h == 0x0bee1b42812e0ed4ULL);
+}
+
+int main() {
+  testRFC8032();
+  testKeysAndSignatures();
+  testFieldOps();
+  testKeyExchangeBatch();
+#ifdef ED25519_FE_51
+  printf("(51 bit limbs)\n");
+#else
+  printf("(26/25 bit limbs)\n");
+#endif
+  return testResult("test_ed25519_kat");
+}
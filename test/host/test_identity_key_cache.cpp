@@ -0,0 +1,67 @@
+#include "test.h"
+#include "sim.h"
+#include <Identity.h>
+#include <ed_25519.h>
+
+/*
+ * Identity::verify(), with its cache of decompressed public keys.
+*/
+using namespace ripple;
+
+static SimRNG rng;
+
+// a public key which isn't a point on the curve
+static void makeInvalidKey(uint8_t* pub_key) {
+  ed25519_key_point A;
+  for (int n = 0; ; n++) {
+    memset(pub_key, n, PUB_KEY_SIZE);
+    if (!ed25519_prepare_key(&A, NULL, pub_key)) return;
+  }
+}
+
+static void testHitsAndMisses() {
+  LocalIdentity id(&rng);
+  uint8_t sig[SIGNATURE_SIZE], msg[] = "hello";
+  id.sign(sig, msg, sizeof(msg));
+  Identity peer(id.pub_key);
+
+  uint32_t hits = Identity::getNumKeyCacheHits(), misses = Identity::getNumKeyCacheMisses();
+  CHECK(peer.verify(sig, msg, sizeof(msg)));
+  CHECK(peer.verify(sig, msg, sizeof(msg)));
+  msg[0] ^= 1;
+  CHECK(!peer.verify(sig, msg, sizeof(msg)));   // a bad signature, from a cached key
+  CHECK_EQ(Identity::getNumKeyCacheMisses() - misses, 1);
+  CHECK_EQ(Identity::getNumKeyCacheHits() - hits, 2);
+}
+
+// an invalid key must not spoil the cache slot it would have replaced
+static void testInvalidKey() {
+  LocalIdentity ids[PUBKEY_CACHE_SIZE];
+  uint8_t sigs[PUBKEY_CACHE_SIZE][SIGNATURE_SIZE], msg[] = "announce";
+  for (int i = 0; i < PUBKEY_CACHE_SIZE; i++) {
+    ids[i] = LocalIdentity(&rng);
+    ids[i].sign(sigs[i], msg, sizeof(msg));
+    CHECK(Identity(ids[i].pub_key).verify(sigs[i], msg, sizeof(msg)));   // fills the cache, ids[0] least recently used
+  }
+
+  uint8_t bad_key[PUB_KEY_SIZE];
+  makeInvalidKey(bad_key);
+  CHECK(!Identity(bad_key).verify(sigs[0], msg, sizeof(msg)));
+
+  uint32_t hits = Identity::getNumKeyCacheHits();
+  for (int i = 0; i < PUBKEY_CACHE_SIZE; i++) {
+    CHECK(Identity(ids[i].pub_key).verify(sigs[i], msg, sizeof(msg)));
+  }
+  CHECK_EQ(Identity::getNumKeyCacheHits() - hits, PUBKEY_CACHE_SIZE);   // all still cached
+
+  CHECK(!Identity(bad_key).verify(sigs[0], msg, sizeof(msg)));   // never cached
+}
+
+int main() {
+  srand(1);
+  testHitsAndMisses();
+#if PUBKEY_CACHE_SIZE > 0
+  testInvalidKey();
+#endif
+  return testResult("test_identity_key_cache");
+}
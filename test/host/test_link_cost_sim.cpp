@@ -0,0 +1,119 @@
+#include "test.h"
+#include "sim.h"
+#include <MeshTransportFull.h>
+#include <helpers/SimpleMeshTables.h>
+#include <helpers/ScheduledPacketManager.h>
+
+/*
+ * Paths chosen by SNR-weighted hops (the default getLinkCost()), versus plain hop count. Alice and Bob are joined by
+ * a 2 hop short-cut over marginal links, and a 4 hop path over solid links:
+ *
+ *     alice(0) -- r0(1) -- rm(2) -- bob(5)        r0-rm, rm-bob: SNR -12.5/-11 dB, 45%/35% loss
+ *                    \                /
+ *                   ra(3) ------ rb(4)            SNR 6-8 dB, 2% loss
+*/
+using namespace ripple;
+
+static SimClock ms;
+static SimRTC rtc;
+static SimRNG rng;
+static bool hop_count_only;
+
+struct Edge : public MeshTransportNone {
+  LocalIdentity self_id;
+  int got_msg = 0, got_ack = 0;
+
+  Edge(Radio& radio) : MeshTransportNone(radio, ms, rng, rtc, *new SizedScheduledPacketManager<16>(), *new SimpleMeshTables(rtc)) { }
+
+  uint8_t getLinkCost(const Packet* packet) const override { return hop_count_only ? 1 : MeshTransportNone::getLinkCost(packet); }
+
+  DispatcherAction onDatagramRecv(Packet* packet, const uint8_t* packet_hash) override {
+    Destination dest(self_id, "chat.msg");
+    if (dest.matches(packet->destination_hash)) {
+      got_msg++;
+      sendPacket(createReplySigned(packet_hash, self_id, (const uint8_t *) "ok", 2), 0);
+      _tables->setSeenPacketHash(packet_hash, 1);
+      return ACTION_RELEASE;
+    }
+    return MeshTransportNone::onDatagramRecv(packet, packet_hash);
+  }
+  DispatcherAction onReplySignedRecv(Packet* packet, const uint8_t* reply, size_t reply_len) override {
+    got_ack++;
+    return ACTION_RELEASE;
+  }
+};
+
+struct Repeater : public MeshTransportFull {
+  Repeater(Radio& radio) : MeshTransportFull(radio, ms, rng, rtc, *new SizedScheduledPacketManager<32>(), *new SimpleMeshTables(rtc)) { }
+
+  uint8_t getLinkCost(const Packet* packet) const override { return hop_count_only ? 1 : MeshTransportFull::getLinkCost(packet); }
+};
+
+struct Result { int sent, delivered, acked; long airtime; };
+
+static void trial(int seed, int num_msgs, Result& res) {
+  srand(seed);
+  host_millis = 1000;
+  Air air;
+  AirRadio* radios[6];
+  for (int i = 0; i < 6; i++) radios[i] = new AirRadio(air);
+  air.addLink(0, 1, 8.0f, 0);
+  air.addLink(1, 3, 6.0f, 2);
+  air.addLink(3, 4, 7.0f, 2);
+  air.addLink(4, 5, 6.0f, 2);
+  air.addLink(1, 2, -12.5f, 45);
+  air.addLink(2, 5, -11.0f, 35);
+
+  Edge alice(*radios[0]), bob(*radios[5]);
+  Repeater r0(*radios[1]), rm(*radios[2]), ra(*radios[3]), rb(*radios[4]);
+  std::vector<Dispatcher*> nodes = { &alice, &r0, &rm, &ra, &rb, &bob };
+  alice.self_id = LocalIdentity(&rng);
+  bob.self_id = LocalIdentity(&rng);
+  r0.self_id = LocalIdentity(&rng);
+  rm.self_id = LocalIdentity(&rng);
+  ra.self_id = LocalIdentity(&rng);
+  rb.self_id = LocalIdentity(&rng);
+  for (Dispatcher* n : nodes) n->begin();
+
+  Destination dest(bob.self_id, "chat.msg");
+  bob.sendPacket(bob.createAnnounce("chat.msg", bob.self_id), 2);
+  runFor(air, nodes, 20000);
+  for (int k = 0; k < 3 && !alice.hasPathTo(dest.hash); k++) {
+    alice.requestPathTo(dest.hash);
+    runFor(air, nodes, 15000);
+  }
+
+  long start_airtime = 0;
+  for (AirRadio* r : radios) start_airtime += r->airtime;
+  for (int m = 0; m < num_msgs; m++) {
+    char text[8];
+    snprintf(text, sizeof(text), "m%d", m);
+    alice.sendPacket(alice.createDatagram(&dest, (const uint8_t *) text, strlen(text), true), 0);
+    runFor(air, nodes, 8000);
+  }
+  for (AirRadio* r : radios) res.airtime += r->airtime;
+  res.airtime -= start_airtime;
+  res.sent += num_msgs;
+  res.delivered += bob.got_msg;
+  res.acked += alice.got_ack;
+}
+
+static Result run(bool hop_count) {
+  hop_count_only = hop_count;
+  Result res = { 0, 0, 0, 0 };
+  for (int s = 1; s <= 40; s++) trial(s*7919, 20, res);
+  printf("%-22s delivered %5.1f%%, round-trip %5.1f%%, airtime per acked msg %6.0f ms\n", hop_count ? "hop count:" : "SNR-weighted hops:",
+    100.0*res.delivered/res.sent, 100.0*res.acked/res.sent, res.acked ? (double) res.airtime/res.acked : 0.0);
+  return res;
+}
+
+int main() {
+  Result hops = run(true);
+  Result snr = run(false);
+
+  CHECK(snr.acked > hops.acked);
+  CHECK(snr.delivered > hops.delivered);
+  CHECK((double) snr.airtime/snr.acked < (double) hops.airtime/hops.acked);
+
+  return testResult("test_link_cost_sim");
+}
@@ -0,0 +1,144 @@
+#include "test.h"
+#include "sim.h"
+#include <helpers/SimpleMeshTables.h>
+
+using namespace ripple;
+
+struct TestClock : public RTCClock {
+  uint32_t now = 1715770351;
+  uint32_t getCurrentTime() override { return now; }
+  void setCurrentTime(uint32_t time) override { now = time; }
+};
+
+static void makeHash(uint8_t* hash, int n) {
+  for (int i = 0; i < DEST_HASH_SIZE; i++) hash[i] = (n * 37 + i * 11) & 0xFF;
+}
+
+// a path which was evicted (or expired) must be re-learnable, even from an Announce already forwarded
+static void testRelearnEvicted() {
+  TestClock clock;
+  SizedMeshTables<2> tables(clock);
+  Packet pkt;
+  uint8_t a[DEST_HASH_SIZE], b[DEST_HASH_SIZE], c[DEST_HASH_SIZE];
+  makeHash(a, 1); makeHash(b, 2); makeHash(c, 3);
+
+  makeTableAnnounce(&pkt, clock.now, 1, 2);
+  CHECK(!tables.isAnnounceStale(a, &pkt));
+  CHECK(tables.updateNextHop(a, &pkt));
+  tables.setHasForwarded(announceRandBlob(&pkt));
+  CHECK(tables.isAnnounceStale(a, &pkt));   // same announce, same path
+
+  Packet other;
+  clock.now += KEEP_ALIVE_SECS + 1;
+  makeTableAnnounce(&other, clock.now, 2, 1);
+  CHECK(tables.updateNextHop(b, &other));
+  clock.now += KEEP_ALIVE_SECS + 1;
+  makeTableAnnounce(&other, clock.now, 3, 1);
+  CHECK(tables.updateNextHop(c, &other));   // evicts 'a'
+  CHECK(!tables.hasNextHop(a));
+
+  // eg. replayed by a neighbour in answer to a path.request
+  CHECK(tables.hasForwarded(announceRandBlob(&pkt)));
+  CHECK(!tables.isAnnounceStale(a, &pkt));
+  CHECK(tables.updateNextHop(a, &pkt));
+  CHECK(tables.hasNextHop(a));
+}
+
+// older, and no-better, Announces for a known destination are still filtered
+static void testStaleKnown() {
+  TestClock clock;
+  SimpleMeshTables tables(clock);
+  Packet pkt;
+  uint8_t a[DEST_HASH_SIZE], via1[DEST_HASH_SIZE], via2[DEST_HASH_SIZE];
+  makeHash(a, 1); makeHash(via1, 10); makeHash(via2, 11);
+
+  makeTableAnnounce(&pkt, clock.now, 1, 2, via1);
+  CHECK(tables.updateNextHop(a, &pkt));
+
+  makeTableAnnounce(&pkt, clock.now - 10, 2, 1, via1);   // older
+  CHECK(tables.isAnnounceStale(a, &pkt));
+
+  makeTableAnnounce(&pkt, clock.now, 1, 3, via1);   // same round, same next-hop
+  CHECK(tables.isAnnounceStale(a, &pkt));
+
+  makeTableAnnounce(&pkt, clock.now, 1, 3, via2);   // same round, a new alternate
+  CHECK(!tables.isAnnounceStale(a, &pkt));
+
+  clock.now += LATE_ANNOUNCE_SECS + 1;
+  CHECK(tables.isAnnounceStale(a, &pkt));   // too late for this round
+
+  makeTableAnnounce(&pkt, clock.now, 3, 4, via2);   // a newer round
+  CHECK(!tables.isAnnounceStale(a, &pkt));
+}
+
+// adding an alternate, and failing over to it, journal just the next-hop fields, and replay to the same tables
+static void testNextHopsJournal() {
+  TestClock clock;
+  SimpleMeshTables tables(clock);
+  MemStream journal;
+  tables.writeSnapshot(journal);
+  tables.setJournal(&journal);
+
+  Packet pkt;
+  uint8_t a[DEST_HASH_SIZE], via1[DEST_HASH_SIZE], via2[DEST_HASH_SIZE], next_hop[DEST_HASH_SIZE];
+  makeHash(a, 1); makeHash(via1, 10); makeHash(via2, 11);
+
+  makeTableAnnounce(&pkt, clock.now, 1, 2, via1);
+  CHECK(tables.updateNextHop(a, &pkt));
+  size_t dest_rec = journal.data.size();
+
+  makeTableAnnounce(&pkt, clock.now, 1, 3, via2);   // same round, a new alternate
+  CHECK(!tables.updateNextHop(a, &pkt));
+  size_t alt_rec = journal.data.size() - dest_rec;
+  CHECK_EQ(alt_rec, 1 + 2 + 4 + DEST_HASH_SIZE + MAX_ALT_HOPS*sizeof(AltNextHop) + 2);
+
+  CHECK(tables.failoverNextHop(a));
+  CHECK_EQ(journal.data.size() - dest_rec, 2*alt_rec);
+  CHECK(!tables.failoverNextHop(a));   // no more alternates, so nothing journalled
+  CHECK_EQ(journal.data.size() - dest_rec, 2*alt_rec);
+
+  SimpleMeshTables replayed(clock);
+  CHECK_EQ(replayed.replayJournal(journal), 4);   // filters, dest, and two next-hops records
+  CHECK(replayed.getNextHop(a, next_hop));
+  CHECK(memcmp(next_hop, via2, DEST_HASH_SIZE) == 0);
+  CHECK(!replayed.failoverNextHop(a));
+
+  makeTableAnnounce(&pkt, clock.now, 1, 3, via1);   // the failed one can be re-added as an alternate
+  CHECK(!replayed.isAnnounceStale(a, &pkt));
+}
+
+// paths are ranked by path_cost, but the hops kept (and replayed on the wire) stay a plain hop count
+static void testPathCostRanking() {
+  TestClock clock;
+  SimpleMeshTables tables(clock);
+  Packet pkt, orig;
+  uint8_t a[DEST_HASH_SIZE], via1[DEST_HASH_SIZE], via2[DEST_HASH_SIZE], next_hop[DEST_HASH_SIZE];
+  makeHash(a, 1); makeHash(via1, 10); makeHash(via2, 11);
+
+  makeTableAnnounce(&pkt, clock.now, 1, 2, via1);
+  pkt.path_cost = 4;   // heard over a marginal link
+  CHECK(tables.updateNextHop(a, &pkt));
+
+  makeTableAnnounce(&pkt, clock.now, 1, 3, via2);   // same round, more hops, but cheaper
+  CHECK(!tables.isAnnounceStale(a, &pkt));
+  CHECK(tables.updateNextHop(a, &pkt));
+  CHECK(tables.getNextHop(a, next_hop));
+  CHECK(memcmp(next_hop, via2, DEST_HASH_SIZE) == 0);
+  CHECK(tables.getOrigAnnounce(a, &orig) > 0);
+  CHECK_EQ(orig.hops, 3);
+
+  CHECK(tables.failoverNextHop(a));
+  CHECK(tables.getNextHop(a, next_hop));
+  CHECK(memcmp(next_hop, via1, DEST_HASH_SIZE) == 0);
+  CHECK(tables.getOrigAnnounce(a, &orig) > 0);
+  CHECK_EQ(orig.hops, 2);
+  CHECK_EQ(orig.path_cost, 4);
+}
+
+int main() {
+  testRelearnEvicted();
+  testStaleKnown();
+  testNextHopsJournal();
+  testPathCostRanking();
+  return testResult("test_mesh_tables");
+}
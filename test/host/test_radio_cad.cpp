@@ -0,0 +1,43 @@
+#include "test.h"
+#include <helpers/CustomSX1262Wrapper.h>
+#include <helpers/CustomSX1268Wrapper.h>
+
+struct TestBoard : public ripple::MainBoard {
+  uint16_t getBattMilliVolts() override { return 0; }
+  const char* getManufacturerName() const override { return "host"; }
+  void reboot() override { }
+  uint8_t getStartupReason() const override { return 0; }
+};
+
+// after a listen-before-talk probe, the radio must be back in receive mode, whatever the outcome
+template<typename R, typename W> void checkCAD(const char* name) {
+  Module mod(0, 0, 0, 0);
+  R chip(&mod);
+  TestBoard board;
+  W radio(chip, board);
+  radio.begin();
+
+  uint8_t buf[256];
+  radio.recvRaw(buf, sizeof(buf));   // starts receive
+  CHECK(chip.mode == PhysicalLayer::MODE_RX);
+
+  chip.cad_busy = true;
+  CHECK(radio.isChannelActive());
+  CHECK(chip.mode == PhysicalLayer::MODE_RX);
+
+  chip.cad_busy = false;
+  CHECK(!radio.isChannelActive());
+  CHECK(chip.mode == PhysicalLayer::MODE_RX);
+
+  // and the wrapper knows it's in receive, so doesn't restart it on the next poll
+  int n = chip.n_start_receive;
+  CHECK_EQ(radio.recvRaw(buf, sizeof(buf)), 0);
+  CHECK_EQ(chip.n_start_receive, n);
+  if (test_failures) printf("  (%s)\n", name);
+}
+
+int main() {
+  checkCAD<CustomSX1262, CustomSX1262Wrapper>("SX1262");
+  checkCAD<CustomSX1268, CustomSX1268Wrapper>("SX1268");
+  return testResult("test_radio_cad");
+}
@@ -0,0 +1,62 @@
+#include "test.h"
+#include <helpers/ScheduledPacketManager.h>
+
+struct QueueManager : public SizedPoolPacketManager<64> { };
+struct HeapManager : public SizedScheduledPacketManager<64> { };
+
+// the heaps must hand out Packets in exactly the order of the original linear-scan PacketQueue
+int main() {
+  QueueManager ref;
+  HeapManager mgr;
+  srand(1);
+
+  uint32_t now = 0xFFFF0000;   // wraps back to zero part way through
+  int n_sent = 0;
+  for (int step = 0; step < 200000; step++) {
+    if (rand() % 3 == 0 && mgr.getFreeCount() > 0) {
+      ripple::Packet* r = ref.allocNew();
+      ripple::Packet* m = mgr.allocNew();
+      r->header = m->header = step & 0xFF;    // tag, to compare by
+      r->payload_len = m->payload_len = step >> 8;
+      uint8_t pri = rand() % 4;
+      uint32_t at = now + (rand() % 5 == 0 ? 0 : rand() % 3000);
+      ref.queueOutbound(r, pri, at);
+      mgr.queueOutbound(m, pri, at);
+    }
+    CHECK_EQ(mgr.getOutboundCount(), ref.getOutboundCount());
+
+    if (ref.getOutboundCount() > 0) {
+      bool due = (int32_t)(ref.getNextOutboundTime() - now) <= 0;
+      CHECK(due == ((int32_t)(mgr.getNextOutboundTime() - now) <= 0));
+      if (!due) CHECK_EQ(mgr.getNextOutboundTime(), ref.getNextOutboundTime());
+    }
+
+    uint8_t ref_pri = 0xFF, pri = 0xFF;
+    ripple::Packet* r = ref.getNextOutbound(now, &ref_pri);
+    ripple::Packet* m = mgr.getNextOutbound(now, &pri);
+    CHECK((r == NULL) == (m == NULL));
+    if (r && m) {
+      CHECK_EQ(m->header, r->header);
+      CHECK_EQ(m->payload_len, r->payload_len);
+      CHECK_EQ(pri, ref_pri);
+      ref.free(r);
+      mgr.free(m);
+      n_sent++;
+    }
+    if (test_failures > 10) break;
+    now += rand() % 20;
+  }
+  CHECK(now < 0xFFFF0000);   // did wrap
+  CHECK(n_sent > 10000);
+
+  // removeOutboundByIdx() / getOutboundByIdx() span both heaps
+  while (mgr.getOutboundCount() > 0) {
+    ripple::Packet* p = mgr.getOutboundByIdx(mgr.getOutboundCount() - 1);
+    CHECK(mgr.removeOutboundByIdx(mgr.getOutboundCount() - 1) == p);
+    mgr.free(p);
+  }
+  CHECK(mgr.removeOutboundByIdx(0) == NULL);
+  CHECK_EQ(mgr.getFreeCount(), 64);
+
+  return testResult("test_scheduler");
+}
@@ -0,0 +1,98 @@
+#include "test.h"
+#include "sim.h"
+#include <helpers/SharedSecretCache.h>
+
+/*
+ * SharedSecretCache, and the batched LocalIdentity::calcSharedSecrets() it prefetches with.
+*/
+using namespace ripple;
+
+static SimRNG rng;
+
+static bool secretIs(const uint8_t* secret, LocalIdentity& self, const Identity& other) {
+  uint8_t expected[PUB_KEY_SIZE];
+  self.calcSharedSecret(expected, other);
+  return memcmp(secret, expected, PUB_KEY_SIZE) == 0;
+}
+
+static void testBatchMatches() {
+  LocalIdentity self(&rng);
+  Identity others[20];
+  for (int i = 0; i < 20; i++) others[i] = LocalIdentity(&rng);
+  uint8_t secrets[20*PUB_KEY_SIZE];
+  self.calcSharedSecrets(secrets, others, 20);
+  for (int i = 0; i < 20; i++) CHECK(secretIs(&secrets[i*PUB_KEY_SIZE], self, others[i]));
+}
+
+static void testLeastRecentlyUsed() {
+  LocalIdentity self(&rng);
+  SharedSecretCache<4> cache(self);
+  Identity others[5];
+  for (int i = 0; i < 5; i++) others[i] = LocalIdentity(&rng);
+
+  for (int i = 0; i < 4; i++) CHECK(secretIs(cache.getSecret(others[i]), self, others[i]));
+  CHECK(secretIs(cache.getSecret(others[0]), self, others[0]));
+  CHECK_EQ(cache.getNumMisses(), 4);
+  CHECK_EQ(cache.getNumHits(), 1);
+
+  cache.getSecret(others[4]);   // replaces others[1]
+  cache.getSecret(others[0]);
+  CHECK_EQ(cache.getNumMisses(), 5);
+  cache.getSecret(others[1]);
+  CHECK_EQ(cache.getNumMisses(), 6);
+
+  SharedSecretCache<4> prefetched(self);
+  CHECK_EQ(prefetched.prefetch(others, 5), 4);   // only N
+  CHECK_EQ(prefetched.prefetch(others, 4), 0);   // all cached
+  for (int i = 0; i < 4; i++) CHECK(secretIs(prefetched.getSecret(others[i]), self, others[i]));
+  CHECK_EQ(prefetched.getNumMisses(), 0);
+}
+
+// keys already cached must be kept by prefetch(), even if older than the rest, and duplicates only calculated once
+static void testPrefetchKeeps() {
+  LocalIdentity self(&rng);
+  SharedSecretCache<4> cache(self);
+  Identity others[7];
+  for (int i = 0; i < 7; i++) others[i] = LocalIdentity(&rng);
+  for (int i = 0; i < 4; i++) cache.getSecret(others[i]);   // A,B,C,D (A least recent)
+
+  Identity wanted[4] = { others[0], others[4], others[5], others[6] };   // A,E,F,G
+  CHECK_EQ(cache.prefetch(wanted, 4), 3);
+  for (int i = 0; i < 4; i++) CHECK(secretIs(cache.getSecret(wanted[i]), self, wanted[i]));
+  CHECK_EQ(cache.getNumMisses(), 4);   // (just the first four)
+
+  SharedSecretCache<4> dups(self);
+  Identity repeated[4] = { others[0], others[1], others[0], others[1] };
+  CHECK_EQ(dups.prefetch(repeated, 4), 2);
+  dups.getSecret(others[2]);
+  dups.getSecret(others[3]);   // would replace a duplicate entry, if there were any
+  dups.getSecret(others[0]);
+  dups.getSecret(others[1]);
+  CHECK_EQ(dups.getNumMisses(), 2);
+}
+
+// secrets of a previous LocalIdentity must not be handed out
+static void testIdentityChanged() {
+  LocalIdentity self(&rng);
+  SharedSecretCache<4> cache(self);
+  Identity other = LocalIdentity(&rng);
+  cache.getSecret(other);
+
+  self = LocalIdentity(&rng);   // eg. loaded from storage after construction, as in simple_secure_chat
+  CHECK(secretIs(cache.getSecret(other), self, other));
+  CHECK_EQ(cache.getNumMisses(), 2);
+
+  self = LocalIdentity(&rng);
+  Identity others[2] = { other, LocalIdentity(&rng) };
+  CHECK_EQ(cache.prefetch(others, 2), 2);
+  CHECK(secretIs(cache.getSecret(other), self, other));
+}
+
+int main() {
+  srand(1);
+  testBatchMatches();
+  testLeastRecentlyUsed();
+  testPrefetchKeeps();
+  testIdentityChanged();
+  return testResult("test_shared_secret_cache");
+}
@@ -0,0 +1,197 @@
+#include "test.h"
+#include "sim.h"
+#include <helpers/SimpleMeshTables.h>
+
+/*
+ * SimpleMeshTables checkpoint (to retained memory, across deep sleep) and restore.
+*/
+using namespace ripple;
+
+#define RETAINED_SIZE  6400   // as ESP32RetainedMemory
+
+struct TestClock : public RTCClock {
+  uint32_t now = 1715770351;
+  uint32_t getCurrentTime() override { return now; }
+  void setCurrentTime(uint32_t time) override { now = time; }
+};
+
+static void makeHash(uint8_t* hash, int n) {
+  for (int i = 0; i < DEST_HASH_SIZE; i++) hash[i] = (n * 37 + i * 11) & 0xFF;
+}
+
+// tables with 'num_dests' destinations (via 'via'), a seen packet hash, a mapping, and a forwarded Announce
+template <typename T> static void fillTables(T& tables, TestClock& clock, int num_dests, Packet& forwarded) {
+  uint8_t dest[DEST_HASH_SIZE], via[DEST_HASH_SIZE], hash[DEST_HASH_SIZE];
+  makeHash(via, 1000);
+  for (int d = 0; d < num_dests; d++) {
+    makeHash(dest, d);
+    makeTableAnnounce(&forwarded, clock.now, d, 2, via);
+    CHECK(tables.updateNextHop(dest, &forwarded));
+    clock.now++;
+  }
+  makeHash(hash, 2000);
+  tables.setSeenPacketHash(hash, 2);
+  makeHash(dest, 0);
+  tables.setPacketHashDest(hash, dest);
+  tables.setHasForwarded(announceRandBlob(&forwarded));
+}
+
+static void testRoundTrip() {
+  TestClock clock;
+  SimpleMeshTables tables(clock);
+  Packet forwarded;
+  fillTables(tables, clock, 10, forwarded);
+
+  HostRetainedMemory mem(RETAINED_SIZE);
+  size_t used = tables.checkpointTo(mem);
+  CHECK(used > 0 && used <= RETAINED_SIZE);
+
+  SimpleMeshTables restored(clock);
+  double start = nowNanos();
+  CHECK(restored.restoreCheckpoint(mem));
+  double elapsed = nowNanos() - start;
+  printf("checkpoint: %d bytes, restored in %.1f us\n", (int) used, elapsed / 1000);
+
+  uint8_t dest[DEST_HASH_SIZE], via[DEST_HASH_SIZE], hash[DEST_HASH_SIZE], next_hop[DEST_HASH_SIZE], orig[DEST_HASH_SIZE];
+  makeHash(via, 1000);
+  for (int d = 0; d < 10; d++) {
+    makeHash(dest, d);
+    CHECK(restored.getNextHop(dest, next_hop));
+    CHECK(memcmp(next_hop, via, DEST_HASH_SIZE) == 0);
+  }
+  makeHash(hash, 2000);
+  CHECK_EQ(restored.getSeenPacketHash(hash), 2);
+  CHECK(restored.getPacketHashDest(hash, orig));
+  makeHash(dest, 0);
+  CHECK(memcmp(orig, dest, DEST_HASH_SIZE) == 0);
+  CHECK(restored.hasForwarded(announceRandBlob(&forwarded)));   // so it isn't re-flooded after wake
+
+  SimpleMeshTables again(clock);
+  CHECK(!again.restoreCheckpoint(mem));   // only used once
+}
+
+// a full table, checkpointed while the clock was ahead of where it restarts on wake
+static void testRebaseTimes() {
+  TestClock clock;
+  clock.now += 1000000;
+  SizedMeshTables<4> tables(clock);
+  Packet forwarded;
+  fillTables(tables, clock, 4, forwarded);
+  HostRetainedMemory mem(RETAINED_SIZE);
+  CHECK(tables.checkpointTo(mem) > 0);
+
+  TestClock restarted;
+  SizedMeshTables<4> restored(restarted);
+  CHECK(restored.restoreCheckpoint(mem));
+  CHECK(restored.hasForwarded(announceRandBlob(&forwarded)));
+
+  restarted.now += KEEP_ALIVE_SECS + 1;
+  Packet pkt;
+  uint8_t dest[DEST_HASH_SIZE];
+  makeHash(dest, 99);
+  makeTableAnnounce(&pkt, restarted.now, 99, 1);
+  CHECK(restored.updateNextHop(dest, &pkt));   // can evict, as restored times aren't in the future
+  makeHash(dest, 0);
+  CHECK(!restored.hasNextHop(dest));   // least recently used
+}
+
+static void testInvalid() {
+  TestClock clock;
+  SimpleMeshTables tables(clock);
+  Packet forwarded;
+  fillTables(tables, clock, 10, forwarded);
+
+  HostRetainedMemory mem(RETAINED_SIZE);   // power on: garbage
+  SimpleMeshTables t1(clock);
+  CHECK(!t1.restoreCheckpoint(mem));
+
+  CHECK(tables.checkpointTo(mem) > 0);
+  mem.buf[CHECKPOINT_HDR_SIZE + 20] ^= 0x01;   // corrupted
+  SimpleMeshTables t2(clock);
+  CHECK(!t2.restoreCheckpoint(mem));
+
+  // counts past the end, but with a valid CRC
+  uint16_t len, crc, num_dests = 60000;
+  size_t used = tables.checkpointTo(mem);
+  memcpy(&len, &mem.buf[5], 2);
+  memcpy(&mem.buf[CHECKPOINT_HDR_SIZE + 4], &num_dests, 2);
+  crc = Utils::crc16(&mem.buf[CHECKPOINT_HDR_SIZE], len);
+  memcpy(&mem.buf[7], &crc, 2);
+  SimpleMeshTables t3(clock);
+  CHECK(!t3.restoreCheckpoint(mem));
+
+  tables.checkpointTo(mem);
+  CHECK_EQ(mem.buf[used - 1 - CHECKPOINT_MAP_SIZE], 1);   // num_maps, before the one mapping
+  mem.buf[used - 1 - CHECKPOINT_MAP_SIZE] = 255;
+  crc = Utils::crc16(&mem.buf[CHECKPOINT_HDR_SIZE], len);
+  memcpy(&mem.buf[7], &crc, 2);
+  SimpleMeshTables t4(clock);
+  CHECK(!t4.restoreCheckpoint(mem));
+
+  // too small to hold anything
+  HostRetainedMemory tiny(CHECKPOINT_HDR_SIZE);
+  CHECK_EQ(tables.checkpointTo(tiny), 0);
+  SimpleMeshTables t5(clock);
+  CHECK(!t5.restoreCheckpoint(tiny));
+}
+
+// restored entries are partial, until completed from the journal, so compaction doesn't lose the signatures
+static void testCompleteFromJournal() {
+  TestClock clock;
+  SimpleMeshTables tables(clock);
+  MemStream journal;
+  tables.writeSnapshot(journal);
+  tables.setJournal(&journal);
+  Packet forwarded;
+  fillTables(tables, clock, 10, forwarded);
+  tables.setJournal(NULL);
+
+  HostRetainedMemory mem(RETAINED_SIZE);
+  CHECK(tables.checkpointTo(mem) > 0);
+  SimpleMeshTables restored(clock);
+  CHECK(restored.restoreCheckpoint(mem));
+
+  Packet orig, expected;
+  uint8_t dest[DEST_HASH_SIZE];
+  makeHash(dest, 3);
+  CHECK_EQ(restored.getOrigAnnounce(dest, &orig), 0);   // partial
+
+  // a fresh Announce for one, while awake, must be kept
+  Packet fresh;
+  uint8_t via[DEST_HASH_SIZE];
+  makeHash(dest, 7);
+  makeHash(via, 1001);
+  clock.now += 100;
+  makeTableAnnounce(&fresh, clock.now, 77, 1, via);
+  CHECK(restored.updateNextHop(dest, &fresh));
+
+  CHECK_EQ(restored.completeFromJournal(journal), 9);
+  for (int d = 0; d < 10; d++) {
+    makeHash(dest, d);
+    CHECK(restored.getOrigAnnounce(dest, &orig) != 0);
+    CHECK(tables.getOrigAnnounce(dest, &expected) != 0);
+    if (d == 7) {
+      CHECK_EQ(orig.hops, 1);
+      CHECK(memcmp(orig.payload, fresh.payload, fresh.payload_len) == 0);
+    } else {
+      CHECK_EQ(orig.payload_len, expected.payload_len);
+      CHECK(memcmp(orig.payload, expected.payload, expected.payload_len) == 0);
+    }
+  }
+
+  // so a compacted journal has them all in full
+  MemStream compacted;
+  restored.writeSnapshot(compacted);
+  SimpleMeshTables replayed(clock);
+  CHECK(replayed.replayJournal(compacted) > 0);
+  makeHash(dest, 3);
+  CHECK(replayed.getOrigAnnounce(dest, &orig) != 0);
+}
+
+int main() {
+  testRoundTrip();
+  testRebaseTimes();
+  testInvalid();
+  testCompleteFromJournal();
+  return testResult("test_tables_checkpoint");
+}
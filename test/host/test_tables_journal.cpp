@@ -0,0 +1,156 @@
+#include "test.h"
+#include "sim.h"
+#include <FS.h>
+#include <helpers/SimpleMeshTables.h>
+#include <unistd.h>
+
+/*
+ * SimpleMeshTables journal, through a file-backed stream (as SPIFFS is used on the device).
+*/
+using namespace ripple;
+
+struct TestClock : public RTCClock {
+  uint32_t now = 1715770351;
+  uint32_t getCurrentTime() override { return now; }
+  void setCurrentTime(uint32_t time) override { now = time; }
+};
+
+// a journal File, which counts flushes (ie. flash writes, on the device)
+struct CountingFile : public Stream {
+  File f;
+  int n_flushes = 0;
+
+  CountingFile(File file): f(file) { }
+  size_t write(uint8_t c) override { return f.write(c); }
+  size_t write(const uint8_t* buf, size_t len) override { return f.write(buf, len); }
+  void flush() override { f.flush(); n_flushes++; }
+  int available() override { return f.available(); }
+  int read() override { return f.read(); }
+};
+
+static void makeHash(uint8_t* hash, int n) {
+  for (int i = 0; i < DEST_HASH_SIZE; i++) hash[i] = (n * 37 + i * 11) & 0xFF;
+}
+
+static char root[] = "/tmp/ripple_jnl_XXXXXX";
+
+static void newJournal(fs::FS& fs, SimpleMeshTables& tables) {
+  File f = fs.open("/tables.jnl", "w");
+  tables.writeSnapshot(f);
+  f.close();
+}
+
+// per-packet records are batched into one flush, new paths are flushed straight away
+static void testFlushBatching() {
+  fs::FS fs(root);
+  TestClock clock;
+  SimpleMeshTables tables(clock);
+  newJournal(fs, tables);
+  CountingFile journal(fs.open("/tables.jnl", "a"));
+  tables.setJournal(&journal);
+
+  uint8_t hash[DEST_HASH_SIZE];
+  for (int i = 0; i < JOURNAL_FLUSH_RECORDS - 1; i++) {
+    makeHash(hash, 100 + i);
+    tables.setSeenPacketHash(hash, 1);
+  }
+  CHECK_EQ(journal.n_flushes, 0);
+  makeHash(hash, 99);
+  tables.setSeenPacketHash(hash, 2);
+  CHECK_EQ(journal.n_flushes, 1);
+
+  Packet pkt;
+  uint8_t dest[DEST_HASH_SIZE];
+  makeHash(dest, 1);
+  makeTableAnnounce(&pkt, clock.now, 1, 2);
+  CHECK(tables.updateNextHop(dest, &pkt));
+  CHECK_EQ(journal.n_flushes, 2);
+
+  makeHash(hash, 200);
+  tables.setSeenPacketHash(hash, 1);
+  tables.sweepExpired(1);
+  CHECK_EQ(journal.n_flushes, 2);
+  clock.now += JOURNAL_FLUSH_SECS;
+  tables.sweepExpired(1);   // flush is due
+  CHECK_EQ(journal.n_flushes, 3);
+
+  makeHash(hash, 201);
+  tables.setSeenPacketHash(hash, 1);
+  tables.setJournal(NULL);   // flushes
+  CHECK_EQ(journal.n_flushes, 4);
+  journal.f.close();
+
+  // and all of it replays from the file
+  SimpleMeshTables replayed(clock);
+  File f = fs.open("/tables.jnl");
+  CHECK_EQ(replayed.replayJournal(f), 1 + JOURNAL_FLUSH_RECORDS + 1 + 2);   // filters, seen, dest, seen
+  f.close();
+  CHECK(replayed.hasNextHop(dest));
+  makeHash(hash, 99);
+  CHECK_EQ(replayed.getSeenPacketHash(hash), 2);
+  makeHash(hash, 201);
+  CHECK_EQ(replayed.getSeenPacketHash(hash), 1);
+  makeHash(hash, 300);
+  CHECK_EQ(replayed.getSeenPacketHash(hash), 0);
+}
+
+// restored times are moved back when the clock has restarted (eg. VolatileRTCClock), but not when it has kept time
+static void testRebaseTimes() {
+  TestClock clock;
+  clock.now += 1000000;   // eg. set by an admin
+  SizedMeshTables<2> tables(clock);
+  MemStream journal;
+  tables.writeSnapshot(journal);
+  tables.setJournal(&journal);
+
+  Packet pkt;
+  uint8_t a[DEST_HASH_SIZE], b[DEST_HASH_SIZE], c[DEST_HASH_SIZE], seen[DEST_HASH_SIZE];
+  makeHash(a, 1); makeHash(b, 2); makeHash(c, 3); makeHash(seen, 4);
+  makeTableAnnounce(&pkt, clock.now, 1, 2);
+  CHECK(tables.updateNextHop(a, &pkt));
+  clock.now += 10;
+  makeTableAnnounce(&pkt, clock.now, 2, 2);
+  CHECK(tables.updateNextHop(b, &pkt));
+  tables.setSeenPacketHash(seen, 1);
+  uint32_t saved_at = clock.now;
+
+  TestClock restarted;   // back to its fixed start time
+  SizedMeshTables<2> replayed(restarted);
+  CHECK(replayed.replayJournal(journal) > 0);
+  CHECK(replayed.hasNextHop(a));
+  CHECK(replayed.hasNextHop(b));
+  CHECK_EQ(replayed.getSeenPacketHash(seen), 1);
+
+  restarted.now += KEEP_ALIVE_SECS + 1;
+  makeTableAnnounce(&pkt, restarted.now, 3, 2);
+  CHECK(replayed.updateNextHop(c, &pkt));   // can evict 'a', as it isn't in the future
+  CHECK(!replayed.hasNextHop(a));
+
+  restarted.now += PATH_EXPIRY_SECS - KEEP_ALIVE_SECS - 1;
+  CHECK(replayed.hasNextHop(b));
+  restarted.now += 1;
+  CHECK(!replayed.hasNextHop(b));   // path kept its age
+
+  // a clock which kept time while off (eg. ESP32RTCClock)
+  journal.pos = 0;
+  TestClock kept;
+  kept.now = saved_at + PATH_EXPIRY_SECS - 5;
+  SizedMeshTables<2> replayed2(kept);
+  CHECK(replayed2.replayJournal(journal) > 0);
+  CHECK(!replayed2.hasNextHop(a));
+  CHECK(replayed2.hasNextHop(b));
+}
+
+int main() {
+  if (!mkdtemp(root)) {
+    printf("unable to create %s\n", root);
+    return 1;
+  }
+  testFlushBatching();
+  testRebaseTimes();
+
+  fs::FS fs(root);
+  fs.remove("/tables.jnl");
+  rmdir(root);
+  return testResult("test_tables_journal");
+}
@@ -0,0 +1,27 @@
+#include "test.h"
+#include <Utils.h>
+
+using namespace ripple;
+
+int main() {
+  uint8_t secret[PUB_KEY_SIZE];
+  for (int i = 0; i < PUB_KEY_SIZE; i++) secret[i] = i * 7;
+
+  // decrypted length is padded up to whole blocks, so eg. simple_repeater's CMD_SET_CONFIG limit of
+  // two blocks (MAX_CONFIG_LEN) admits exactly the 'AB' + 30 chars that test_admin will send
+  const char* texts[] = { "AB", "AB2,1.5,3000", "AB0123456789ABCDE", "AB0123456789ABCDEF0123456789ABCD" };
+  int expect_len[] = { 16, 16, 32, 32 };
+  for (int t = 0; t < 4; t++) {
+    uint8_t enc[CIPHER_BLOCK_SIZE*2 + CIPHER_MAC_SIZE], dec[MAX_PACKET_PAYLOAD];
+    int enc_len = Utils::encryptThenMAC(secret, enc, (const uint8_t *) texts[t], strlen(texts[t]));
+    CHECK(enc_len <= (int) sizeof(enc));
+    int len = Utils::MACThenDecrypt(secret, dec, enc, enc_len);
+    CHECK_EQ(len, expect_len[t]);
+    CHECK(memcmp(dec, texts[t], strlen(texts[t])) == 0);
+    for (int i = strlen(texts[t]); i < len; i++) CHECK_EQ(dec[i], 0);    // zero padded, so still a C string
+
+    enc[enc_len - 1] ^= 1;   // tampered
+    CHECK_EQ(Utils::MACThenDecrypt(secret, dec, enc, enc_len), 0);
+  }
+  return testResult("test_utils_cipher");
+}